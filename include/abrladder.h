@@ -0,0 +1,52 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <thread>
+#include "queue.h"
+#include "ringbuffer.h"
+#include "ladderfilter.h"
+#include "videoencoder.h"
+
+// 一次解码、多档输出的码率阶梯：
+// 解码线程把帧送进 LadderFilter，缩放后的各档帧分别进入自己的 RingBuffer，
+// 每档一个编码线程，编码结果放入各自的输出队列。
+// 每个分支有独立的缓冲，慢的分支只在落后超过 branchDepth 帧时才会阻塞其他分支。
+class AbrLadder {
+public:
+    AbrLadder();
+    ~AbrLadder();
+
+    AbrLadder(const AbrLadder&) = delete;
+    AbrLadder& operator=(const AbrLadder&) = delete;
+
+    // 建立滤镜图、打开各档编码器并启动编码线程；timeBase 为输入帧 pts 的时间基（见 LadderFilter::init）
+    bool open(AVCodecContext* decCtx, const std::vector<LadderRung>& rungs, int fps,
+              size_t branchDepth = 60, AVRational timeBase = {0, 1});
+
+    // 解码线程调用，frame 由调用方释放
+    void pushFrame(AVFrame* frame);
+
+    // 输入结束：flush 滤镜，通知各分支结束并等待编码线程退出（各输出队列随后 stop）
+    void finish();
+
+    int rungCount() const { return (int)branches_.size(); }
+
+    // 第 i 档的编码输出
+    PacketQueue<AVPacket*>& output(int i) { return branches_[i]->packets; }
+    AVCodecContext* encoderContext(int i) const { return branches_[i]->encoder->getCodecContext(); }
+
+private:
+    struct Branch {
+        std::unique_ptr<VideoEncoder> encoder;
+        std::unique_ptr<RingBuffer<AVFrame*>> frames;
+        PacketQueue<AVPacket*> packets;
+        std::thread thread;
+        int64_t encodedFrames = 0;
+    };
+
+    void encodeLoop(Branch& branch, int index);
+
+    LadderFilter filter_;
+    std::vector<std::unique_ptr<Branch>> branches_;
+    bool finished_ = false;
+};
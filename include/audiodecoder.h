@@ -1,6 +1,7 @@
 #pragma once
 #include "queue.h"
 #include <functional>
+#include <string>
 extern "C" {
 #include <libswresample/swresample.h>
 #include <libavcodec/avcodec.h>
@@ -26,4 +27,5 @@ public:
 private:
     AVCodecContext* codecCtx_ = nullptr;
     AVCodecParameters* codecpar_ = nullptr;
+    std::string poolKey_;
 };
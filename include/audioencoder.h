@@ -1,5 +1,14 @@
 #pragma once
 #include "queue.h"
+#include "audioframeassembler.h"
+#include "encoderprofile.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 extern "C" {
 #include <libavcodec/avcodec.h>
 #include <libavutil/avutil.h>
@@ -11,18 +20,88 @@ public:
     AudioEncoder(AVCodecID codec_id = AV_CODEC_ID_AC3);
     ~AudioEncoder();
 
+    // fmt 为送入的采样格式，编码器不支持时改用编码器的第一个格式（以 getCodecContext()->sample_fmt 为准）
+    // profile 设置了码率时以 profile 为准
     bool open(int sample_rate, int channels, AVSampleFormat fmt, int bitrate = 192000);
+
+    // 编码参数（open 之前调用）：编码器、码率控制、线程和私有选项，视频相关的字段忽略
+    void setProfile(const EncoderProfile& profile);
+
+    // 并行模式（open 之前调用）：只对帧间没有依赖、每帧立即出包的编码器生效（PCM，
+    // 以及 48 / 32 kHz 等不需要帧填充的采样率下的 AC3、MP2），其余情况照常串行。
+    // 44.1 kHz 系列采样率下 AC3 / MP2 的帧长靠累计的填充位凑整，是跨帧的状态，不能拆开并行。
+    // 连续 batchFrames 帧为一批，分给 contexts 个编码器实例并行编码，
+    // 输出包按批次顺序（即 pts 顺序）送入队列。
+    // 变换编码器（AC3 的 MDCT 重叠、MP2 的滤波器组）带有上一帧的历史样本，
+    // 每批先送入前一批的最后一帧预热、丢掉它的包，输出与串行编码逐字节一致
+    void setParallel(int contexts, int batchFrames = 32) {
+        parallel_ = contexts;
+        batchFrames_ = batchFrames > 0 ? batchFrames : 1;
+    }
+
+    // 是否实际运行在并行模式
+    bool parallel() const { return !workers_.empty(); }
     void close();
 
+    // 预先打开 count 个相同参数的编码器放入上下文池
+    bool prewarm(int sample_rate, int channels, AVSampleFormat fmt, int bitrate, int count);
+
     // 将 AVFrame 编码成 AVPacket 并 push 到队列
+    // 输入帧可以是任意 nb_samples，内部按编码器的 frame_size 重新切帧
+    // （编码器支持可变帧长或 frame_size 为 0 时直接送入）；帧的采样格式需与编码器一致
     bool encode(AVFrame* frame, PacketQueue<AVPacket*>& pktQueue);
 
-    // flush 编码器
+    // flush 编码器：缓冲中不足一帧的样本补静音后送入
     void flush(PacketQueue<AVPacket*>& pktQueue);
 
     AVCodecContext* getCodecContext() const { return codecCtx_; }
 
 private:
+    std::string makePoolKey(int sample_rate, int channels, AVSampleFormat fmt, int bitrate) const;
+    AVCodecContext* createContext(int sample_rate, int channels, AVSampleFormat fmt, int bitrate);
+    bool sendFrame(AVFrame* frame, PacketQueue<AVPacket*>& pktQueue);
+
+    struct Batch {
+        int64_t index = 0;
+        AVFrame* prime = nullptr;          // 预热帧（前一批的最后一帧），第一批没有
+        std::vector<AVFrame*> frames;
+        std::vector<AVPacket*> packets;
+        bool done = false;
+        bool ok = true;
+    };
+
+    bool parallelSupported() const;
+    bool startParallel();
+    void stopParallel();
+    void queueFrame(AVFrame* frame, PacketQueue<AVPacket*>& pktQueue);   // 接管 frame
+    void submitBatch(PacketQueue<AVPacket*>& pktQueue);
+    // 按顺序输出已完成的批次；序号小于 waitBefore 的批次未完成时等待
+    void emitReady(PacketQueue<AVPacket*>& pktQueue, int64_t waitBefore);
+    void workerLoop(AVCodecContext* ctx);
+
     AVCodec* codec_ = nullptr;
     AVCodecContext* codecCtx_ = nullptr;
+    std::string poolKey_;
+    EncoderProfile profile_;
+    bool hasProfile_ = false;
+
+    AudioFrameAssembler assembler_;
+    bool passthrough_ = true;
+
+    // 并行模式
+    int parallel_ = 1;
+    int batchFrames_ = 32;
+    bool primeBatches_ = true;                  // PCM 没有历史样本，不需要预热
+    std::vector<AVCodecContext*> extraCtx_;     // 除 codecCtx_ 之外的实例
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable cond_;              // 工作线程：有新批次
+    std::condition_variable doneCond_;          // 调用方：批次完成
+    bool stop_ = false;
+    std::deque<Batch*> pending_;                // 等待编码的批次
+    std::map<int64_t, Batch*> inFlight_;        // 已提交、未输出的批次
+    Batch* current_ = nullptr;                  // 正在凑帧的批次
+    AVFrame* lastFrame_ = nullptr;              // 上一批的最后一帧，作为下一批的预热帧
+    int64_t nextBatch_ = 0;
+    int64_t nextEmit_ = 0;
 };
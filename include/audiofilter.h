@@ -1,6 +1,9 @@
 #pragma once
 #include <functional>
 #include <string>
+#include <map>
+#include <memory>
+#include "timestretch.h"
 extern "C" {
 #include <libavcodec/avcodec.h>
 #include <libavfilter/avfilter.h>
@@ -28,16 +31,40 @@ public:
               AVSampleFormat out_sample_fmt = AV_SAMPLE_FMT_S16,
               uint64_t out_channel_layout = 0);
 
+    // 使用内置的单级 WSOLA 变速（TimeStretch）替代 atempo 级联，需在 init 之前调用。
+    // 开启后滤镜图只做格式转换（转成 FLTP），变速在图外完成，再转换成期望的输出格式
+    void setUseNativeTimeStretch(bool on) { useNativeStretch_ = on; }
+
     // 对一帧音频做过滤，回调会被传入处理后的 AVFrame*（caller 负责 av_frame_free）
+    // 输入的采样率/采样格式/声道布局中途变化时，帧先经过为该配置建立的转换图（按配置缓存），
+    // 转回 init 时的输入格式后再进入主滤镜图，保证 atempo 的状态连续、不丢样本；
+    // 切换到其他配置前先排空当前转换图（重采样器缓存的样本），排空后的图下次切回时重建
     void filterFrame(AVFrame* frame, std::function<void(AVFrame*)> callback);
 
     // 释放/重置
     void close();
 
 private:
+    // 输入配置变化时使用的转换图：abuffer(新配置) -> aformat(主图输入配置) -> abuffersink
+    struct AdapterGraph {
+        AVFilterGraph* graph = nullptr;
+        AVFilterContext* src = nullptr;
+        AVFilterContext* sink = nullptr;
+    };
+
     bool build_atempo_chain(double speed, std::string &outChain);
     void print_av_error(int ret, const char* prefix);
 
+    void feedMain(AVFrame* frame, const std::function<void(AVFrame*)>& callback);
+    AdapterGraph* getAdapter(int sampleRate, int sampleFmt, uint64_t channelLayout);
+    void drainAdapter(const std::function<void(AVFrame*)>& callback);
+    bool buildConvertGraph(int srcRate, int srcFmt, uint64_t srcLayout,
+                           int dstRate, int dstFmt, uint64_t dstLayout, AdapterGraph& a);
+
+    void stretchFrame(AVFrame* frame, const std::function<void(AVFrame*)>& callback);
+    void emitStretched(const std::function<void(AVFrame*)>& callback);
+    void deliver(AVFrame* frame, const std::function<void(AVFrame*)>& callback);
+
 private:
     AVFilterGraph* graph_ = nullptr;
     AVFilterContext* srcCtx_ = nullptr;
@@ -48,5 +75,19 @@ private:
     uint64_t outChannelLayout_ = 0;
     int outSampleRate_ = 0;
 
+    // 主滤镜图的输入配置
+    int inSampleRate_ = 0;
+    AVSampleFormat inSampleFmt_ = AV_SAMPLE_FMT_NONE;
+    uint64_t inChannelLayout_ = 0;
+
+    std::map<std::string, AdapterGraph> adapters_;
+    AdapterGraph* activeAdapter_ = nullptr;
+
+    // 内置变速：主图输出 FLTP -> stretch_ -> tail_（FLTP 转期望输出格式，输出就是 FLTP 时不建）
+    bool useNativeStretch_ = false;
+    std::unique_ptr<TimeStretch> stretch_;
+    AdapterGraph tail_;
+    int64_t stretchPts_ = AV_NOPTS_VALUE;
+
     bool initialized_ = false;
 };
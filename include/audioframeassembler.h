@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+extern "C" {
+#include <libavutil/audio_fifo.h>
+#include <libavutil/frame.h>
+#include <libavutil/samplefmt.h>
+}
+
+// 把任意 nb_samples 的音频帧重新切成编码器要求的固定 frame_size：
+// 样本直接按原格式（平面/交错）存入 AVAudioFifo，不做格式往返；
+// 输出帧的 pts 以 1/sample_rate 为时间基按样本数连续递增
+class AudioFrameAssembler {
+public:
+    AudioFrameAssembler() = default;
+    ~AudioFrameAssembler();
+
+    AudioFrameAssembler(const AudioFrameAssembler&) = delete;
+    AudioFrameAssembler& operator=(const AudioFrameAssembler&) = delete;
+
+    bool init(AVSampleFormat fmt, int channels, uint64_t channelLayout, int sampleRate, int frameSize);
+    void reset();
+
+    // 写入一帧（格式和声道数需与 init 一致），第一帧的 pts 作为输出 pts 的起点
+    bool push(const AVFrame* frame);
+
+    // 取出一帧正好 frameSize 个样本的帧（caller 负责 av_frame_free），不够时返回 nullptr；
+    // padFinal 为 true 时不足一帧的剩余样本补静音凑成一帧
+    AVFrame* pop(bool padFinal = false);
+
+    // 缓冲中的样本数
+    int size() const { return fifo_ ? av_audio_fifo_size(fifo_) : 0; }
+
+    int frameSize() const { return frameSize_; }
+
+private:
+    AVAudioFifo* fifo_ = nullptr;
+    AVSampleFormat fmt_ = AV_SAMPLE_FMT_NONE;
+    int channels_ = 0;
+    uint64_t channelLayout_ = 0;
+    int sampleRate_ = 0;
+    int frameSize_ = 0;
+    int64_t nextPts_ = AV_NOPTS_VALUE;
+};
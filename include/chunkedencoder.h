@@ -0,0 +1,114 @@
+#pragma once
+#include "queue.h"
+#include "encoderprofile.h"
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/frame.h>
+}
+
+// 分段并行编码：单个 libx264 实例在 4K、较慢 preset 下达不到实时，
+// 把输入按关键帧 / 场景切换点切成若干段，每段由独立的 VideoEncoder 从 IDR 开始编码，
+// N 个工作线程同时编码不同的段，输出包按段的顺序拼回，pts 沿用输入帧；段首 dts 可能回退，由 Muxer 修正。
+// 帧边到边送给正在编码该段的线程，不等整段收齐；缓冲的帧数超过 workers * chunkFrames 时 encode 阻塞。
+class ChunkedEncoder {
+public:
+    // chunkFrames: 目标段长（帧），达到后在下一个关键帧（pict_type == I 或 key_frame）处切段，
+    // 一直没有关键帧时在 2 * chunkFrames 处强制切段
+    explicit ChunkedEncoder(int workers, int chunkFrames = 120, AVCodecID codec_id = AV_CODEC_ID_H264);
+    ~ChunkedEncoder();
+
+    ChunkedEncoder(const ChunkedEncoder&) = delete;
+    ChunkedEncoder& operator=(const ChunkedEncoder&) = delete;
+
+    // 各段编码器使用的参数（open 之前调用）；threads 为 0 时每段取 CPU 核数 / workers 个线程，
+    // 避免 N 个段各自按全部核数开线程互相争抢
+    void setProfile(const EncoderProfile& profile) { profile_ = profile; }
+    // 见 VideoEncoder::setSceneCutKeyframes（open 之前调用）：开启时各段按调用方标记的切换点插入 IDR，
+    // 段内 GOP 最长 maxGop；关闭时段首之外的关键帧由编码器自己决定（保留 x264 的场景检测）
+    void setSceneCutKeyframes(bool on) { sceneCut_ = on; }
+    // 见 VideoEncoder::setRoiEncoding（open 之前调用）
+    void setRoiEncoding(bool on) { roi_ = on; }
+    // 见 VideoEncoder::setGlobalHeader（open 之前调用）
+    void setGlobalHeader(bool on) { globalHeader_ = on; }
+
+    // 参数与 VideoEncoder::open 相同；maxGop 为开启场景切换关键帧时段内最长的 GOP
+    bool open(int width, int height, AVRational time_base, AVPixelFormat pix_fmt, int fps, int maxGop = 250);
+
+    // 送入一帧（内部增加引用，调用方仍负责释放），已完成的段的包按顺序 push 到 pktQueue
+    bool encode(AVFrame* frame, PacketQueue<AVPacket*>& pktQueue);
+
+    // 结束最后一段，等待所有段编码完成并输出剩余的包
+    void flush(PacketQueue<AVPacket*>& pktQueue);
+
+    void close();
+
+    // 编码器参数（extradata 等），供封装器使用；各段参数相同
+    const AVCodecParameters* codecParameters() const { return codecpar_; }
+
+    int chunkCount() const { return nextIndex_; }
+
+    // 各段编码耗时之和 / 墙钟时间，即平均同时在编码的段数。
+    // 并发时每段自身也变慢，这个值不是相对单个编码器的加速比，加速比需要另外跑单编码器对比
+    double concurrency() const;
+    void printStats() const;
+
+private:
+    struct Chunk {
+        int index = 0;
+        std::deque<AVFrame*> frames;   // 待编码的帧
+        bool closed = false;           // 不会再有新帧
+        bool done = false;
+        std::vector<AVPacket*> packets;
+        double encodeMs = 0.0;
+    };
+
+    void workerLoop();
+    void encodeChunk(const std::shared_ptr<Chunk>& c);
+    void startChunk();
+    void closeChunk();
+    void emitReady(PacketQueue<AVPacket*>& pktQueue);
+    EncoderProfile chunkProfile() const;
+
+    AVCodecID codecId_;
+    int workers_;
+    int chunkFrames_;
+
+    int width_ = 0;
+    int height_ = 0;
+    AVRational timeBase_ = {1, 25};
+    AVPixelFormat pixFmt_ = AV_PIX_FMT_NONE;
+    int fps_ = 25;
+    int maxGop_ = 250;
+    bool sceneCut_ = false;
+    bool roi_ = false;
+    bool globalHeader_ = false;
+    EncoderProfile profile_ = EncoderProfile::defaults();
+    AVCodecParameters* codecpar_ = nullptr;
+
+    std::vector<std::thread> threads_;
+    std::mutex mutex_;
+    std::condition_variable cond_;       // 工作线程：有新段 / 新帧
+    std::condition_variable spaceCond_;  // encode：缓冲有空位 / 段完成
+    bool stop_ = false;
+
+    std::deque<std::shared_ptr<Chunk>> waiting_;          // 还没有线程接手的段
+    std::map<int, std::shared_ptr<Chunk>> inFlight_;      // 未输出的段，按序号
+    std::shared_ptr<Chunk> current_;                      // 正在接收帧的段
+    int currentFrames_ = 0;
+    int nextIndex_ = 0;
+    int nextEmit_ = 0;
+    int buffered_ = 0;
+    bool failed_ = false;
+
+    std::chrono::steady_clock::time_point start_;
+    double wallMs_ = 0.0;
+    double encodeMs_ = 0.0;
+};
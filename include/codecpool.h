@@ -0,0 +1,58 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+#include <functional>
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+// 进程级编解码器上下文池：
+// 短片段批量转码时，每个任务都重新 avcodec_open2 的开销（尤其是 libx264 初始化）占比很高。
+// 上下文按 key（编解码器 + 参数）缓存，任务结束后归还，下一个任务直接复用已打开的实例。
+class CodecPool {
+public:
+    using Factory = std::function<AVCodecContext*()>;
+
+    static CodecPool& instance();
+
+    // 取出一个已打开的上下文，池中没有时调用 create 新建（create 失败返回 nullptr）
+    AVCodecContext* acquire(const std::string& key, const Factory& create);
+
+    // 归还上下文：
+    // 解码器 avcodec_flush_buffers 后放回池中；
+    // 编码器只有支持 AV_CODEC_CAP_ENCODER_FLUSH 时才能 flush 复用，否则直接释放
+    void release(const std::string& key, AVCodecContext* ctx);
+
+    // 预先打开 count 个实例，供下一个任务直接取用
+    void prewarm(const std::string& key, const Factory& create, int count);
+    // 池中该 key 的空闲实例不足 count 个时补足（重复调用不会越补越多）
+    void ensureIdle(const std::string& key, const Factory& create, int count);
+
+    // 每个 key 最多保留的空闲实例数
+    void setMaxIdlePerKey(int n);
+
+    // 释放所有空闲实例
+    void clear();
+
+    // 解码器的 key：codec_id + 基本参数 + extradata 摘要
+    static std::string decoderKey(const AVCodecParameters* par);
+
+    uint64_t hits() const { return hits_; }
+    uint64_t misses() const { return misses_; }
+
+private:
+    CodecPool() = default;
+    ~CodecPool();
+    CodecPool(const CodecPool&) = delete;
+    CodecPool& operator=(const CodecPool&) = delete;
+
+    std::mutex mutex_;
+    std::unordered_map<std::string, std::vector<AVCodecContext*>> idle_;
+    int maxIdlePerKey_ = 4;
+
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+};
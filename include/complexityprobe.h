@@ -0,0 +1,66 @@
+#pragma once
+#include "encoderprofile.h"
+#include "ladderfilter.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+extern "C" {
+#include <libavutil/rational.h>
+}
+
+// 一个采样段的试编码结果
+struct ComplexitySegment {
+    double start = 0.0;        // 请求的起点（秒），实际从之前最近的关键帧开始
+    int frames = 0;            // 实际编码的帧数
+    int64_t bytes = 0;
+    double kbps = 0.0;         // 探测分辨率下的码率
+    double bitsPerPixel = 0.0; // 每像素每帧的比特数
+    double encodeMs = 0.0;     // 解码 + 缩放 + 编码耗时
+};
+
+// 按片源复杂度定码率（per-title）：不做整片试编码，而是在片中均匀取几段（每段几秒），
+// 每段用独立的 Demuxer seek 过去，解码、缩小到探测分辨率、用快 preset 的 CRF 编码，
+// 各段在共享线程池上并行。CRF 下的码率就是这段内容在该画质下需要的码率，
+// 取各段的高分位作为整片的复杂度，再按像素数换算出各档码率（见 deriveLadder）。
+class ComplexityProbe {
+public:
+    // segments: 采样段数；segmentSeconds: 每段时长；maxProbeHeight: 探测分辨率的高度上限
+    explicit ComplexityProbe(int segments = 6, double segmentSeconds = 2.0, int maxProbeHeight = 540);
+
+    // 试编码的参数（run 之前调用），默认 veryfast、CRF 23；线程数按并行的段数分配
+    void setProfile(const EncoderProfile& profile) { profile_ = profile; }
+
+    bool run(const std::string& filename);
+
+    const std::vector<ComplexitySegment>& segments() const { return segments_; }
+    int probeWidth() const { return probeW_; }
+    int probeHeight() const { return probeH_; }
+
+    // 整片复杂度：各段 bitsPerPixel 的 75 分位（复杂的段决定观感），没有结果时为 0
+    double titleBitsPerPixel() const;
+    // 探测分辨率下整片需要的码率（kbps）
+    double titleKbps() const;
+
+    // 按复杂度给固定阶梯的各档定码率：码率随像素数的 0.75 次方变化（小分辨率每像素需要的比特更多），
+    // 不超过固定阶梯的码率、也不低于它的 floorRatio 倍；width / height <= 0 的档按片源宽高比换算
+    std::vector<LadderRung> deriveLadder(const std::vector<LadderRung>& fixedLadder,
+                                         double floorRatio = 0.25) const;
+
+    void printStats() const;
+
+private:
+    bool probeSegment(const std::string& filename, ComplexitySegment& seg);
+
+    int segmentCount_;
+    double segmentSeconds_;
+    int maxProbeHeight_;
+    EncoderProfile profile_;
+
+    int srcW_ = 0;
+    int srcH_ = 0;
+    int probeW_ = 0;
+    int probeH_ = 0;
+    AVRational fps_ = {25, 1};
+    double wallMs_ = 0.0;
+    std::vector<ComplexitySegment> segments_;
+};
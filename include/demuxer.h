@@ -21,9 +21,24 @@ public:
     
     AVCodecParameters* getAudioCodecParameters() const;
     AVCodecParameters* getVideoCodecParameters() const;
+
+    // 包的 pts / dts 实际使用的时间基（open 里改写视频流 time_base 之前的值）
+    AVRational getAudioTimeBase() const;
+    AVRational getVideoTimeBase() const { return videoTimeBase_; }
+
+    // 时长（秒），未知时返回 0
+    double duration() const;
+    // 视频流帧率（容器没有写时按时间戳猜测），没有视频流时返回 {0, 1}
+    AVRational videoFrameRate() const;
+
+    // 跳到 seconds 之前最近的关键帧，之后 start / readVideoPacket 从那里开始读
+    bool seek(double seconds);
+    // 读下一个视频包（跳过其他流），结束或出错时返回 nullptr；caller 负责 av_packet_free
+    AVPacket* readVideoPacket();
 private:
     std::string filename_;
     AVFormatContext* fmtCtx_ = nullptr;
     int audioStreamIndex_ = -1;
     int videoStreamIndex_ = -1;
+    AVRational videoTimeBase_ = {1, 24};
 };
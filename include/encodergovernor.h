@@ -0,0 +1,67 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <functional>
+#include <cstdint>
+
+// 编码速度调节器：直播 / 准直播任务要在保持实时的前提下用机器当前能承受的最好画质。
+// VideoEncoder 每编一帧报告耗时，在 GOP 边界询问下一个 GOP 用哪个 preset：
+// 编码能力（1000 / 平均每帧毫秒）低于目标帧率、或输入缓冲堆积时换快一档，
+// 连续两个 GOP 都有充足余量且缓冲基本为空时换慢一档（画质更好）。
+// 切换由 VideoEncoder 完成（flush 当前实例，换用上下文池中预先打开的实例，新 GOP 从 IDR 开始），
+// 每次切换都打印并记录。
+class EncoderGovernor {
+public:
+    struct Switch {
+        int64_t frame = 0;          // 切换后第一帧的序号
+        std::string from;
+        std::string to;
+        double encodeFps = 0.0;     // 切换前一个 GOP 的编码能力
+        double queueFill = 0.0;     // 切换时输入缓冲的占用比例
+    };
+
+    // presets 从快到慢排列，startPreset 不在其中时从中间一档开始
+    explicit EncoderGovernor(double targetFps, const std::string& startPreset = "fast",
+                             const std::vector<std::string>& presets = {"ultrafast", "superfast", "veryfast",
+                                                                        "faster", "fast", "medium", "slow"});
+
+    // 输入缓冲占用比例（0..1），例如编码线程前的 RingBuffer：size() / capacity()
+    void setQueueProbe(std::function<double()> probe) { queueProbe_ = std::move(probe); }
+
+    // 余量阈值：能力低于 target * (1 + lowMargin) 时加速，高于 target * (1 + highMargin) 时减速
+    void setMargins(double lowMargin, double highMargin) {
+        lowMargin_ = lowMargin;
+        highMargin_ = highMargin;
+    }
+
+    // 每帧编码耗时（毫秒）
+    void addSample(double encodeMs);
+
+    // GOP 边界调用，返回下一个 GOP 使用的 preset；frameIndex 为下一帧序号，只用于记录
+    const std::string& decide(int64_t frameIndex);
+
+    const std::string& preset() const { return presets_[index_]; }
+
+    // 与当前 preset 相邻的两档（用于预先打开），没有时为空串
+    std::string fasterPreset() const { return index_ > 0 ? presets_[index_ - 1] : std::string(); }
+    std::string slowerPreset() const { return index_ + 1 < (int)presets_.size() ? presets_[index_ + 1] : std::string(); }
+
+    const std::vector<Switch>& switches() const { return switches_; }
+    void printStats() const;
+
+private:
+    double targetFps_;
+    std::vector<std::string> presets_;
+    int index_ = 0;
+
+    double lowMargin_ = 0.05;
+    double highMargin_ = 0.6;
+    std::function<double()> queueProbe_;
+
+    // 当前 GOP 的统计
+    double windowMs_ = 0.0;
+    int windowFrames_ = 0;
+    int calmGops_ = 0;   // 连续有余量的 GOP 数
+
+    std::vector<Switch> switches_;
+};
@@ -0,0 +1,67 @@
+#pragma once
+#include <string>
+#include <map>
+#include <cstdint>
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+// 编码参数描述，VideoEncoder / AudioEncoder 都接受：
+// 编码器、preset / tune、码率控制、GOP、线程、lookahead，以及原样传给编码器的私有选项。
+// 内置 throughput（吞吐优先）、latency（低延迟）、live（直播链路）、archive（存档画质）四种，
+// 也可以用字符串描述（见 parse），任务间切换速度 / 画质取舍不需要重新编译。
+struct EncoderProfile {
+    enum RateControl {
+        RC_CRF = 0,   // 恒定质量（quality 为 crf），maxBitrate > 0 时为限峰值的 CRF
+        RC_CQP,       // 恒定量化（quality 为 qp）
+        RC_ABR,       // 平均码率
+        RC_CBR,       // 恒定码率（maxrate = bitrate，带 VBV）
+    };
+
+    std::string name = "default";
+    std::string codec;            // 编码器名（如 "libx264"、"aac"），空表示按 codec_id 查找
+    std::string preset;
+    std::string tune;
+    RateControl rateControl = RC_CRF;
+    double quality = -1;          // crf / qp，< 0 时用编码器默认值
+    int64_t bitrate = 0;          // ABR / CBR 的目标码率（bps）；音频为码率
+    int64_t maxBitrate = 0;
+    int64_t bufferSize = 0;       // VBV 缓冲（bit），0 时取 maxBitrate（CBR 取 bitrate）
+    double bufferFrames = 0;      // bufferSize 为 0 且此值 > 0 时，VBV 缓冲按打开时的实际帧率取这么多帧的码率
+    int gop = 12;
+    int bFrames = 2;
+    int threads = 0;              // 0 表示编码器自动选择
+    int lookahead = -1;           // rc-lookahead 帧数，< 0 时用 preset 的默认值
+    int passes = 1;               // 2 表示两遍编码（见 TwoPassEncoder），码率控制应为 ABR
+    std::map<std::string, std::string> options;   // 私有选项，av_opt_set 原样设置
+
+    // 与原来 VideoEncoder 写死的参数一致：libx264，preset fast，GOP 12，2 个 B 帧
+    static EncoderProfile defaults();
+    // 吞吐优先：批量转码，快 preset，长 GOP
+    static EncoderProfile throughput();
+    // 低延迟：无 B 帧、无 lookahead，zerolatency（slice 线程），短 GOP
+    static EncoderProfile latency();
+    // 直播链路：在 latency 的基础上用周期性帧内刷新代替 IDR（码率没有 I 帧尖峰），
+    // CBR + 约一帧的 VBV 缓冲，slice 线程（不引入帧级线程的延迟）
+    static EncoderProfile live();
+    // 存档：慢 preset、低 crf、长 lookahead
+    static EncoderProfile archive();
+
+    // 按名称取内置 profile（"default" / "throughput" / "latency" / "live" / "archive"）
+    static bool byName(const std::string& name, EncoderProfile& out);
+
+    // 字符串描述："<内置名>[:key=value...]"，例如 "archive:crf=20:preset=slower:aq-mode=3"
+    // 认识的 key：codec preset tune crf qp b cbr maxrate bufsize g bf threads lookahead passes，
+    // 其余 key 作为私有选项。数值不是完整的数字或超出范围时打印原因并返回 false
+    static bool parse(const std::string& spec, EncoderProfile& out);
+
+    // 打开编码器前设置到 ctx 上；编码器不支持的选项只打印警告
+    void applyTo(AVCodecContext* ctx) const;
+
+    // 参数摘要，用作上下文池 key 的一部分
+    std::string key() const;
+
+private:
+    // 码率 rate 对应的 VBV 缓冲大小（见 bufferSize / bufferFrames），帧率取 ctx->framerate
+    int64_t vbvSize(const AVCodecContext* ctx, int64_t rate) const;
+};
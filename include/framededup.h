@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+extern "C" {
+#include <libavutil/frame.h>
+#include <libavutil/pixelutils.h>
+}
+
+struct DedupStats {
+    int64_t frames = 0;          // 输入帧数
+    int64_t dropped = 0;         // 判为重复丢弃的帧数
+    int64_t longestRun = 0;      // 最长的连续重复帧数
+    double analyzeMs = 0.0;      // 比较本身花费的时间
+};
+
+// 重复帧剔除，放在 VideoDecoder 之后：每帧和上一个保留帧比较，重复的直接丢掉，
+// 后面的滤镜 / 编码都不用再处理它。保留帧的 pts 不变，输出自然成为可变帧率。
+// 比较只取 8x8 块网格中的一部分（每 gridStep x gridStep 个块取一个，av_pixelutils 算 SAD），
+// 取样位置每帧轮换，持续存在的局部变化（如鼠标指针）最多 gridStep^2 帧内就会被发现；
+// 任何一个取样块的平均差超过阈值即视为不同帧。
+class FrameDedup {
+public:
+    // threshold: 块内每像素平均绝对差的上限（0 表示只有完全相同才算重复）
+    // maxDropRun: 连续丢弃的上限，达到后强制保留一帧（0 表示不限制）
+    explicit FrameDedup(double threshold = 1.0, int gridStep = 2, int maxDropRun = 0);
+    ~FrameDedup();
+
+    FrameDedup(const FrameDedup&) = delete;
+    FrameDedup& operator=(const FrameDedup&) = delete;
+
+    // 返回 true 表示与上一个保留帧重复，调用方应丢弃；否则该帧成为新的参考
+    bool isDuplicate(const AVFrame* frame);
+
+    const DedupStats& stats() const { return stats_; }
+
+    // 按保留帧在下游（滤镜 + 编码）的平均耗时估算节省的时间，已扣除比较本身的开销
+    double savedMs(double downstreamMsPerFrame) const;
+    void printStats(double downstreamMsPerFrame) const;
+
+    void reset();
+
+private:
+    bool compare(const AVFrame* a, const AVFrame* b);
+
+    double threshold_;
+    int gridStep_;
+    int maxDropRun_;
+
+    av_pixelutils_sad_fn sad8_ = nullptr;
+    AVFrame* ref_ = nullptr;     // 上一个保留帧（引用，不拷贝像素）
+    int64_t run_ = 0;            // 当前连续丢弃的帧数
+    int phase_ = 0;              // 取样网格的偏移，每帧轮换
+
+    DedupStats stats_;
+};
@@ -0,0 +1,88 @@
+#pragma once
+#include "rawframewriter.h"
+#include <string>
+#include <deque>
+#include <vector>
+#include <cstdint>
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/frame.h>
+}
+
+// 帧缓存：两遍编码时第一遍处理过的帧存起来给第二遍用，第二遍不用再解码 / 过滤。
+// 内存预算以内直接持有帧的引用（不拷贝），超出部分按顺序写到磁盘文件：
+// SPILL_RAW 原样写平面（后台线程写盘），SPILL_FFV1 先用 FFV1 无损压缩（体积约为原始的 1/2 ~ 1/3）。
+// 写满磁盘预算时 push 失败。读取顺序与写入顺序相同：先内存中的帧，再磁盘上的帧。
+class FrameSpillCache {
+public:
+    enum Mode {
+        SPILL_RAW = 0,
+        SPILL_FFV1,
+    };
+
+    FrameSpillCache() = default;
+    ~FrameSpillCache();
+
+    FrameSpillCache(const FrameSpillCache&) = delete;
+    FrameSpillCache& operator=(const FrameSpillCache&) = delete;
+
+    // spillPath: 溢出文件（close 时删除）；memoryBudget / diskBudget 为字节数，diskBudget = 0 表示不落盘
+    bool open(const std::string& spillPath, size_t memoryBudget, uint64_t diskBudget, Mode mode = SPILL_RAW);
+
+    // 存一帧（保留 pts、duration、pict_type、ROI 等属性）
+    bool push(const AVFrame* frame);
+
+    // 写入结束，从头开始读
+    bool rewind();
+
+    // 按写入顺序取下一帧（caller 负责 av_frame_free），读完返回 nullptr；
+    // 取出的帧不再留在缓存中，只能顺序读一遍
+    AVFrame* pop();
+
+    void close();
+
+    int64_t frameCount() const { return frames_; }
+    int64_t spilledFrames() const { return (int64_t)index_.size(); }
+    size_t memoryBytes() const { return memBytes_; }
+    uint64_t diskBytes() const { return diskBytes_; }
+
+private:
+    // 磁盘上每帧的记录
+    struct Entry {
+        int64_t pts = AV_NOPTS_VALUE;
+        int64_t duration = 0;
+        int pictType = 0;
+        int width = 0;
+        int height = 0;
+        int format = -1;
+        int colorRange = 0;
+        AVRational sar = {0, 1};
+        size_t size = 0;          // 文件中占用的字节数
+        bool compressed = false;  // FFV1 数据包；输入格式中途变化（FFV1 实例不匹配）的帧按原始数据写
+        std::vector<uint8_t> roi; // AV_FRAME_DATA_REGIONS_OF_INTEREST 原样保存
+    };
+
+    bool openCodec(const AVFrame* frame);
+    AVFrame* readRaw(const Entry& e);
+    AVFrame* readFfv1(const Entry& e);
+    bool readFully(uint8_t* dst, size_t size);
+
+    std::string path_;
+    size_t memBudget_ = 0;
+    uint64_t diskBudget_ = 0;
+    Mode mode_ = SPILL_RAW;
+
+    std::deque<AVFrame*> memory_;
+    std::vector<Entry> index_;
+    size_t readPos_ = 0;
+    RawFrameWriter writer_;
+    int readFd_ = -1;
+
+    AVCodecContext* enc_ = nullptr;    // SPILL_FFV1
+    AVCodecContext* dec_ = nullptr;
+    AVPacket* pkt_ = nullptr;
+
+    int64_t frames_ = 0;
+    size_t memBytes_ = 0;
+    uint64_t diskBytes_ = 0;
+};
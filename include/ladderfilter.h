@@ -0,0 +1,48 @@
+#pragma once
+#include <functional>
+#include <vector>
+#include <cstdint>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavfilter/avfilter.h>
+#include <libavfilter/buffersink.h>
+#include <libavfilter/buffersrc.h>
+#include <libavutil/avutil.h>
+#include <libavutil/frame.h>
+}
+
+// 码率阶梯中的一档
+struct LadderRung {
+    int width = -2;     // -2: 按源宽高比计算（保证为偶数）
+    int height = 0;
+    int64_t bitrate = 0; // 该档的码率上限（bps，见 ComplexityProbe::deriveLadder），0 表示按编码器默认
+};
+
+// 一进多出的缩放滤镜图：buffer -> split=N -> scale_i -> buffersink_i
+// 源只解码一次，各档分辨率从同一帧缩放得到
+class LadderFilter {
+public:
+    LadderFilter();
+    ~LadderFilter();
+
+    LadderFilter(const LadderFilter&) = delete;
+    LadderFilter& operator=(const LadderFilter&) = delete;
+
+    // timeBase: 输入帧 pts 的时间基，num 为 0 时取 decCtx->time_base
+    bool init(AVCodecContext* decCtx, const std::vector<LadderRung>& rungs, AVRational timeBase = {0, 1});
+
+    // 输入 frame（nullptr 表示 flush），回调参数为分支序号和该分支输出的帧
+    void filterFrame(AVFrame* frame, std::function<void(int, AVFrame*)> callback);
+
+    int rungCount() const { return (int)sinkCtxs_.size(); }
+    int outputWidth(int i) const { return av_buffersink_get_w(sinkCtxs_[i]); }
+    int outputHeight(int i) const { return av_buffersink_get_h(sinkCtxs_[i]); }
+    AVRational outputTimeBase(int i) const { return av_buffersink_get_time_base(sinkCtxs_[i]); }
+    AVPixelFormat outputPixFmt(int i) const { return (AVPixelFormat)av_buffersink_get_format(sinkCtxs_[i]); }
+
+private:
+    AVFilterGraph* filterGraph_ = nullptr;
+    AVFilterContext* buffersrcCtx_ = nullptr;
+    std::vector<AVFilterContext*> sinkCtxs_;
+};
@@ -0,0 +1,38 @@
+#pragma once
+#include <map>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+
+// 端到端延迟测量：信号源产生一帧时按 pts 记下墙钟时间（capture），
+// 之后各阶段看到同一 pts 时记一次（mark），得到该帧从“采集”到这一阶段的延迟。
+// DISPLAYED 为本地解码器解出该帧的时刻，即 glass-to-glass 延迟（不含显示器本身的刷新）。
+// 各线程都可以调用。
+class LatencyProbe {
+public:
+    enum Stage {
+        STAGE_ENCODED = 0,   // 编码器输出该帧的包
+        STAGE_SENT,          // 包已写出（封装器 / 网络）
+        STAGE_DISPLAYED,     // 接收端解码出该帧
+        STAGE_COUNT
+    };
+
+    void capture(int64_t pts);
+    void mark(int64_t pts, Stage stage);
+
+    // 采集了但在 DISPLAYED 之前被丢弃（环形缓冲满、实时模式丢帧）的帧数
+    int64_t lost() const;
+
+    // 某阶段延迟的百分位（毫秒），没有样本时返回 -1
+    double percentile(Stage stage, double p) const;
+    double mean(Stage stage) const;
+    void printStats() const;
+
+private:
+    static int64_t nowUs();
+
+    mutable std::mutex mutex_;
+    std::map<int64_t, int64_t> captured_;            // pts -> 采集时刻（微秒）
+    std::vector<int64_t> samples_[STAGE_COUNT];      // 延迟（微秒）
+    int64_t captures_ = 0;
+};
@@ -0,0 +1,76 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+extern "C" {
+#include <libavutil/frame.h>
+#include <libavutil/motion_vector.h>
+}
+
+// 单帧运动统计（来自解码器导出的 AV_FRAME_DATA_MOTION_VECTORS）
+struct MotionSummary {
+    int64_t pts = AV_NOPTS_VALUE;
+    bool hasVectors = false;      // I 帧没有运动矢量
+    int vectorCount = 0;
+    double meanMagnitude = 0.0;   // 按块面积加权的平均运动幅度（像素）
+    double maxMagnitude = 0.0;
+    double staticRatio = 1.0;     // 运动幅度低于阈值的块面积占比
+    double globalDx = 0.0;        // 全局运动（运动矢量中位数），近似镜头平移
+    double globalDy = 0.0;
+};
+
+// 连续静止片段
+struct StaticSegment {
+    int64_t startPts = AV_NOPTS_VALUE;
+    int64_t endPts = AV_NOPTS_VALUE;
+    int frames = 0;
+};
+
+// 运动分析：不做像素级分析，直接汇总解码器顺带导出的运动矢量，
+// 用于挑选缩略图、检测静止片段、为编码参数提供参考
+class MotionAnalyzer {
+public:
+    // staticThreshold: 块运动幅度低于该值（像素）视为静止
+    // staticFrameRatio: 静止块面积占比达到该值的帧视为静止帧
+    // minStaticFrames: 连续静止帧数达到该值才记为静止片段
+    MotionAnalyzer(double staticThreshold = 0.5, double staticFrameRatio = 0.95,
+                   int minStaticFrames = 24);
+
+    // 分析一帧（frame 需来自开启了 export_mvs 的解码器）
+    MotionSummary analyze(const AVFrame* frame);
+
+    // 输入结束，收尾未关闭的静止片段
+    void finish();
+
+    const std::vector<StaticSegment>& staticSegments() const { return segments_; }
+
+    // 推荐的缩略图：运动最小的帧的 pts（跳过开头 skipFrames 帧，避免片头黑场）
+    int64_t thumbnailPts() const { return thumbPts_; }
+
+    // 全片平均运动幅度，可用于选择编码参数（运动越大越需要码率）
+    double averageMagnitude() const;
+
+    void setThumbnailSkipFrames(int n) { thumbSkipFrames_ = n; }
+
+    // 打印缩略图候选、静止片段和平均运动幅度，pts 按 timeBase 换算成秒
+    void printStats(AVRational timeBase) const;
+
+private:
+    void updateStaticSegment(const MotionSummary& s);
+
+    double staticThreshold_;
+    double staticFrameRatio_;
+    int minStaticFrames_;
+
+    std::vector<StaticSegment> segments_;
+    StaticSegment current_;
+
+    int thumbSkipFrames_ = 24;
+    int64_t thumbPts_ = AV_NOPTS_VALUE;
+    double thumbMagnitude_ = 0.0;
+
+    int64_t frames_ = 0;
+    int64_t motionFrames_ = 0;
+    double magnitudeSum_ = 0.0;
+
+    std::vector<double> dxs_, dys_;   // 复用的中位数缓冲
+};
@@ -0,0 +1,125 @@
+#pragma once
+#include "queue.h"
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <cstdint>
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+}
+
+// 分片 MP4 输出中写完的一段：初始化段或一个分片（moof + mdat）
+struct MuxerFragment {
+    int index = 0;          // 0 为初始化段（ftyp + moov），分片从 1 开始编号
+    int64_t offset = 0;     // 在输出文件中的字节偏移
+    int64_t size = 0;
+    double startTime = 0.0; // 分片覆盖的解码时间范围（秒，按输入包的 dts），初始化段为 0
+    double endTime = 0.0;
+};
+
+// 封装输出：每路流从自己的包队列读（编码线程只管 push，不碰文件 I/O），
+// 独立的写线程按 dts 交错多路流，时间戳从编码器的时间基换算到输出流的时间基，
+// 用 av_interleaved_write_frame 写出。
+// 交错窗口有上限：某一路暂时没有包（编码慢、音频空隙）时，其他路最多领先窗口长度，
+// 之后不再等它，写线程缓存的包和 libavformat 内部的交错缓冲都不会无限增长。
+class Muxer {
+public:
+    // format 为空时按文件名推断（"mp4"、"mpegts" 等）
+    explicit Muxer(const std::string& filename, const std::string& format = "");
+    ~Muxer();
+
+    Muxer(const Muxer&) = delete;
+    Muxer& operator=(const Muxer&) = delete;
+
+    // 添加一路输出流（start 之前调用）：队列中的包时间基为 packetTimeBase，返回流序号，失败返回 -1。
+    // 生产者写完后 stop 队列（或 push nullptr），写线程取空后认为这一路结束
+    int addStream(const AVCodecParameters* par, AVRational packetTimeBase, PacketQueue<AVPacket*>& queue);
+    // 参数和时间基直接取自已打开的编码器
+    int addStream(const AVCodecContext* encCtx, PacketQueue<AVPacket*>& queue);
+
+    // 交错窗口（秒），默认 1 秒
+    void setInterleaveWindow(double seconds) { windowUs_ = (int64_t)(seconds * AV_TIME_BASE); }
+    // 传给 avformat_write_header 的封装器选项（start 之前调用），如 movflags
+    void setOption(const std::string& key, const std::string& value) { options_[key] = value; }
+
+    using FragmentCallback = std::function<void(const MuxerFragment&)>;
+    // 分片 MP4 / CMAF 输出（addStream 之前调用，只支持 mp4 / mov）：文件头只有空的 moov，
+    // 之后每个分片在视频关键帧处切开，写完、刷到文件后立即回调（在写线程上调用，回调里不要做耗时操作），
+    // 下游可以边转码边上传 [offset, offset + size)。fragmentSeconds > 0 时分片至少这么长；
+    // 没有视频流时按 fragmentSeconds（默认 2 秒）切分。
+    // 空 moov 里要有编码器参数集：视频编码器需打开全局头（见 globalHeader()），extradata 为空的视频流会被拒绝
+    void setFragmented(FragmentCallback callback, double fragmentSeconds = 0.0);
+
+    // 封装格式要求编码器参数放在 extradata 里（AVFMT_GLOBALHEADER，如 mp4 / mov）
+    bool globalHeader() const { return fmtCtx_ && (fmtCtx_->oformat->flags & AVFMT_GLOBALHEADER); }
+
+    // 打开输出、写文件头并启动写线程
+    bool start();
+    // 等所有输入队列结束、包全部写出后写文件尾并关闭输出；返回整个过程是否没有出错
+    bool finish();
+
+    int streamCount() const { return (int)streams_.size(); }
+    void printStats() const;
+
+private:
+    struct Stream {
+        AVStream* st = nullptr;
+        int index = -1;
+        AVMediaType type = AVMEDIA_TYPE_UNKNOWN;
+        PacketQueue<AVPacket*>* queue = nullptr;
+        AVRational srcTb = {1, 1};
+        std::deque<AVPacket*> pending;     // 已取出、等待交错的包
+        bool ended = false;
+        int64_t lastDts = AV_NOPTS_VALUE;
+        int64_t packets = 0;
+        int64_t bytes = 0;
+    };
+
+    void run();
+    // 从队列取包放入 pending：最多等 waitMs 毫秒等到第一个，之后只取已经到达的
+    void pull(Stream& s, int waitMs);
+    // 包的交错时间（微秒）：dts，没有 dts 时用 pts，都没有时为 INT64_MIN（立即写）
+    int64_t packetTime(const Stream& s, const AVPacket* pkt) const;
+    void writeHead(Stream& s);
+
+    // 分片模式的输出：AVIOContext 的写回调按数据标记（文件头 / 分片起点）切分字节区间
+    static int writeData(void* opaque, uint8_t* buf, int size, AVIODataMarkerType type, int64_t time);
+    static int writePacket(void* opaque, uint8_t* buf, int size);
+    bool openFragmentedOutput();
+    // 把已经写出的区间交给回调，媒体分片的时间范围为 [fragStartUs_, endUs)
+    void emitFragments(int64_t endUs);
+
+    std::string filename_;
+    AVFormatContext* fmtCtx_ = nullptr;
+    std::vector<std::unique_ptr<Stream>> streams_;
+    std::map<std::string, std::string> options_;
+    int64_t windowUs_ = AV_TIME_BASE;
+
+    std::thread thread_;
+    std::atomic<bool> abort_{false};
+    bool headerWritten_ = false;
+    bool failed_ = false;
+    size_t maxPending_ = 0;
+
+    // 分片模式
+    struct Span {
+        int64_t offset = 0;
+        int64_t size = 0;
+        AVIODataMarkerType kind = AVIO_DATA_MARKER_HEADER;
+    };
+    bool fragmented_ = false;
+    double fragmentSeconds_ = 0.0;
+    FragmentCallback fragmentCb_;
+    AVIOContext* sink_ = nullptr;          // 实际写入的文件
+    int64_t outBytes_ = 0;
+    std::vector<Span> spans_;              // 还没回调的区间，最后一个可能还在写
+    int fragmentCount_ = 0;
+    int64_t fragStartUs_ = AV_NOPTS_VALUE;
+    int64_t lastEndUs_ = AV_NOPTS_VALUE;   // 已写出的包的最大结束时间
+};
@@ -0,0 +1,64 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+extern "C" {
+#include <libavutil/frame.h>
+#include <libavutil/pixfmt.h>
+}
+
+// 按目标像素格式的平面布局准备好的叠加图：
+// 每个平面存预乘后的像素和 255 - alpha，叠加时每个字节只需一次乘加
+struct PreparedOverlay {
+    int width = 0;                 // 亮度尺寸
+    int height = 0;
+    int planes = 0;
+    int planeBytes[4] = {0};       // 每个平面一行的字节数
+    int planeRows[4] = {0};
+    std::vector<uint8_t> premul[4];
+    std::vector<uint8_t> invAlpha[4];
+};
+
+// 水印叠加：不建 overlay 滤镜图。
+// logo 第一次用于某种像素格式时转换成该格式的预乘平面（色度在预乘域下采样，边缘不会渗色），
+// 结果按 (logo, 像素格式) 放在进程级缓存里，后续任务直接复用；
+// 每帧只对覆盖到的矩形调用 blendPremultiplied（pixelkernels，SIMD）。
+// 支持 8bit 平面 / 半平面 YUV（yuv420p、yuv422p、yuv444p、nv12、nv21 及 yuvj 系列）。
+class OverlayCompositor {
+public:
+    OverlayCompositor() = default;
+    ~OverlayCompositor();
+
+    OverlayCompositor(const OverlayCompositor&) = delete;
+    OverlayCompositor& operator=(const OverlayCompositor&) = delete;
+
+    // x / y 为 logo 左上角位置，负数表示 logo 右 / 下边缘离画面右 / 下边缘的距离（-10 即留 10 像素）；
+    // 位置会向下对齐到色度采样边界
+    bool init(const std::string& logoPath, int x, int y);
+
+    // 直接使用已解码的图像（任意像素格式，带 alpha 时按 alpha 叠加），key 用于缓存
+    bool init(const AVFrame* logo, const std::string& key, int x, int y);
+
+    // 叠加到 frame 上，frame 不可写时先复制一份（av_frame_make_writable）
+    bool apply(AVFrame* frame);
+
+    void close();
+
+    // 释放进程级缓存中的所有叠加图（正在使用的由持有者释放）
+    static void clearCache();
+
+private:
+    std::shared_ptr<const PreparedOverlay> prepared(AVPixelFormat fmt, int colorRange);
+    std::shared_ptr<PreparedOverlay> build(AVPixelFormat fmt, bool fullRange);
+    bool loadLogo();
+
+    std::string path_;
+    std::string key_;
+    AVFrame* logo_ = nullptr;      // 只在缓存未命中时加载 / 使用
+    int x_ = 0;
+    int y_ = 0;
+
+    AVPixelFormat curFmt_ = AV_PIX_FMT_NONE;
+    int curRange_ = -1;
+    std::shared_ptr<const PreparedOverlay> cur_;
+};
@@ -0,0 +1,55 @@
+#pragma once
+#include <map>
+#include <string>
+#include <vector>
+extern "C" {
+#include <libavutil/frame.h>
+#include <libavutil/pixfmt.h>
+#include <libavutil/buffer.h>
+#include <libswscale/swscale.h>
+}
+
+// 像素格式转换 / 缩放（libswscale）：
+// SwsContext 按 (源宽高格式, 目标宽高格式, flags) 缓存，输入中途变化时切换而不是重建；
+// 不做垂直缩放且两端色度垂直采样相同时，每一行只依赖自己，按横带分给共享线程池并行，
+// 每条横带用自己的 SwsContext；目标帧从 AVBufferPool 取，避免每帧 malloc。
+// 尺寸不变的 NV12 <-> I420、10bit I420 -> 8bit 直接走 pixelkernels，不经过 swscale。
+class PixelConverter {
+public:
+    PixelConverter() = default;
+    ~PixelConverter();
+
+    PixelConverter(const PixelConverter&) = delete;
+    PixelConverter& operator=(const PixelConverter&) = delete;
+
+    // dstWidth / dstHeight <= 0 表示与输入相同；threads > 1 时按横带并行
+    bool init(int dstWidth, int dstHeight, AVPixelFormat dstFmt,
+              int flags = SWS_BICUBIC, int threads = 1);
+
+    // 转换一帧，返回新帧（caller 负责 av_frame_free）；输入已经符合目标时返回它的引用
+    AVFrame* convert(const AVFrame* src);
+
+    void close();
+
+    AVPixelFormat dstFormat() const { return dstFmt_; }
+
+private:
+    struct Entry {
+        std::vector<SwsContext*> slices;   // 每条横带一个上下文，不切带时只有一个
+        std::vector<int> sliceY;           // 每条横带的起始行（亮度）
+    };
+
+    Entry* getEntry(const AVFrame* src, int dstW, int dstH);
+    bool buildEntry(const AVFrame* src, int dstW, int dstH, Entry& e);
+    AVFrame* allocDst(int width, int height);
+    bool convertFast(const AVFrame* src, AVFrame* out);
+
+    int dstWidth_ = 0;
+    int dstHeight_ = 0;
+    AVPixelFormat dstFmt_ = AV_PIX_FMT_NONE;
+    int flags_ = SWS_BICUBIC;
+    int threads_ = 1;
+
+    std::map<std::string, Entry> cache_;
+    std::map<std::string, AVBufferPool*> pools_;
+};
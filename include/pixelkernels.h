@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+// 常用平面操作内核：标量 / SSE4.1 / AVX2 / AVX-512 四个版本，
+// 第一次调用时按 av_get_cpu_flags() 选定，之后不再判断；所有版本的结果与标量逐字节一致。
+// 宽高均以元素（像素 / 采样点）计，stride 以字节计，可以为负。
+
+// 当前选中的指令集名称（"c" / "sse4.1" / "avx2" / "avx512"）
+const char* pixelKernelIsa();
+
+// 强制使用某一级指令集的内核（名称同上），CPU 不支持或名称未知时返回 false，选择不变。
+// 供正确性测试和基准使用：不是线程安全的，调用时不能有其他线程正在使用内核
+bool setPixelKernelIsa(const char* isa);
+
+// 平面拷贝：两边都连续时一次 memcpy，否则逐行
+void copyPlane(const uint8_t* src, ptrdiff_t srcStride, uint8_t* dst, ptrdiff_t dstStride,
+               int widthBytes, int height);
+
+// I420 -> NV12：u / v 两个平面交错成 uv 平面（width 为色度宽度）
+void interleaveUV(const uint8_t* u, ptrdiff_t uStride, const uint8_t* v, ptrdiff_t vStride,
+                  uint8_t* uv, ptrdiff_t uvStride, int width, int height);
+
+// NV12 -> I420：uv 平面拆成 u / v 两个平面（width 为色度宽度）
+void deinterleaveUV(const uint8_t* uv, ptrdiff_t uvStride, uint8_t* u, ptrdiff_t uStride,
+                    uint8_t* v, ptrdiff_t vStride, int width, int height);
+
+// 10bit -> 8bit：加 8x8 有序抖动后右移 2 位（饱和到 255）
+// rowOffset 为该平面第一行在整帧中的行号，用于按横带处理时保持抖动图案连续
+void dither10to8(const uint16_t* src, ptrdiff_t srcStride, uint8_t* dst, ptrdiff_t dstStride,
+                 int width, int height, int rowOffset = 0);
+
+// 水平翻转一行 / 一个平面，elemSize 为 1/2/4 字节
+void hflipRow(const uint8_t* src, uint8_t* dst, int width, int elemSize);
+void hflipPlane(const uint8_t* src, ptrdiff_t srcStride, uint8_t* dst, ptrdiff_t dstStride,
+                int width, int height, int elemSize);
+
+// 8bit 2x2 均值缩小：dst[x] = (四个源像素之和 + 2) >> 2，源平面至少 2*dstWidth x 2*dstHeight
+void boxDownscale2x(const uint8_t* src, ptrdiff_t srcStride, uint8_t* dst, ptrdiff_t dstStride,
+                    int dstWidth, int dstHeight);
+
+// 预乘 alpha 叠加（8bit）：dst = premul + dst * invAlpha / 255（四舍五入，饱和到 255），
+// premul 为已乘过 alpha 的叠加像素，invAlpha = 255 - alpha
+void blendPremultiplied(uint8_t* dst, ptrdiff_t dstStride, const uint8_t* premul, ptrdiff_t premulStride,
+                        const uint8_t* invAlpha, ptrdiff_t alphaStride, int width, int height);
@@ -2,6 +2,7 @@
 #include <queue>
 #include <mutex>
 #include <condition_variable>
+#include <chrono>
 
 template<typename T>
 class PacketQueue {
@@ -31,6 +32,23 @@ public:
         return item;
     }
 
+    // 非阻塞弹出：队列为空时最多等 timeout，仍然为空（或已停止且取空）返回 false
+    bool tryPop(T& item, std::chrono::milliseconds timeout = std::chrono::milliseconds(0)) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!cond_.wait_for(lock, timeout, [this]{ return !queue_.empty() || stop_; })) return false;
+        if (queue_.empty()) return false;
+
+        item = queue_.front();
+        queue_.pop();
+        return true;
+    }
+
+    // 已经停止且取空
+    bool finished() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return stop_ && queue_.empty();
+    }
+
     // 停止队列
     void stop() {
         {
@@ -0,0 +1,81 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+#include <sys/uio.h>
+extern "C" {
+#include <libavutil/frame.h>
+}
+
+// 原始 YUV / PCM 写文件：
+// 小块数据（逐行、逐帧 PCM）先拷进 4 MiB 的暂存块，攒满后一次 write；
+// 大帧在普通模式下直接 writev：行连续（linesize == 行字节数）的平面是一个 iovec，
+// 有 padding 的平面每行一个 iovec，按 IOV_MAX 分批提交。
+// direct 模式用 O_DIRECT 绕过页缓存，暂存块按 4096 对齐，最后不足对齐的尾巴清掉 O_DIRECT 再写；
+// background 模式由后台线程写盘，调用线程只做拷贝（暂存块个数有上限，写盘跟不上时阻塞）。
+class RawFrameWriter {
+public:
+    RawFrameWriter() = default;
+    ~RawFrameWriter();
+
+    RawFrameWriter(const RawFrameWriter&) = delete;
+    RawFrameWriter& operator=(const RawFrameWriter&) = delete;
+
+    // direct: 使用 O_DIRECT（文件系统不支持时退回普通写）；background: 使用后台写线程
+    bool open(const std::string& path, bool direct = false, bool background = false,
+              size_t blockSize = 4 << 20);
+
+    // 按像素格式写出所有平面（与 av_image_copy_to_buffer(align = 1) 的布局一致），支持平面和打包格式
+    bool writeVideo(const AVFrame* frame);
+
+    // 写 PCM：打包格式原样写出，平面格式交错成打包布局
+    bool writeAudio(const AVFrame* frame);
+
+    // 写任意字节
+    bool write(const void* data, size_t size);
+
+    // 写完剩余数据并关闭文件，返回是否全程没有写错误
+    bool close();
+
+    bool isOpen() const { return fd_ >= 0; }
+    uint64_t bytesWritten() const { return bytes_; }
+
+private:
+    struct Block {
+        uint8_t* data = nullptr;
+        size_t used = 0;
+    };
+
+    bool writeIov(std::vector<struct iovec>& iov, size_t total);
+    void append(const uint8_t* data, size_t size);
+    uint8_t* reserve(size_t* avail);
+    void commit(size_t size);
+
+    Block* acquireBlock();
+    void submitBlock(Block* b);
+    void writeBlock(Block* b);
+    bool writeAll(const uint8_t* data, size_t size);
+    void writerLoop();
+
+    int fd_ = -1;
+    bool direct_ = false;
+    bool background_ = false;
+    size_t blockSize_ = 0;
+
+    Block* cur_ = nullptr;
+    std::vector<Block*> blocks_;
+    std::vector<Block*> free_;
+    std::deque<Block*> pending_;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::thread writer_;
+    bool stop_ = false;
+
+    std::atomic<bool> error_{false};
+    std::atomic<uint64_t> bytes_{0};
+};
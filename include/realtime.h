@@ -0,0 +1,53 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+extern "C" {
+#include <libavutil/avutil.h>
+#include <libavutil/frame.h>
+}
+
+// 实时模式控制器：
+// 解码阶段根据帧的 pts 换算出墙钟截止时间（写入 frame->opaque，随 av_frame_ref / 滤镜一起传递），
+// 解码、滤镜、编码各阶段用 shouldDrop() 判断是否丢弃迟到的帧，保证端到端延迟不超过目标值。
+class RealtimeController {
+public:
+    enum Stage {
+        STAGE_DECODE = 0,
+        STAGE_FILTER,
+        STAGE_ENCODE,
+        STAGE_COUNT
+    };
+
+    // latencyMs: 端到端延迟目标（毫秒）
+    explicit RealtimeController(int latencyMs = 500);
+
+    // 计算截止时间并写入 frame->opaque，第一帧作为墙钟与 pts 的对齐锚点
+    void stamp(AVFrame* frame, AVRational timeBase);
+
+    // 超过截止时间多少微秒，<= 0 表示没有迟到（未打时间戳的帧永远不迟到）
+    int64_t lateness(const AVFrame* frame) const;
+
+    // 迟到的非参考帧（B 帧）直接丢；迟到超过一个延迟目标时除关键帧外全部丢
+    // 返回 true 表示调用方应丢弃该帧，同时计入对应阶段的丢帧计数
+    bool shouldDrop(const AVFrame* frame, Stage stage);
+
+    // 解码阶段是否落后，落后时解码器跳过非参考帧（AVDISCARD_NONREF）
+    bool behind() const { return behind_.load(); }
+
+    uint64_t dropped(Stage stage) const { return dropped_[stage].load(); }
+    uint64_t passed(Stage stage) const { return passed_[stage].load(); }
+
+    void printStats() const;
+
+private:
+    static int64_t nowUs();
+
+    int64_t latencyUs_;
+
+    std::atomic<int64_t> anchorWallUs_{AV_NOPTS_VALUE};
+    std::atomic<int64_t> anchorPtsUs_{AV_NOPTS_VALUE};
+    std::atomic<bool> behind_{false};
+
+    std::atomic<uint64_t> dropped_[STAGE_COUNT];
+    std::atomic<uint64_t> passed_[STAGE_COUNT];
+};
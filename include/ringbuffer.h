@@ -23,6 +23,17 @@ public:
         not_empty_.notify_one();
     }
 
+    // 非阻塞 push：满了直接返回 false（实时采集时丢帧而不是让采集端等待）
+    bool tryPush(const T& item) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (stop_ || size_ >= capacity_) return false;
+        buffer_[writeIndex_] = item;
+        writeIndex_ = (writeIndex_ + 1) % capacity_;
+        size_++;
+        not_empty_.notify_one();
+        return true;
+    }
+
     // pop: 消费者
     bool pop(T& item) {
         std::unique_lock<std::mutex> lock(mtx_);
@@ -37,6 +48,13 @@ public:
         return true;
     }
 
+    // 当前缓存的元素个数 / 容量，用于观察下游是否跟得上
+    size_t size() {
+        std::lock_guard<std::mutex> lock(mtx_);
+        return size_;
+    }
+    size_t capacity() const { return capacity_; }
+
     // 停止
     void stop() {
         {
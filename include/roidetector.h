@@ -0,0 +1,80 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+extern "C" {
+#include <libavutil/frame.h>
+#include <libavutil/pixelutils.h>
+}
+
+// 感兴趣区域（ROI）分析阶段的接口：放在 VideoFilter 和 VideoEncoder 之间，
+// 把结果写成帧的 AV_FRAME_DATA_REGIONS_OF_INTEREST，libx264 按区域给宏块加 QP 偏移
+// （qoffset 为 -1..1，负数表示提高质量；多个区域重叠时数组中靠前的生效）。
+// 编码端需要 VideoEncoder::setRoiEncoding(true)，否则帧上的 ROI 会被去掉。
+class RoiDetector {
+public:
+    virtual ~RoiDetector() = default;
+
+    // 分析一帧，替换帧上已有的 ROI，返回写入的区域数（0 表示没有写入）
+    virtual int analyze(AVFrame* frame) = 0;
+    virtual void reset() {}
+
+    // 把 regions 写到 frame 上（先移除已有的 ROI；regions 为空时只移除）
+    static bool attach(AVFrame* frame, const std::vector<AVRegionOfInterest>& regions);
+};
+
+// 基于运动的 ROI：亮度平面 2x2 缩小后和上一帧比较 8x8 块 SAD（对应原图 16x16 宏块），
+// 平均差超过阈值的块判为运动块，保持 holdFrames 帧（避免 QP 随帧闪烁），向四周扩一块后
+// 合并成矩形作为 ROI；存在 ROI 时整帧再加一个背景区域，背景适当降低质量省下码率。
+// 适合固定机位的监控、讲话人这类画面；镜头运动时大部分块都是运动块，效果接近不开。
+class MotionRoiDetector : public RoiDetector {
+public:
+    // threshold: 块内每像素平均差；roiOffset / backgroundOffset: 运动区域 / 背景的 qoffset；
+    // maxRegions: 合并后矩形数超过该值时退化成一个包围盒
+    explicit MotionRoiDetector(double threshold = 4.0, float roiOffset = -0.2f,
+                               float backgroundOffset = 0.1f, int holdFrames = 12, int maxRegions = 32);
+    ~MotionRoiDetector() override;
+
+    MotionRoiDetector(const MotionRoiDetector&) = delete;
+    MotionRoiDetector& operator=(const MotionRoiDetector&) = delete;
+
+    // 只支持 8bit 亮度平面的格式，其余格式不分析（移除已有 ROI，返回 0）
+    int analyze(AVFrame* frame) override;
+    void reset() override;
+
+    int64_t frameCount() const { return frames_; }
+    int64_t roiFrames() const { return roiFrames_; }
+    // 有 ROI 的帧中运动区域占画面的平均比例
+    double averageCoverage() const { return roiFrames_ ? coverageSum_ / roiFrames_ : 0.0; }
+    void printStats() const;
+
+private:
+    bool prepare(const AVFrame* frame);
+    void buildRegions(std::vector<AVRegionOfInterest>& regions);
+
+    double threshold_;
+    float roiOffset_;
+    float backgroundOffset_;
+    int holdFrames_;
+    int maxRegions_;
+
+    int inWidth_ = 0;
+    int inHeight_ = 0;
+    int inFormat_ = -1;
+    bool supported_ = false;
+
+    int halfStride_ = 0;
+    uint8_t* cur_ = nullptr;
+    uint8_t* prev_ = nullptr;
+    bool havePrev_ = false;
+
+    int gridW_ = 0;                  // 参与比较的块数（每块对应原图 16x16）
+    int gridH_ = 0;
+    std::vector<int> hold_;          // 每块剩余的保持帧数，> 0 为运动块
+    std::vector<uint8_t> mask_;      // 扩边后的运动块
+
+    av_pixelutils_sad_fn sad8_ = nullptr;
+
+    int64_t frames_ = 0;
+    int64_t roiFrames_ = 0;
+    double coverageSum_ = 0.0;
+};
@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+extern "C" {
+#include <libavutil/frame.h>
+#include <libavutil/pixfmt.h>
+}
+
+// 直角旋转（0/90/180/270，顺时针）：
+// 90/270 为逐平面分块转置（SSE2 / AVX2 内核运行时选择），行方向翻转通过指针 + 负 linesize 完成，不额外拷贝；
+// 180 为倒序读行 + 行内水平翻转。结果与输入逐像素一致，没有插值。
+
+// 该像素格式能否走直角旋转快速路径（每个平面元素为 1/2/4 字节，90/270 要求色度横纵采样比相同）
+bool rotateSupported(AVPixelFormat fmt, int angle);
+
+// 旋转后的尺寸
+void rotatedSize(int width, int height, int angle, int* outWidth, int* outHeight);
+
+// src 旋转写入 dst；dst 的 format/width/height 需已按旋转后尺寸设置好并分配了 buffer
+// [rowBegin, rowEnd) 为只生成的目标亮度行范围（rowEnd < 0 表示到底），用于按横带并行；
+// rowBegin 需按色度垂直采样对齐
+bool rotateFrame(const AVFrame* src, AVFrame* dst, int angle, int rowBegin = 0, int rowEnd = -1);
+
+// 单平面旋转：w/h 为源平面尺寸（元素个数），elemSize 为元素字节数（1/2/4），
+// [rowBegin, rowEnd) 为目标平面的行范围
+void rotatePlane(const uint8_t* src, ptrdiff_t srcStride, int w, int h,
+                 uint8_t* dst, ptrdiff_t dstStride, int elemSize, int angle,
+                 int rowBegin = 0, int rowEnd = -1);
@@ -0,0 +1,75 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+extern "C" {
+#include <libavutil/frame.h>
+#include <libavutil/pixelutils.h>
+}
+
+struct SceneCut {
+    int64_t frameIndex = 0;   // 第几帧（从 0 开始，包括第一帧）
+    int64_t pts = AV_NOPTS_VALUE;
+    double histDiff = 0.0;    // 亮度直方图差异（0..1）
+    double meanSad = 0.0;     // 每像素平均绝对差（0..255）
+};
+
+// 轻量场景切换检测，放在 VideoFilter 和 VideoEncoder 之间：
+// 亮度平面用 2x2 均值缩小到宽度不超过 256，和上一帧比较 16x16 块 SAD（av_pixelutils）与 64 级直方图，
+// 直方图差异超过阈值、且 SAD 明显高于最近的平均水平时判为切换。
+// 切换帧设置 pict_type = I，其余帧清成 NONE（否则 libx264 会沿用解码出来的 P/B 类型），
+// 配合 VideoEncoder::setSceneCutKeyframes() 让 IDR 落在切换点，其余位置 GOP 自由拉长。
+class SceneDetector {
+public:
+    // threshold: 直方图差异阈值；minSceneFrames: 两次切换之间最少间隔的帧数
+    explicit SceneDetector(double threshold = 0.3, int minSceneFrames = 12);
+    ~SceneDetector();
+
+    SceneDetector(const SceneDetector&) = delete;
+    SceneDetector& operator=(const SceneDetector&) = delete;
+
+    // 分析一帧，是切换点时返回 true；markFrames 打开时同时设置 frame->pict_type
+    // 只支持 8bit 亮度平面的格式，其余格式不检测（返回 false、不改 pict_type）
+    bool analyze(AVFrame* frame);
+
+    void setMarkFrames(bool on) { markFrames_ = on; }
+
+    // 各场景的起点（第一帧也算一个）
+    const std::vector<SceneCut>& cuts() const { return cuts_; }
+    int64_t frameCount() const { return frameIndex_; }
+
+    void reset();
+
+private:
+    bool prepare(const AVFrame* frame);
+    void downscale(const AVFrame* frame, uint8_t* dst);
+    int64_t blockSad(const uint8_t* a, const uint8_t* b) const;
+
+    double threshold_;
+    int minSceneFrames_;
+    bool markFrames_ = true;
+
+    // 当前输入的尺寸 / 格式，变化时重新分配
+    int inWidth_ = 0;
+    int inHeight_ = 0;
+    int inFormat_ = -1;
+    bool supported_ = false;
+
+    int levels_ = 0;           // 2x2 缩小的次数
+    int smallW_ = 0;           // 缩小后参与比较的区域（16 的倍数）
+    int smallH_ = 0;
+    int smallStride_ = 0;
+    uint8_t* cur_ = nullptr;
+    uint8_t* prev_ = nullptr;
+    uint8_t* scratch_[2] = {nullptr, nullptr};
+    int scratchStride_ = 0;
+
+    av_pixelutils_sad_fn sad16_ = nullptr;
+
+    std::vector<int> histPrev_;
+    bool havePrev_ = false;
+    double avgSad_ = 0.0;
+    int64_t frameIndex_ = 0;
+    int64_t lastCut_ = 0;
+
+    std::vector<SceneCut> cuts_;
+};
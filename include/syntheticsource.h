@@ -0,0 +1,50 @@
+#pragma once
+#include "latencyprobe.h"
+#include <atomic>
+#include <functional>
+#include <cstdint>
+extern "C" {
+#include <libavutil/frame.h>
+#include <libavutil/pixfmt.h>
+#include <libavutil/rational.h>
+}
+
+// 本地合成信号源（替代摄像头 / 采集卡）：按帧率实时产生 YUV420P 帧（移动的渐变 + 方块），
+// pts 为帧序号，时间基 1/fps。按墙钟节拍输出，回调阻塞导致落后超过一帧时丢帧，
+// 与真实采集设备一样不会积压；配合 LatencyProbe 在产生帧的时刻打点。
+class SyntheticSource {
+public:
+    SyntheticSource(int width, int height, int fps);
+
+    SyntheticSource(const SyntheticSource&) = delete;
+    SyntheticSource& operator=(const SyntheticSource&) = delete;
+
+    void setLatencyProbe(LatencyProbe* probe) { probe_ = probe; }
+
+    // 产生 frameCount 帧（<= 0 表示直到 stop），每帧调用一次回调；阻塞直到结束。
+    // 回调拿到的帧由 run 释放，需要保留时自己 av_frame_ref
+    void run(int64_t frameCount, std::function<void(AVFrame*)> frameCallback);
+
+    // 其他线程调用，让 run 尽快返回
+    void stop() { stop_ = true; }
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+    int fps() const { return fps_; }
+    AVRational timeBase() const { return {1, fps_}; }
+    AVPixelFormat pixelFormat() const { return AV_PIX_FMT_YUV420P; }
+
+    int64_t produced() const { return produced_; }
+    int64_t dropped() const { return dropped_; }
+
+private:
+    void fill(AVFrame* frame, int64_t index) const;
+
+    int width_;
+    int height_;
+    int fps_;
+    LatencyProbe* probe_ = nullptr;
+    std::atomic<bool> stop_{false};
+    int64_t produced_ = 0;
+    int64_t dropped_ = 0;
+};
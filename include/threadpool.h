@@ -0,0 +1,41 @@
+#pragma once
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+// 简单的固定大小线程池，用于把一帧的处理切成横带并行执行
+class ThreadPool {
+public:
+    explicit ThreadPool(int threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // 进程共享的线程池（线程数 = CPU 核数）
+    static ThreadPool& shared();
+
+    int size() const { return (int)workers_.size(); }
+
+    // 提交一个任务，不等待
+    void submit(std::function<void()> task);
+
+    // 并行执行 fn(0) ... fn(count-1)，调用线程也参与，全部完成后返回
+    void parallelFor(int count, const std::function<void(int)>& fn);
+
+    // 把 height 行切成 stripes 条横带并行执行 fn(y0, y1)，横带边界按 align 行对齐
+    // （例如 4:2:0 需要 align = 2，保证色度行不跨带）
+    void runStripes(int height, int stripes, int align, const std::function<void(int, int)>& fn);
+
+private:
+    void workerLoop();
+
+    std::vector<std::thread> workers_;
+    std::queue<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    bool stop_ = false;
+};
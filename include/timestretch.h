@@ -0,0 +1,62 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+// 单级变速不变调（WSOLA）：
+// 输出按固定合成步长 Hs = N/2 叠加 Hann 窗片段，输入按 Ha = Hs * speed 前进；
+// 每个片段在名义位置 ±searchRadius 内做归一化互相关搜索（SSE / AVX2 点积运行时选择），
+// 选与上一片段“自然延续”最相似的位置，避免相位跳变。任意倍速都只需一遍处理，
+// 不像 atempo 那样要把 [0.5, 2.0] 之外的倍速拆成多级级联。
+// 输入输出都是平面 float（AV_SAMPLE_FMT_FLTP）。
+class TimeStretch {
+public:
+    TimeStretch() = default;
+
+    // windowMs: 窗长（毫秒），searchMs: 搜索半径（毫秒）
+    bool init(int channels, int sampleRate, double speed, int windowMs = 20, int searchMs = 5);
+
+    // 送入 nbSamples 个样本（planes[ch] 指向每个声道的数据）
+    void push(const float* const* planes, int nbSamples);
+
+    // 输入结束：补静音处理完剩余样本，输出总长度截到 输入长度 / speed
+    void flush();
+
+    // 已生成、可读取的样本数
+    int available() const { return (int)outReady_[0].size() - outRead_; }
+
+    // 读出最多 maxSamples 个样本，返回实际读出的个数
+    int read(float* const* planes, int maxSamples);
+
+    int channels() const { return channels_; }
+    double speed() const { return speed_; }
+
+private:
+    void processSegments();
+    int searchBest(int64_t nominal, int64_t prevStart);
+    void compact();
+
+    int channels_ = 0;
+    double speed_ = 1.0;
+    int window_ = 0;         // N
+    int hop_ = 0;            // Hs = N / 2
+    int searchRadius_ = 0;   // Δ
+
+    std::vector<float> hann_;
+
+    // 输入缓冲：开头补 Hs 个静音，inBase_ 为缓冲第 0 个样本的（补零后）绝对下标
+    std::vector<std::vector<float>> in_;
+    std::vector<float> mono_;   // 各声道平均，只用于相似度搜索
+    int64_t inBase_ = 0;
+    int64_t inTotal_ = 0;       // 实际送入的样本数（不含补零）
+
+    // 叠加缓冲（长度 N），前 Hs 个样本在每个片段后完成
+    std::vector<std::vector<float>> ola_;
+    std::vector<std::vector<float>> outReady_;
+    int outRead_ = 0;
+
+    int64_t segment_ = 0;       // 下一个片段序号
+    int64_t prevStart_ = -1;    // 上一个片段实际选中的输入起点
+    int64_t produced_ = 0;      // 已生成的输出样本数（不含丢弃的前 Hs 个）
+    int64_t skip_ = 0;          // 还需丢弃的开头样本数
+    int64_t limit_ = -1;        // flush 后的输出总长度
+};
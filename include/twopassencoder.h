@@ -0,0 +1,76 @@
+#pragma once
+#include "videoencoder.h"
+#include "framespillcache.h"
+#include <string>
+#include <memory>
+
+// 两遍编码，不重复解码和滤镜：
+// 第一遍边编码边把送进来的帧存入 FrameSpillCache（内存 / 磁盘预算可配），x264 写统计文件；
+// finish() 时关闭第一遍编码器，按统计文件打开第二遍编码器，直接从缓存取帧编码，
+// 第二遍只剩编码本身的开销。第一遍的输出包直接丢弃。
+class TwoPassEncoder {
+public:
+    // statsFile: x264 统计文件；spillPath: 帧缓存溢出文件；预算以字节计
+    TwoPassEncoder(const std::string& statsFile, const std::string& spillPath,
+                   size_t memoryBudget, uint64_t diskBudget,
+                   FrameSpillCache::Mode spillMode = FrameSpillCache::SPILL_RAW);
+
+    TwoPassEncoder(const TwoPassEncoder&) = delete;
+    TwoPassEncoder& operator=(const TwoPassEncoder&) = delete;
+
+    // 两遍使用的参数（码率控制应为 ABR），open 之前调用
+    void setProfile(const EncoderProfile& profile) { profile_ = profile; }
+    void setSceneCutKeyframes(bool on, int maxGop = 250) {
+        sceneCut_ = on;
+        maxGop_ = maxGop;
+    }
+    // 两遍都按帧上的 ROI 编码（缓存的帧保留 ROI）
+    void setRoiEncoding(bool on) { roi_ = on; }
+    // 见 VideoEncoder::setGlobalHeader（open 之前调用）
+    void setGlobalHeader(bool on) { globalHeader_ = on; }
+
+    bool open(int width, int height, AVRational time_base, AVPixelFormat pix_fmt, int fps);
+
+    // 第一遍：编码并缓存一帧（调用方仍负责释放 frame）
+    bool encode(AVFrame* frame);
+
+    // 结束第一遍，用缓存的帧做第二遍，输出包 push 到 pktQueue
+    bool finish(PacketQueue<AVPacket*>& pktQueue);
+
+    // 编码器参数（两遍相同），open 之后可用，供封装器写文件头
+    const AVCodecContext* codecContext() const { return pass1_ ? pass1_->getCodecContext() : nullptr; }
+
+    void printStats() const;
+
+private:
+    std::unique_ptr<VideoEncoder> makeEncoder(int pass);
+
+    std::string statsFile_;
+    std::string spillPath_;
+    size_t memoryBudget_;
+    uint64_t diskBudget_;
+    FrameSpillCache::Mode spillMode_;
+
+    EncoderProfile profile_ = EncoderProfile::defaults();
+    bool sceneCut_ = false;
+    int maxGop_ = 250;
+    bool roi_ = false;
+    bool globalHeader_ = false;
+
+    int width_ = 0;
+    int height_ = 0;
+    AVRational timeBase_ = {1, 25};
+    AVPixelFormat pixFmt_ = AV_PIX_FMT_NONE;
+    int fps_ = 25;
+
+    std::unique_ptr<VideoEncoder> pass1_;
+    PacketQueue<AVPacket*> discard_;
+    FrameSpillCache cache_;
+    bool failed_ = false;
+
+    double pass1Ms_ = 0.0;
+    double pass2Ms_ = 0.0;
+    int64_t pass2Frames_ = 0;
+    int64_t spilledFrames_ = 0;
+    uint64_t spillBytes_ = 0;
+};
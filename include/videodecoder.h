@@ -1,6 +1,8 @@
 #pragma once
 #include "queue.h"
+#include "realtime.h"
 #include <functional>
+#include <string>
 extern "C" {
 #include <libavcodec/avcodec.h>
 #include <libavutil/frame.h>
@@ -20,7 +22,21 @@ public:
                 
     AVCodecContext* getCodecContext() const { return codecCtx_; }
 
+    // 让解码器导出运动矢量（AV_FRAME_DATA_MOTION_VECTORS），必须在 open 之前调用
+    void setExportMotionVectors(bool enable) { exportMvs_ = enable; }
+
+    // 低延迟：解出一帧立即输出（不为重排等待后续帧，输入流应没有 B 帧），只用 slice 线程；
+    // 必须在 open 之前调用
+    void setLowDelay(bool enable) { lowDelay_ = enable; }
+
+    // 实时模式：迟到的帧在解码阶段丢弃，落后时跳过非参考帧的解码
+    void setRealtime(RealtimeController* rt) { realtime_ = rt; }
+
 private:
     AVCodecContext* codecCtx_ = nullptr;
     AVCodecParameters* codecpar_ = nullptr;
+    std::string poolKey_;
+    bool exportMvs_ = false;
+    bool lowDelay_ = false;
+    RealtimeController* realtime_ = nullptr;
 };
@@ -1,5 +1,11 @@
 #pragma once
 #include "queue.h"
+#include "realtime.h"
+#include "encodergovernor.h"
+#include "encoderprofile.h"
+#include <string>
+#include <mutex>
+#include <condition_variable>
 extern "C" {
 #include <libavcodec/avcodec.h>
 #include <libavutil/frame.h>
@@ -8,6 +14,7 @@ extern "C" {
 
 class VideoEncoder {
 public:
+    // H.264 优先使用 libx264，其余按 codec_id 查找；profile 中指定了 codec 时以 profile 为准
     VideoEncoder(AVCodecID codec_id = AV_CODEC_ID_H264);
     ~VideoEncoder();
 
@@ -15,6 +22,9 @@ public:
     bool open(int width, int height, AVRational time_base, AVPixelFormat pix_fmt, int fps);
     void close();
 
+    // 预先打开 count 个相同参数的编码器放入上下文池，下一个任务 open 时直接取用
+    bool prewarm(int width, int height, AVRational time_base, AVPixelFormat pix_fmt, int fps, int count);
+
     // 将 AVFrame 编码成 AVPacket 并 push 到队列
     bool encode(AVFrame* frame, PacketQueue<AVPacket*>& pktQueue);
 
@@ -22,7 +32,90 @@ public:
     void flush(PacketQueue<AVPacket*>& pktQueue);
 
     AVCodecContext* getCodecContext() const { return codecCtx_; }
+
+    // 编码器能接受的像素格式中最接近 src 的一个（编码器直接支持 src 时就是 src）
+    AVPixelFormat pickPixelFormat(AVPixelFormat src) const;
+
+    // 实时模式：迟到的帧不再编码（encode 仍返回 true）
+    void setRealtime(RealtimeController* rt) { realtime_ = rt; }
+
+    // 由外部（SceneDetector）决定关键帧位置，需在 open 之前调用：
+    // GOP 上限取 profile 的 gop 与 maxGop 中较小的一个，关闭编码器自带的场景检测（sc_threshold=0），
+    // pict_type 为 I 的帧编码成 IDR（forced-idr=1）
+    void setSceneCutKeyframes(bool on, int maxGop = 250) {
+        sceneCut_ = on;
+        maxGop_ = maxGop;
+    }
+
+    // 按帧的 AV_FRAME_DATA_REGIONS_OF_INTEREST（RoiDetector 写入）分区域调整 QP，需在 open 之前调用：
+    // libx264 的 ROI 依赖自适应量化，profile 关掉了 aq-mode 时重新打开；不打开时帧上的 ROI 被去掉
+    void setRoiEncoding(bool on) { roi_ = on; }
+
+    // SPS/PPS 放进 extradata（AV_CODEC_FLAG_GLOBAL_HEADER），需在 open 之前调用。
+    // 封装格式带 AVFMT_GLOBALHEADER、且文件头在第一个包之前就要写完时（分片 MP4 的空 moov）必须打开；
+    // 打开后不做速度调节（换实例会换参数集）
+    void setGlobalHeader(bool on) { globalHeader_ = on; }
+
+    // 编码参数（open 之前调用），默认 EncoderProfile::defaults()
+    void setProfile(const EncoderProfile& profile);
+    const EncoderProfile& profile() const { return profile_; }
+
+    // 单独覆盖 profile 中的 preset，需在 open 之前调用
+    void setPreset(const std::string& preset) { preset_ = preset; }
+    const std::string& preset() const { return preset_; }
+
+    // 速度调节（open 之前调用）：以 governor 的当前 preset 打开，并预先打开相邻两档；
+    // 之后每到 GOP 边界询问 governor，preset 变化时 flush 当前实例、换用新 preset 的实例，
+    // 并在共享线程池上预先打开新的相邻两档（不支持 ENCODER_FLUSH 的 x264 实例归还时被释放，不能指望池里还有），
+    // 新 GOP 从 IDR 开始（SPS/PPS 随 IDR 输出，不能与全局头一起使用，setGlobalHeader 打开时忽略）
+    void setGovernor(EncoderGovernor* governor) { governor_ = governor; }
+
+    // 两遍编码（open 之前调用）：pass 1 写 x264 统计文件，pass 2 读取；0 表示普通编码。
+    // 统计文件在编码器关闭时才写完，这类实例不放回上下文池
+    void setPass(int pass, const std::string& statsFile) {
+        pass_ = pass;
+        statsFile_ = statsFile;
+    }
 private:
+    std::string makePoolKey(int width, int height, AVRational time_base, AVPixelFormat pix_fmt, int fps,
+                            const std::string& preset) const;
+    AVCodecContext* createContext(int width, int height, AVRational time_base, AVPixelFormat pix_fmt, int fps,
+                                  const std::string& preset);
+    bool acquireContext(const std::string& preset);
+    void switchPreset(const std::string& preset, PacketQueue<AVPacket*>& pktQueue);
+    // 预先打开 governor 当前 preset 的相邻两档；async 时在共享线程池上打开，不阻塞编码线程
+    void prewarmNeighbours(bool async);
+    // 等待后台预热完成（预热任务读取 open 的参数）
+    void waitPrewarm();
+
     AVCodec* codec_ = nullptr;
+    EncoderProfile profile_ = EncoderProfile::defaults();
     AVCodecContext* codecCtx_ = nullptr;
+    std::string poolKey_;
+    RealtimeController* realtime_ = nullptr;
+
+    bool sceneCut_ = false;
+    int maxGop_ = 250;
+    bool roi_ = false;
+    bool globalHeader_ = false;
+
+    std::string preset_ = "fast";
+    EncoderGovernor* governor_ = nullptr;
+
+    // open 的参数，切换 preset 时按相同参数重新取实例
+    int width_ = 0;
+    int height_ = 0;
+    AVRational timeBase_ = {1, 25};
+    AVPixelFormat pixFmt_ = AV_PIX_FMT_NONE;
+    int fps_ = 25;
+
+    int pass_ = 0;
+    std::string statsFile_;
+
+    int64_t frameIndex_ = 0;
+    int framesInGop_ = 0;
+
+    std::mutex prewarmMutex_;
+    std::condition_variable prewarmCond_;
+    int prewarmPending_ = 0;
 };
@@ -1,5 +1,10 @@
 #pragma once
 #include <functional>
+#include <map>
+#include <string>
+#include <memory>
+#include "realtime.h"
+#include "overlaycompositor.h"
 
 extern "C" {
 #include <libavcodec/avcodec.h>
@@ -20,18 +25,63 @@ public:
     // 90: rotate clockwise
     // 180: upside down
     // 270: rotate counter-clockwise
+    // 直角旋转且像素格式支持时不建滤镜图，直接逐平面转置（见 rotate.h）；
+    // 其余情况走滤镜图（直角用 transpose/hflip/vflip，任意角度用 rotate）
     bool init(AVCodecContext* decCtx, int angle);
 
     // 输入 frame，输出经过滤镜处理后的 frame
     // 回调返回过滤后的帧
+    // 每帧检查输入参数，分辨率/像素格式变化时自动切换到为新配置建立（或缓存中已有）的滤镜图
     void filterFrame(AVFrame* frame, std::function<void(AVFrame*)> callback);
 
+    // 输出尺寸（90/270 度时宽高互换），编码器应按此尺寸打开。
+    // 输出尺寸和像素格式在 init 时确定，之后输入中途变化也缩放 / 转换回这一配置，编码器不需要重开
+    int outputWidth() const { return outWidth_; }
+    int outputHeight() const { return outHeight_; }
+
+    // 并行线程数（init 之前调用）：滤镜图启用 slice 线程，直接旋转路径按横带分给共享线程池
+    void setThreads(int threads) { threads_ = threads > 0 ? threads : 1; }
+
+    // 实时模式：迟到的帧不再送入滤镜
+    void setRealtime(RealtimeController* rt) { realtime_ = rt; }
+
+    // 在输出帧（旋转之后）上叠加水印，x / y 含义见 OverlayCompositor::init；
+    // 预处理后的 logo 在进程内缓存，不同任务使用同一 logo 时不再重复转换
+    bool setWatermark(const std::string& logoPath, int x, int y);
+
 private:
-    bool initFilterGraph(AVCodecContext* decCtx, int angle);
+    struct GraphInstance {
+        AVFilterGraph* graph = nullptr;
+        AVFilterContext* src = nullptr;
+        AVFilterContext* sink = nullptr;
+    };
+
+    bool reconfigure(int width, int height, int format, AVRational sar);
+    bool initFilterGraph(int width, int height, AVPixelFormat pix_fmt, AVRational sar, GraphInstance& g);
+    bool inputChanged(const AVFrame* frame) const;
+    void filterDirect(AVFrame* frame, const std::function<void(AVFrame*)>& callback);
+
+    // 按输入配置（WxH:pix_fmt:sar）缓存的滤镜图，当前使用的图见下面三个指针
+    std::map<std::string, GraphInstance> graphCache_;
 
     AVFilterGraph* filterGraph_ = nullptr;
     AVFilterContext* buffersrcCtx_ = nullptr;
     AVFilterContext* buffersinkCtx_ = nullptr;
 
     int rotateAngle_ = 0;
+    int threads_ = 1;
+    AVRational timeBase_ = {1, 25};
+
+    // 当前输入配置
+    int inWidth_ = 0;
+    int inHeight_ = 0;
+    int inFormat_ = AV_PIX_FMT_NONE;
+    AVRational inSar_ = {1, 1};
+
+    bool directRotate_ = false;   // 不经过滤镜图，直接旋转
+    int outWidth_ = 0;
+    int outHeight_ = 0;
+    int outFormat_ = AV_PIX_FMT_NONE;   // init 时确定，之后的滤镜图都输出这一格式
+    RealtimeController* realtime_ = nullptr;
+    std::unique_ptr<OverlayCompositor> watermark_;
 };
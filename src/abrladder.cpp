@@ -0,0 +1,91 @@
+#include "abrladder.h"
+#include <iostream>
+
+AbrLadder::AbrLadder() {}
+
+AbrLadder::~AbrLadder() {
+    finish();
+}
+
+bool AbrLadder::open(AVCodecContext* decCtx, const std::vector<LadderRung>& rungs, int fps,
+                     size_t branchDepth, AVRational timeBase) {
+    if (!filter_.init(decCtx, rungs, timeBase)) {
+        std::cerr << "AbrLadder: failed to init ladder filter\n";
+        return false;
+    }
+
+    for (int i = 0; i < filter_.rungCount(); ++i) {
+        std::unique_ptr<Branch> b(new Branch);
+        b->encoder.reset(new VideoEncoder());
+        if (rungs[i].bitrate > 0) {
+            // 限峰值的 CRF：简单内容码率自然更低，复杂内容不超过该档的上限
+            EncoderProfile p = EncoderProfile::defaults();
+            p.quality = 23;
+            p.maxBitrate = rungs[i].bitrate;
+            p.bufferSize = 2 * rungs[i].bitrate;
+            b->encoder->setProfile(p);
+        }
+        b->frames.reset(new RingBuffer<AVFrame*>(branchDepth));
+
+        if (!b->encoder->open(filter_.outputWidth(i), filter_.outputHeight(i),
+                              filter_.outputTimeBase(i), filter_.outputPixFmt(i), fps)) {
+            std::cerr << "AbrLadder: failed to open encoder for rung " << i << "\n";
+            return false;
+        }
+        std::cout << "[AbrLadder] rung " << i << ": "
+                  << filter_.outputWidth(i) << "x" << filter_.outputHeight(i) << "\n";
+        branches_.push_back(std::move(b));
+    }
+
+    for (int i = 0; i < (int)branches_.size(); ++i) {
+        Branch* b = branches_[i].get();
+        b->thread = std::thread([this, b, i]{ encodeLoop(*b, i); });
+    }
+    return true;
+}
+
+void AbrLadder::pushFrame(AVFrame* frame) {
+    if (!frame || finished_) return;
+
+    filter_.filterFrame(frame, [&](int i, AVFrame* f){
+        // 滤镜输出帧会被复用，每个分支持有自己的引用
+        AVFrame* copy = av_frame_clone(f);
+        if (!copy) {
+            std::cerr << "AbrLadder: failed to clone frame\n";
+            return;
+        }
+        branches_[i]->frames->push(copy);
+    });
+}
+
+void AbrLadder::finish() {
+    if (finished_) return;
+    finished_ = true;
+
+    filter_.filterFrame(nullptr, [&](int i, AVFrame* f){
+        AVFrame* copy = av_frame_clone(f);
+        if (copy) branches_[i]->frames->push(copy);
+    });
+
+    for (auto& b : branches_) b->frames->stop();
+    for (auto& b : branches_) {
+        if (b->thread.joinable()) b->thread.join();
+    }
+}
+
+void AbrLadder::encodeLoop(Branch& branch, int index) {
+    AVFrame* frame = nullptr;
+    while (branch.frames->pop(frame)) {
+        if (!frame) continue;
+        if (!branch.encoder->encode(frame, branch.packets)) {
+            std::cerr << "[AbrLadder] rung " << index << " encode failed\n";
+        }
+        branch.encodedFrames++;
+        av_frame_free(&frame);
+    }
+
+    branch.encoder->flush(branch.packets);
+    branch.packets.stop();
+    std::cout << "[AbrLadder] rung " << index << " finished, "
+              << branch.encodedFrames << " frames\n";
+}
@@ -1,4 +1,5 @@
 #include "audiodecoder.h"
+#include "codecpool.h"
 #include <iostream>
 
 AudioDecoder::AudioDecoder(AVCodecParameters* codecpar)
@@ -6,7 +7,9 @@ AudioDecoder::AudioDecoder(AVCodecParameters* codecpar)
 
 AudioDecoder::~AudioDecoder() {
     if (codecCtx_) {
-        avcodec_free_context(&codecCtx_);
+        // 归还到上下文池，下一个同参数的任务直接复用
+        CodecPool::instance().release(poolKey_, codecCtx_);
+        codecCtx_ = nullptr;
     }
 }
 
@@ -19,9 +22,20 @@ bool AudioDecoder::open() {
         return false;
     }
 
-    codecCtx_ = avcodec_alloc_context3(codec);
-    avcodec_parameters_to_context(codecCtx_, codecpar_);
-    if (avcodec_open2(codecCtx_, codec, nullptr) < 0) {
+    // 优先从池中取同参数、已打开的解码器
+    poolKey_ = CodecPool::decoderKey(codecpar_);
+    codecCtx_ = CodecPool::instance().acquire(poolKey_, [&]() -> AVCodecContext* {
+        AVCodecContext* ctx = avcodec_alloc_context3(codec);
+        if (!ctx) return nullptr;
+        avcodec_parameters_to_context(ctx, codecpar_);
+        if (avcodec_open2(ctx, codec, nullptr) < 0) {
+            avcodec_free_context(&ctx);
+            return nullptr;
+        }
+        return ctx;
+    });
+
+    if (!codecCtx_) {
         std::cerr << "Failed to open audio codec\n";
         return false;
     }
@@ -1,5 +1,7 @@
 #include "audioencoder.h"
+#include "codecpool.h"
 #include <iostream>
+#include <sstream>
 
 AudioEncoder::AudioEncoder(AVCodecID codec_id) {
     codec_ = avcodec_find_encoder(codec_id);
@@ -12,34 +14,298 @@ AudioEncoder::~AudioEncoder() {
     close();
 }
 
+void AudioEncoder::setProfile(const EncoderProfile& profile) {
+    profile_ = profile;
+    hasProfile_ = true;
+    if (!profile.codec.empty()) {
+        AVCodec* c = avcodec_find_encoder_by_name(profile.codec.c_str());
+        if (c && c->type == AVMEDIA_TYPE_AUDIO) codec_ = c;
+        else std::cerr << "AudioEncoder: encoder " << profile.codec << " not found, keeping "
+                       << (codec_ ? codec_->name : "none") << "\n";
+    }
+}
+
+std::string AudioEncoder::makePoolKey(int sample_rate, int channels, AVSampleFormat fmt,
+                                      int bitrate) const {
+    std::ostringstream ss;
+    ss << "aenc:" << codec_->name << ":" << sample_rate << ":" << channels
+       << ":" << fmt << ":" << bitrate;
+    if (hasProfile_) ss << ":" << profile_.key();
+    return ss.str();
+}
+
+AVCodecContext* AudioEncoder::createContext(int sample_rate, int channels, AVSampleFormat fmt,
+                                            int bitrate) {
+    AVCodecContext* ctx = avcodec_alloc_context3(codec_);
+    if (!ctx) return nullptr;
+
+    ctx->sample_rate = sample_rate;
+    ctx->channels = channels;
+    ctx->channel_layout = av_get_default_channel_layout(channels);
+    // 编码器支持请求的格式时直接用，省掉一次采样格式转换
+    ctx->sample_fmt = fmt;
+    if (codec_->sample_fmts) {
+        ctx->sample_fmt = codec_->sample_fmts[0];
+        for (const AVSampleFormat* f = codec_->sample_fmts; *f != AV_SAMPLE_FMT_NONE; ++f) {
+            if (*f == fmt) ctx->sample_fmt = fmt;
+        }
+    }
+    ctx->bit_rate = bitrate;
+    if (hasProfile_) profile_.applyTo(ctx);
+
+    if (avcodec_open2(ctx, codec_, nullptr) < 0) {
+        avcodec_free_context(&ctx);
+        return nullptr;
+    }
+    return ctx;
+}
+
 bool AudioEncoder::open(int sample_rate, int channels, AVSampleFormat fmt, int bitrate) {
     if (!codec_) return false;
 
-    codecCtx_ = avcodec_alloc_context3(codec_);
-    if (!codecCtx_) return false;
-
-    codecCtx_->sample_rate = sample_rate;
-    codecCtx_->channels = channels;
-    codecCtx_->channel_layout = av_get_default_channel_layout(channels);
-    codecCtx_->sample_fmt = (codec_->sample_fmts) ? codec_->sample_fmts[0] : fmt;
-    codecCtx_->bit_rate = bitrate;
+    close();
 
-    if (avcodec_open2(codecCtx_, codec_, nullptr) < 0) {
+    poolKey_ = makePoolKey(sample_rate, channels, fmt, bitrate);
+    codecCtx_ = CodecPool::instance().acquire(poolKey_, [&]() {
+        return createContext(sample_rate, channels, fmt, bitrate);
+    });
+    if (!codecCtx_) {
         std::cerr << "AudioEncoder: failed to open codec\n";
         return false;
     }
+
+    passthrough_ = (codec_->capabilities & AV_CODEC_CAP_VARIABLE_FRAME_SIZE) ||
+                   codecCtx_->frame_size <= 0;
+    if (!passthrough_ &&
+        !assembler_.init(codecCtx_->sample_fmt, codecCtx_->channels, codecCtx_->channel_layout,
+                         codecCtx_->sample_rate, codecCtx_->frame_size)) {
+        close();
+        return false;
+    }
+
+    if (parallel_ > 1 && !startParallel()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool AudioEncoder::parallelSupported() const {
+    // 有编码延迟的编码器输入输出不是一一对应，预热帧的包无法准确丢弃
+    if (codec_->capabilities & AV_CODEC_CAP_DELAY) return false;
+    if (av_get_exact_bits_per_sample(codec_->id) > 0) return true;   // PCM
+    switch (codec_->id) {
+    case AV_CODEC_ID_AC3:
+    case AV_CODEC_ID_MP2:
+        // 44.1 / 22.05 kHz 时每帧是否填充取决于之前累计写出的位数，各实例独立编码会得到不同的帧长
+        return codecCtx_->sample_rate % 11025 != 0;
+    default:
+        return false;
+    }
+}
+
+bool AudioEncoder::startParallel() {
+    if (!parallelSupported()) {
+        std::cerr << "AudioEncoder: " << codec_->name << " at " << codecCtx_->sample_rate
+                  << " Hz has inter-frame state, encoding serially\n";
+        return true;
+    }
+
+    // 与 codecCtx_ 参数相同的其余实例（池中没有空闲实例时新建）
+    AVCodecContext* ref = codecCtx_;
+    for (int i = 1; i < parallel_; ++i) {
+        AVCodecContext* ctx = CodecPool::instance().acquire(poolKey_, [&]() {
+            return createContext(ref->sample_rate, ref->channels, ref->sample_fmt, (int)ref->bit_rate);
+        });
+        if (!ctx) {
+            std::cerr << "AudioEncoder: failed to open parallel encoder instance\n";
+            return false;
+        }
+        extraCtx_.push_back(ctx);
+    }
+
+    primeBatches_ = av_get_exact_bits_per_sample(codec_->id) == 0;
+    stop_ = false;
+    workers_.emplace_back(&AudioEncoder::workerLoop, this, codecCtx_);
+    for (AVCodecContext* ctx : extraCtx_) workers_.emplace_back(&AudioEncoder::workerLoop, this, ctx);
+    return true;
+}
+
+void AudioEncoder::stopParallel() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cond_.notify_all();
+    for (auto& t : workers_) t.join();
+    workers_.clear();
+
+    for (AVCodecContext* ctx : extraCtx_) CodecPool::instance().release(poolKey_, ctx);
+    extraCtx_.clear();
+
+    auto freeBatch = [](Batch* b) {
+        av_frame_free(&b->prime);
+        for (AVFrame* f : b->frames) av_frame_free(&f);
+        for (AVPacket* p : b->packets) av_packet_free(&p);
+        delete b;
+    };
+    // pending_ 中的批次也都在 inFlight_ 里
+    for (auto& kv : inFlight_) freeBatch(kv.second);
+    inFlight_.clear();
+    pending_.clear();
+    if (current_) freeBatch(current_);
+    current_ = nullptr;
+    av_frame_free(&lastFrame_);
+    nextBatch_ = 0;
+    nextEmit_ = 0;
+}
+
+void AudioEncoder::queueFrame(AVFrame* frame, PacketQueue<AVPacket*>& pktQueue) {
+    if (!current_) {
+        current_ = new Batch();
+        current_->index = nextBatch_++;
+        current_->prime = lastFrame_;
+        lastFrame_ = nullptr;
+    }
+    current_->frames.push_back(frame);
+    if ((int)current_->frames.size() >= batchFrames_) submitBatch(pktQueue);
+}
+
+void AudioEncoder::submitBatch(PacketQueue<AVPacket*>& pktQueue) {
+    if (!current_) return;
+    // 下一批的预热帧
+    av_frame_free(&lastFrame_);
+    if (primeBatches_) lastFrame_ = av_frame_clone(current_->frames.back());
+
+    // 在途批次过多时先等最早的一批编完并输出，限制缓存的样本量
+    for (;;) {
+        int64_t oldest;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if ((int)inFlight_.size() < 2 * (int)workers_.size()) break;
+            oldest = nextEmit_;
+        }
+        emitReady(pktQueue, oldest + 1);
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    inFlight_[current_->index] = current_;
+    pending_.push_back(current_);
+    current_ = nullptr;
+    lock.unlock();
+    cond_.notify_one();
+}
+
+void AudioEncoder::emitReady(PacketQueue<AVPacket*>& pktQueue, int64_t waitBefore) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        auto it = inFlight_.find(nextEmit_);
+        if (it == inFlight_.end()) return;
+        if (!it->second->done) {
+            if (nextEmit_ >= waitBefore) return;
+            Batch* b = it->second;
+            doneCond_.wait(lock, [&] { return b->done; });
+        }
+        Batch* b = it->second;
+        inFlight_.erase(it);
+        ++nextEmit_;
+        lock.unlock();
+
+        if (!b->ok) std::cerr << "AudioEncoder: batch " << b->index << " failed\n";
+        for (AVPacket* p : b->packets) pktQueue.push(p);
+        b->packets.clear();
+        for (AVFrame* f : b->frames) av_frame_free(&f);
+        av_frame_free(&b->prime);
+        delete b;
+
+        lock.lock();
+    }
+}
+
+void AudioEncoder::workerLoop(AVCodecContext* ctx) {
+    AVPacket* pkt = av_packet_alloc();
+    for (;;) {
+        Batch* b = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cond_.wait(lock, [&] { return !pending_.empty() || stop_; });
+            if (stop_) break;
+            b = pending_.front();
+            pending_.pop_front();
+        }
+
+        // 预热帧只用来填充编码器的历史样本，它的包丢掉
+        if (b->prime && avcodec_send_frame(ctx, b->prime) >= 0) {
+            while (avcodec_receive_packet(ctx, pkt) == 0) av_packet_unref(pkt);
+        }
+        for (AVFrame* f : b->frames) {
+            if (avcodec_send_frame(ctx, f) < 0) {
+                b->ok = false;
+                break;
+            }
+            while (avcodec_receive_packet(ctx, pkt) == 0) {
+                b->packets.push_back(pkt);
+                pkt = av_packet_alloc();
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            b->done = true;
+        }
+        doneCond_.notify_all();
+    }
+    av_packet_free(&pkt);
+}
+
+bool AudioEncoder::prewarm(int sample_rate, int channels, AVSampleFormat fmt, int bitrate, int count) {
+    if (!codec_) return false;
+
+    CodecPool::instance().prewarm(makePoolKey(sample_rate, channels, fmt, bitrate), [&]() {
+        return createContext(sample_rate, channels, fmt, bitrate);
+    }, count);
     return true;
 }
 
 void AudioEncoder::close() {
+    stopParallel();
+    assembler_.reset();
+    passthrough_ = true;
     if (codecCtx_) {
-        avcodec_free_context(&codecCtx_);
+        CodecPool::instance().release(poolKey_, codecCtx_);
+        codecCtx_ = nullptr;
     }
 }
 
 bool AudioEncoder::encode(AVFrame* frame, PacketQueue<AVPacket*>& pktQueue) {
     if (!frame || !codecCtx_) return false;
 
+    if (passthrough_) {
+        if (!parallel()) return sendFrame(frame, pktQueue);
+        AVFrame* ref = av_frame_clone(frame);
+        if (!ref) return false;
+        queueFrame(ref, pktQueue);
+        emitReady(pktQueue, 0);
+        return true;
+    }
+
+    if (!assembler_.push(frame)) return false;
+
+    bool ok = true;
+    AVFrame* encFrame = nullptr;
+    while ((encFrame = assembler_.pop()) != nullptr) {
+        if (parallel()) {
+            queueFrame(encFrame, pktQueue);
+            continue;
+        }
+        ok = sendFrame(encFrame, pktQueue) && ok;
+        av_frame_free(&encFrame);
+    }
+    if (parallel()) emitReady(pktQueue, 0);
+    return ok;
+}
+
+bool AudioEncoder::sendFrame(AVFrame* frame, PacketQueue<AVPacket*>& pktQueue) {
     int ret = avcodec_send_frame(codecCtx_, frame);
     if (ret < 0) {
         std::cerr << "AudioEncoder: send_frame failed\n";
@@ -58,6 +324,24 @@ bool AudioEncoder::encode(AVFrame* frame, PacketQueue<AVPacket*>& pktQueue) {
 
 void AudioEncoder::flush(PacketQueue<AVPacket*>& pktQueue) {
     if (!codecCtx_) return;
+
+    if (!passthrough_) {
+        AVFrame* encFrame = assembler_.pop(true);
+        if (encFrame && parallel()) {
+            queueFrame(encFrame, pktQueue);
+        } else if (encFrame) {
+            sendFrame(encFrame, pktQueue);
+            av_frame_free(&encFrame);
+        }
+    }
+
+    if (parallel()) {
+        // 并行模式只支持没有编码延迟的编码器，等所有批次输出即可
+        submitBatch(pktQueue);
+        emitReady(pktQueue, nextBatch_);
+        return;
+    }
+
     avcodec_send_frame(codecCtx_, nullptr);
     AVPacket* pkt = av_packet_alloc();
     while (avcodec_receive_packet(codecCtx_, pkt) == 0) {
@@ -4,6 +4,7 @@
 #include <sstream>
 #include <vector>
 #include <cmath>
+#include <algorithm>
 
 extern "C" {
 #include <libavutil/opt.h>
@@ -15,6 +16,15 @@ AudioFilter::AudioFilter() {}
 AudioFilter::~AudioFilter() { close(); }
 
 void AudioFilter::close() {
+    for (auto& kv : adapters_) avfilter_graph_free(&kv.second.graph);
+    adapters_.clear();
+    activeAdapter_ = nullptr;
+
+    if (tail_.graph) avfilter_graph_free(&tail_.graph);
+    tail_ = AdapterGraph();
+    stretch_.reset();
+    stretchPts_ = AV_NOPTS_VALUE;
+
     if (graph_) avfilter_graph_free(&graph_);
     graph_ = nullptr;
     srcCtx_ = nullptr;
@@ -63,8 +73,28 @@ bool AudioFilter::init(AVCodecContext* decCtx, double speed,
                         (decCtx->channel_layout ? decCtx->channel_layout :
                          av_get_default_channel_layout(decCtx->channels));
 
+    inSampleRate_ = decCtx->sample_rate;
+    inSampleFmt_ = decCtx->sample_fmt;
+    inChannelLayout_ = decCtx->channel_layout ? decCtx->channel_layout :
+                       av_get_default_channel_layout(decCtx->channels);
+
     std::string atempoChain;
-    if (!build_atempo_chain(speed, atempoChain)) {
+    AVSampleFormat graphOutFmt = outSampleFmt_;
+    if (useNativeStretch_ && speed > 0.0 && fabs(speed - 1.0) >= 1e-6) {
+        // 单级变速：滤镜图只负责转成 FLTP，变速和最终格式转换在图外完成
+        stretch_.reset(new TimeStretch());
+        if (!stretch_->init(av_get_channel_layout_nb_channels(outChannelLayout_), outSampleRate_, speed)) {
+            std::cerr << "Failed to init TimeStretch\n";
+            return false;
+        }
+        graphOutFmt = AV_SAMPLE_FMT_FLTP;
+        if (outSampleFmt_ != AV_SAMPLE_FMT_FLTP &&
+            !buildConvertGraph(outSampleRate_, AV_SAMPLE_FMT_FLTP, outChannelLayout_,
+                               outSampleRate_, outSampleFmt_, outChannelLayout_, tail_)) {
+            std::cerr << "Failed to build output conversion graph\n";
+            return false;
+        }
+    } else if (!build_atempo_chain(speed, atempoChain)) {
         std::cerr << "Failed to build atempo chain\n";
         return false;
     }
@@ -92,7 +122,7 @@ bool AudioFilter::init(AVCodecContext* decCtx, double speed,
     if (ret < 0) { print_av_error(ret, "create abuffersink"); return false; }
 
     std::string filterDesc = atempoChain.empty() ? "" : atempoChain + ",";
-    filterDesc += "aformat=sample_fmts=" + std::string(av_get_sample_fmt_name(outSampleFmt_)) +
+    filterDesc += "aformat=sample_fmts=" + std::string(av_get_sample_fmt_name(graphOutFmt)) +
                   ":sample_rates=" + std::to_string(outSampleRate_) +
                   ":channel_layouts=" + std::to_string(outChannelLayout_);
 
@@ -125,8 +155,67 @@ bool AudioFilter::init(AVCodecContext* decCtx, double speed,
 
 void AudioFilter::filterFrame(AVFrame* frame, std::function<void(AVFrame*)> callback) {
     if (!initialized_ || !graph_ || !srcCtx_ || !sinkCtx_) return;
-    if (!frame) return;
 
+    if (!frame) {
+        // flush：先把转换图里残留的样本送进主图，再结束主图
+        drainAdapter(callback);
+        feedMain(nullptr, callback);
+        return;
+    }
+
+    uint64_t layout = frame->channel_layout ? frame->channel_layout :
+                      av_get_default_channel_layout(frame->channels);
+    if (frame->sample_rate == inSampleRate_ && frame->format == inSampleFmt_ &&
+        layout == inChannelLayout_) {
+        drainAdapter(callback);
+        feedMain(frame, callback);
+        return;
+    }
+
+    AdapterGraph* adapter = getAdapter(frame->sample_rate, frame->format, layout);
+    if (!adapter) return;
+    if (adapter != activeAdapter_) {
+        // 从另一个转换图切过来：先排空它（不会释放 adapter，两者配置不同）
+        drainAdapter(callback);
+        activeAdapter_ = adapter;
+    }
+
+    int ret = av_buffersrc_add_frame_flags(adapter->src, frame, AV_BUFFERSRC_FLAG_KEEP_REF);
+    if (ret < 0) { print_av_error(ret, "adapter add_frame"); return; }
+
+    AVFrame* adapted = av_frame_alloc();
+    while (av_buffersink_get_frame(adapter->sink, adapted) >= 0) {
+        feedMain(adapted, callback);
+        av_frame_unref(adapted);
+    }
+    av_frame_free(&adapted);
+}
+
+void AudioFilter::drainAdapter(const std::function<void(AVFrame*)>& callback) {
+    if (!activeAdapter_) return;
+
+    // 重采样器里还留着的样本在切走之前送进主图，保证样本和 pts 连续
+    if (av_buffersrc_add_frame_flags(activeAdapter_->src, nullptr, 0) >= 0) {
+        AVFrame* adapted = av_frame_alloc();
+        while (av_buffersink_get_frame(activeAdapter_->sink, adapted) >= 0) {
+            feedMain(adapted, callback);
+            av_frame_unref(adapted);
+        }
+        av_frame_free(&adapted);
+    }
+
+    // 已经收到 EOF 的图不能再用，从缓存中去掉，下次切回这一配置时重建
+    for (auto it = adapters_.begin(); it != adapters_.end(); ++it) {
+        if (&it->second == activeAdapter_) {
+            avfilter_graph_free(&it->second.graph);
+            adapters_.erase(it);
+            break;
+        }
+    }
+    activeAdapter_ = nullptr;
+}
+
+void AudioFilter::feedMain(AVFrame* frame, const std::function<void(AVFrame*)>& callback) {
     int ret = av_buffersrc_add_frame_flags(srcCtx_, frame, AV_BUFFERSRC_FLAG_KEEP_REF);
     if (ret < 0) { print_av_error(ret, "av_buffersrc_add_frame_flags"); return; }
 
@@ -135,8 +224,137 @@ void AudioFilter::filterFrame(AVFrame* frame, std::function<void(AVFrame*)> call
         ret = av_buffersink_get_frame(sinkCtx_, filt);
         if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) break;
         if (ret < 0) { print_av_error(ret, "buffersink_get_frame"); break; }
-        callback(filt);
+        if (stretch_) stretchFrame(filt, callback);
+        else callback(filt);
         av_frame_unref(filt);
     }
     av_frame_free(&filt);
+
+    if (!frame && stretch_) {
+        // 主图已排空：变速器补静音输出剩余样本，再结束输出转换图
+        stretch_->flush();
+        emitStretched(callback);
+        if (tail_.graph) deliver(nullptr, callback);
+    }
+}
+
+void AudioFilter::stretchFrame(AVFrame* frame, const std::function<void(AVFrame*)>& callback) {
+    // 主图输出的时间基是 1/sample_rate，输出 pts 从第一帧开始按样本数累加
+    if (stretchPts_ == AV_NOPTS_VALUE) stretchPts_ = frame->pts != AV_NOPTS_VALUE ? frame->pts : 0;
+
+    stretch_->push((const float* const*)frame->extended_data, frame->nb_samples);
+    emitStretched(callback);
+}
+
+void AudioFilter::emitStretched(const std::function<void(AVFrame*)>& callback) {
+    const int maxSamples = 1024;
+    while (stretch_->available() > 0) {
+        AVFrame* out = av_frame_alloc();
+        if (!out) return;
+        out->format = AV_SAMPLE_FMT_FLTP;
+        out->sample_rate = outSampleRate_;
+        out->channel_layout = outChannelLayout_;
+        out->channels = stretch_->channels();
+        out->nb_samples = std::min(maxSamples, stretch_->available());
+        if (av_frame_get_buffer(out, 0) < 0) {
+            av_frame_free(&out);
+            return;
+        }
+
+        out->nb_samples = stretch_->read((float* const*)out->extended_data, out->nb_samples);
+        out->pts = stretchPts_ == AV_NOPTS_VALUE ? 0 : stretchPts_;
+        stretchPts_ = out->pts + out->nb_samples;
+
+        deliver(out, callback);
+        av_frame_free(&out);
+    }
+}
+
+void AudioFilter::deliver(AVFrame* frame, const std::function<void(AVFrame*)>& callback) {
+    if (!tail_.graph) {
+        callback(frame);
+        return;
+    }
+
+    int ret = av_buffersrc_add_frame_flags(tail_.src, frame, AV_BUFFERSRC_FLAG_KEEP_REF);
+    if (ret < 0) { print_av_error(ret, "tail add_frame"); return; }
+
+    AVFrame* conv = av_frame_alloc();
+    while (av_buffersink_get_frame(tail_.sink, conv) >= 0) {
+        callback(conv);
+        av_frame_unref(conv);
+    }
+    av_frame_free(&conv);
+}
+
+AudioFilter::AdapterGraph* AudioFilter::getAdapter(int sampleRate, int sampleFmt, uint64_t channelLayout) {
+    std::string key = std::to_string(sampleRate) + ":" + std::to_string(sampleFmt) + ":" +
+                      std::to_string(channelLayout);
+
+    auto it = adapters_.find(key);
+    if (it != adapters_.end()) return &it->second;
+
+    std::cout << "[AudioFilter] input changed to " << sampleRate << " Hz, fmt " << sampleFmt
+              << ", layout 0x" << std::hex << channelLayout << std::dec << ", building adapter\n";
+
+    AdapterGraph a;
+    if (!buildConvertGraph(sampleRate, sampleFmt, channelLayout,
+                           inSampleRate_, inSampleFmt_, inChannelLayout_, a)) {
+        avfilter_graph_free(&a.graph);
+        return nullptr;
+    }
+    return &adapters_.emplace(key, a).first->second;
+}
+
+bool AudioFilter::buildConvertGraph(int srcRate, int srcFmt, uint64_t srcLayout,
+                                    int dstRate, int dstFmt, uint64_t dstLayout, AdapterGraph& a) {
+    a.graph = avfilter_graph_alloc();
+    if (!a.graph) return false;
+
+    char args[512];
+    snprintf(args, sizeof(args),
+             "time_base=1/%d:sample_rate=%d:sample_fmt=%s:channel_layout=0x%llx",
+             srcRate, srcRate,
+             av_get_sample_fmt_name((AVSampleFormat)srcFmt),
+             (unsigned long long)srcLayout);
+
+    int ret = avfilter_graph_create_filter(&a.src, avfilter_get_by_name("abuffer"), "src",
+                                           args, nullptr, a.graph);
+    if (ret < 0) { print_av_error(ret, "create convert abuffer"); return false; }
+
+    ret = avfilter_graph_create_filter(&a.sink, avfilter_get_by_name("abuffersink"), "sink",
+                                       nullptr, nullptr, a.graph);
+    if (ret < 0) { print_av_error(ret, "create convert abuffersink"); return false; }
+
+    std::string filterDesc = "aformat=sample_fmts=" + std::string(av_get_sample_fmt_name((AVSampleFormat)dstFmt)) +
+                             ":sample_rates=" + std::to_string(dstRate) +
+                             ":channel_layouts=" + std::to_string(dstLayout);
+
+    AVFilterInOut* outputs = avfilter_inout_alloc();
+    AVFilterInOut* inputs  = avfilter_inout_alloc();
+    if (!outputs || !inputs) {
+        avfilter_inout_free(&outputs);
+        avfilter_inout_free(&inputs);
+        return false;
+    }
+
+    outputs->name       = av_strdup("in");
+    outputs->filter_ctx = a.src;
+    outputs->pad_idx    = 0;
+    outputs->next       = nullptr;
+
+    inputs->name        = av_strdup("out");
+    inputs->filter_ctx  = a.sink;
+    inputs->pad_idx     = 0;
+    inputs->next        = nullptr;
+
+    ret = avfilter_graph_parse_ptr(a.graph, filterDesc.c_str(), &inputs, &outputs, nullptr);
+    avfilter_inout_free(&inputs);
+    avfilter_inout_free(&outputs);
+    if (ret < 0) { print_av_error(ret, "parse convert graph"); return false; }
+
+    ret = avfilter_graph_config(a.graph, nullptr);
+    if (ret < 0) { print_av_error(ret, "config convert graph"); return false; }
+
+    return true;
 }
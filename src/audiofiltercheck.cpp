@@ -0,0 +1,101 @@
+#include <iostream>
+#include <cstdint>
+#include <cstdlib>
+
+#include "audiofilter.h"
+extern "C" {
+#include <libavutil/channel_layout.h>
+#include <libavutil/samplefmt.h>
+}
+
+// AudioFilter 输入格式中途切换的检查：48 kHz FLTP（与 init 一致，直接进主图）和 44.1 kHz S16
+// （经转换图重采样）交替出现 native -> A -> native -> A，最后 flush。
+// 输出的 pts 应当逐帧衔接（上一帧 pts + 样本数），总样本数应与输入时长一致；
+// 切换时转换图里残留的样本丢失或在之后以旧 pts 出现都会被发现。有不一致时返回 1
+
+static const int kOutRate = 48000;
+static const int kRateA = 44100;
+static const int kFramesPerSegment = 100;   // 每帧 10 ms，每段 1 秒
+// 重采样的取整和滤波器延迟允许的误差（样本）
+static const int kTolerance = 16;
+
+static AVFrame* makeFrame(int sampleRate, AVSampleFormat fmt, int64_t pts, int64_t& phase) {
+    AVFrame* f = av_frame_alloc();
+    if (!f) return nullptr;
+    f->format = fmt;
+    f->sample_rate = sampleRate;
+    f->channel_layout = AV_CH_LAYOUT_STEREO;
+    f->channels = 2;
+    f->nb_samples = sampleRate / 100;
+    f->pts = pts;
+    if (av_frame_get_buffer(f, 0) < 0) {
+        av_frame_free(&f);
+        return nullptr;
+    }
+    // 锯齿波，内容本身不检查，只要不是静音
+    for (int i = 0; i < f->nb_samples; ++i, ++phase) {
+        float v = (float)(phase % 200) / 200.0f - 0.5f;
+        if (fmt == AV_SAMPLE_FMT_FLTP) {
+            ((float*)f->extended_data[0])[i] = v;
+            ((float*)f->extended_data[1])[i] = -v;
+        } else {
+            int16_t* s = (int16_t*)f->extended_data[0];
+            s[2 * i] = (int16_t)(v * 20000);
+            s[2 * i + 1] = (int16_t)(-v * 20000);
+        }
+    }
+    return f;
+}
+
+int main() {
+    AVCodecContext* decCtx = avcodec_alloc_context3(nullptr);
+    if (!decCtx) return 1;
+    decCtx->sample_rate = kOutRate;
+    decCtx->sample_fmt = AV_SAMPLE_FMT_FLTP;
+    decCtx->channel_layout = AV_CH_LAYOUT_STEREO;
+    decCtx->channels = 2;
+
+    AudioFilter filter;
+    if (!filter.init(decCtx, 1.0, AV_SAMPLE_FMT_FLTP)) {
+        std::cerr << "[audiofiltercheck] init failed\n";
+        avcodec_free_context(&decCtx);
+        return 1;
+    }
+
+    int64_t expectedPts = AV_NOPTS_VALUE;
+    int64_t totalSamples = 0;
+    int errors = 0;
+    auto onFrame = [&](AVFrame* out) {
+        if (expectedPts != AV_NOPTS_VALUE && llabs(out->pts - expectedPts) > kTolerance) {
+            if (errors++ < 5)
+                std::cout << "[audiofiltercheck] pts " << out->pts << ", expected " << expectedPts << "\n";
+        }
+        expectedPts = out->pts + out->nb_samples;
+        totalSamples += out->nb_samples;
+    };
+
+    // native -> A -> native -> A，每段 1 秒，时间在各自的采样率下连续
+    const bool segmentIsA[] = {false, true, false, true};
+    int64_t phase = 0;
+    int segments = 0;
+    for (bool a : segmentIsA) {
+        int rate = a ? kRateA : kOutRate;
+        for (int i = 0; i < kFramesPerSegment; ++i) {
+            int64_t pts = (int64_t)segments * rate + (int64_t)i * (rate / 100);
+            AVFrame* f = makeFrame(rate, a ? AV_SAMPLE_FMT_S16 : AV_SAMPLE_FMT_FLTP, pts, phase);
+            if (!f) return 1;
+            filter.filterFrame(f, onFrame);
+            av_frame_free(&f);
+        }
+        ++segments;
+    }
+    filter.filterFrame(nullptr, onFrame);
+
+    int64_t expectedTotal = (int64_t)segments * kOutRate;
+    bool ok = errors == 0 && llabs(totalSamples - expectedTotal) <= segments * kTolerance;
+    std::cout << "[audiofiltercheck] native/44.1k switching: " << totalSamples << " samples (expected "
+              << expectedTotal << "), " << errors << " pts discontinuities " << (ok ? "ok" : "FAILED") << "\n";
+
+    avcodec_free_context(&decCtx);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,84 @@
+#include "audioframeassembler.h"
+#include <iostream>
+extern "C" {
+#include <libavutil/channel_layout.h>
+}
+
+AudioFrameAssembler::~AudioFrameAssembler() {
+    reset();
+}
+
+void AudioFrameAssembler::reset() {
+    if (fifo_) av_audio_fifo_free(fifo_);
+    fifo_ = nullptr;
+    nextPts_ = AV_NOPTS_VALUE;
+}
+
+bool AudioFrameAssembler::init(AVSampleFormat fmt, int channels, uint64_t channelLayout,
+                               int sampleRate, int frameSize) {
+    reset();
+    if (fmt == AV_SAMPLE_FMT_NONE || channels <= 0 || frameSize <= 0) return false;
+
+    fmt_ = fmt;
+    channels_ = channels;
+    channelLayout_ = channelLayout ? channelLayout : av_get_default_channel_layout(channels);
+    sampleRate_ = sampleRate;
+    frameSize_ = frameSize;
+
+    // 预留两帧，AVAudioFifo 不够时自动扩容
+    fifo_ = av_audio_fifo_alloc(fmt_, channels_, frameSize_ * 2);
+    if (!fifo_) {
+        std::cerr << "AudioFrameAssembler: failed to alloc fifo\n";
+        return false;
+    }
+    return true;
+}
+
+bool AudioFrameAssembler::push(const AVFrame* frame) {
+    if (!fifo_ || !frame || frame->nb_samples <= 0) return false;
+
+    if (frame->format != fmt_ || frame->channels != channels_) {
+        std::cerr << "AudioFrameAssembler: frame format/channel mismatch\n";
+        return false;
+    }
+
+    // 以第一帧 pts 为起点，之后按样本数推算，中间帧的 pts 不再参与
+    if (nextPts_ == AV_NOPTS_VALUE)
+        nextPts_ = frame->pts != AV_NOPTS_VALUE ? frame->pts : 0;
+
+    int ret = av_audio_fifo_write(fifo_, (void**)frame->extended_data, frame->nb_samples);
+    if (ret < frame->nb_samples) {
+        std::cerr << "AudioFrameAssembler: fifo write failed\n";
+        return false;
+    }
+    return true;
+}
+
+AVFrame* AudioFrameAssembler::pop(bool padFinal) {
+    int avail = size();
+    if (avail <= 0 || (avail < frameSize_ && !padFinal)) return nullptr;
+
+    AVFrame* out = av_frame_alloc();
+    if (!out) return nullptr;
+    out->nb_samples = frameSize_;
+    out->format = fmt_;
+    out->channels = channels_;
+    out->channel_layout = channelLayout_;
+    out->sample_rate = sampleRate_;
+    if (av_frame_get_buffer(out, 0) < 0) {
+        av_frame_free(&out);
+        return nullptr;
+    }
+
+    int n = av_audio_fifo_read(fifo_, (void**)out->extended_data, frameSize_);
+    if (n < 0) {
+        av_frame_free(&out);
+        return nullptr;
+    }
+    if (n < frameSize_)
+        av_samples_set_silence(out->extended_data, n, frameSize_ - n, channels_, fmt_);
+
+    out->pts = nextPts_;
+    nextPts_ += frameSize_;
+    return out;
+}
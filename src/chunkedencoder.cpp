@@ -0,0 +1,261 @@
+#include "chunkedencoder.h"
+#include "videoencoder.h"
+#include <iostream>
+#include <algorithm>
+#include <thread>
+
+ChunkedEncoder::ChunkedEncoder(int workers, int chunkFrames, AVCodecID codec_id)
+    : codecId_(codec_id), workers_(std::max(1, workers)), chunkFrames_(std::max(1, chunkFrames)) {}
+
+ChunkedEncoder::~ChunkedEncoder() {
+    close();
+}
+
+bool ChunkedEncoder::open(int width, int height, AVRational time_base, AVPixelFormat pix_fmt,
+                          int fps, int maxGop) {
+    close();
+    width_ = width;
+    height_ = height;
+    timeBase_ = time_base;
+    pixFmt_ = pix_fmt;
+    fps_ = fps;
+    maxGop_ = maxGop;
+
+    // 先按段编码器的参数打开一次，拿到 extradata。
+    // libx264 不支持 ENCODER_FLUSH，这个实例归还时被释放，不会留给第一个段复用
+    VideoEncoder probe(codecId_);
+    probe.setProfile(chunkProfile());
+    probe.setSceneCutKeyframes(sceneCut_, maxGop_);
+    probe.setRoiEncoding(roi_);
+    probe.setGlobalHeader(globalHeader_);
+    if (!probe.open(width, height, time_base, pix_fmt, fps)) {
+        std::cerr << "ChunkedEncoder: failed to open encoder\n";
+        return false;
+    }
+    codecpar_ = avcodec_parameters_alloc();
+    if (!codecpar_ || avcodec_parameters_from_context(codecpar_, probe.getCodecContext()) < 0) {
+        avcodec_parameters_free(&codecpar_);
+        return false;
+    }
+    probe.close();
+
+    stop_ = false;
+    failed_ = false;
+    for (int i = 0; i < workers_; ++i) threads_.emplace_back(&ChunkedEncoder::workerLoop, this);
+    return true;
+}
+
+void ChunkedEncoder::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+        // 未编码的帧直接丢弃
+        if (current_) current_->closed = true;
+        for (auto& kv : inFlight_) kv.second->closed = true;
+    }
+    cond_.notify_all();
+    spaceCond_.notify_all();
+    for (auto& t : threads_) t.join();
+    threads_.clear();
+
+    for (auto& kv : inFlight_) {
+        for (AVFrame* f : kv.second->frames) av_frame_free(&f);
+        for (AVPacket* p : kv.second->packets) av_packet_free(&p);
+    }
+    inFlight_.clear();
+    waiting_.clear();
+    current_.reset();
+    currentFrames_ = 0;
+    nextIndex_ = 0;
+    nextEmit_ = 0;
+    buffered_ = 0;
+    wallMs_ = 0.0;
+    encodeMs_ = 0.0;
+    avcodec_parameters_free(&codecpar_);
+}
+
+EncoderProfile ChunkedEncoder::chunkProfile() const {
+    EncoderProfile p = profile_;
+    if (p.threads <= 0)
+        p.threads = std::max(1, (int)std::thread::hardware_concurrency() / workers_);
+    return p;
+}
+
+// 以下两个函数在持有 mutex_ 时调用
+void ChunkedEncoder::startChunk() {
+    current_ = std::make_shared<Chunk>();
+    current_->index = nextIndex_++;
+    currentFrames_ = 0;
+    inFlight_[current_->index] = current_;
+    waiting_.push_back(current_);
+}
+
+void ChunkedEncoder::closeChunk() {
+    if (!current_) return;
+    current_->closed = true;
+    current_.reset();
+}
+
+bool ChunkedEncoder::encode(AVFrame* frame, PacketQueue<AVPacket*>& pktQueue) {
+    if (!frame || threads_.empty()) return false;
+
+    AVFrame* ref = av_frame_clone(frame);
+    if (!ref) return false;
+
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (nextIndex_ == 0) start_ = std::chrono::steady_clock::now();
+
+        // 缓冲满时等待工作线程消耗
+        spaceCond_.wait(lock, [&] { return buffered_ < workers_ * chunkFrames_ || stop_ || failed_; });
+        if (stop_ || failed_) {
+            av_frame_free(&ref);
+            return false;
+        }
+
+        bool keyframe = ref->pict_type == AV_PICTURE_TYPE_I || ref->key_frame;
+        if (current_ && (currentFrames_ >= 2 * chunkFrames_ || (currentFrames_ >= chunkFrames_ && keyframe)))
+            closeChunk();
+        if (!current_) startChunk();
+
+        current_->frames.push_back(ref);
+        ++currentFrames_;
+        ++buffered_;
+    }
+    cond_.notify_all();
+
+    emitReady(pktQueue);
+    return true;
+}
+
+void ChunkedEncoder::flush(PacketQueue<AVPacket*>& pktQueue) {
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        closeChunk();
+    }
+    cond_.notify_all();
+
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        spaceCond_.wait(lock, [&] {
+            for (auto& kv : inFlight_)
+                if (!kv.second->done) return false;
+            return true;
+        });
+        if (nextIndex_ > 0)
+            wallMs_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_).count();
+    }
+    emitReady(pktQueue);
+}
+
+void ChunkedEncoder::emitReady(PacketQueue<AVPacket*>& pktQueue) {
+    std::vector<std::shared_ptr<Chunk>> ready;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = inFlight_.find(nextEmit_);
+        while (it != inFlight_.end() && it->second->done) {
+            ready.push_back(it->second);
+            inFlight_.erase(it);
+            it = inFlight_.find(++nextEmit_);
+        }
+    }
+
+    for (auto& c : ready) {
+        encodeMs_ += c->encodeMs;
+        // 段首 dts 可能落到前一段之前（可变帧率时编码器外推），由 Muxer 统一修正
+        for (AVPacket* pkt : c->packets) pktQueue.push(pkt);
+        c->packets.clear();
+    }
+}
+
+void ChunkedEncoder::workerLoop() {
+    for (;;) {
+        std::shared_ptr<Chunk> c;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cond_.wait(lock, [&] { return !waiting_.empty() || stop_; });
+            if (stop_) return;
+            c = waiting_.front();
+            waiting_.pop_front();
+        }
+        encodeChunk(c);
+    }
+}
+
+void ChunkedEncoder::encodeChunk(const std::shared_ptr<Chunk>& c) {
+    // 只统计编码器本身的耗时，不含等待输入帧的时间
+    double workMs = 0.0;
+    auto t0 = std::chrono::steady_clock::now();
+    auto lap = [&] {
+        auto now = std::chrono::steady_clock::now();
+        workMs += std::chrono::duration<double, std::milli>(now - t0).count();
+        t0 = now;
+    };
+
+    // 每段一个新的编码器实例（来自上下文池），第一帧强制为 IDR
+    VideoEncoder enc(codecId_);
+    enc.setProfile(chunkProfile());
+    enc.setSceneCutKeyframes(sceneCut_, maxGop_);
+    enc.setRoiEncoding(roi_);
+    enc.setGlobalHeader(globalHeader_);
+    bool ok = enc.open(width_, height_, timeBase_, pixFmt_, fps_);
+    lap();
+    if (!ok) std::cerr << "ChunkedEncoder: failed to open encoder for chunk " << c->index << "\n";
+
+    PacketQueue<AVPacket*> out;
+    auto drain = [&] {
+        while (!out.empty()) c->packets.push_back(out.pop());
+    };
+
+    bool first = true;
+    for (;;) {
+        AVFrame* frame = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cond_.wait(lock, [&] { return !c->frames.empty() || c->closed || stop_; });
+            if (stop_ || c->frames.empty()) break;
+            frame = c->frames.front();
+            c->frames.pop_front();
+            --buffered_;
+        }
+        spaceCond_.notify_all();
+
+        t0 = std::chrono::steady_clock::now();
+        if (ok) {
+            // 开启场景切换关键帧时段内其余帧沿用调用方的标记（SceneDetector 的切换点仍是 IDR），
+            // 否则只有段首强制，其余帧的类型交给编码器
+            if (first) frame->pict_type = AV_PICTURE_TYPE_I;
+            else if (!sceneCut_) frame->pict_type = AV_PICTURE_TYPE_NONE;
+            first = false;
+            if (!enc.encode(frame, out)) ok = false;
+            drain();
+        }
+        av_frame_free(&frame);
+        lap();
+    }
+
+    t0 = std::chrono::steady_clock::now();
+    if (ok) {
+        enc.flush(out);
+        drain();
+    }
+    enc.close();
+    lap();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        c->encodeMs = workMs;
+        c->done = true;
+        if (!ok) failed_ = true;
+    }
+    spaceCond_.notify_all();
+}
+
+double ChunkedEncoder::concurrency() const {
+    return wallMs_ > 0.0 ? encodeMs_ / wallMs_ : 0.0;
+}
+
+void ChunkedEncoder::printStats() const {
+    std::cout << "[ChunkedEncoder] " << nextIndex_ << " chunks on " << workers_ << " workers, "
+              << "encode " << encodeMs_ << " ms, wall " << wallMs_ << " ms, avg concurrent chunks " << concurrency() << "\n";
+}
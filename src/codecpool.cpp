@@ -0,0 +1,118 @@
+#include "codecpool.h"
+#include <iostream>
+#include <sstream>
+
+CodecPool& CodecPool::instance() {
+    static CodecPool pool;
+    return pool;
+}
+
+CodecPool::~CodecPool() {
+    clear();
+}
+
+AVCodecContext* CodecPool::acquire(const std::string& key, const Factory& create) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = idle_.find(key);
+        if (it != idle_.end() && !it->second.empty()) {
+            AVCodecContext* ctx = it->second.back();
+            it->second.pop_back();
+            hits_++;
+            return ctx;
+        }
+    }
+
+    // 打开编解码器比较慢，不持锁
+    misses_++;
+    return create ? create() : nullptr;
+}
+
+void CodecPool::release(const std::string& key, AVCodecContext* ctx) {
+    if (!ctx) return;
+
+    bool reusable = true;
+    if (av_codec_is_encoder(ctx->codec)) {
+        // 编码器 flush 之后处于 EOF 状态，只有支持 ENCODER_FLUSH 的才能重置
+        reusable = ctx->codec->capabilities & AV_CODEC_CAP_ENCODER_FLUSH;
+    } else {
+        // 实时模式可能修改过 skip_frame
+        ctx->skip_frame = AVDISCARD_DEFAULT;
+    }
+
+    if (reusable) {
+        avcodec_flush_buffers(ctx);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& list = idle_[key];
+        if ((int)list.size() < maxIdlePerKey_) {
+            list.push_back(ctx);
+            return;
+        }
+    }
+
+    avcodec_free_context(&ctx);
+}
+
+void CodecPool::prewarm(const std::string& key, const Factory& create, int count) {
+    for (int i = 0; i < count; ++i) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if ((int)idle_[key].size() >= maxIdlePerKey_) return;
+        }
+
+        AVCodecContext* ctx = create();
+        if (!ctx) {
+            std::cerr << "CodecPool: prewarm failed for " << key << "\n";
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        idle_[key].push_back(ctx);
+    }
+}
+
+void CodecPool::ensureIdle(const std::string& key, const Factory& create, int count) {
+    int missing;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        missing = count - (int)idle_[key].size();
+    }
+    if (missing > 0) prewarm(key, create, missing);
+}
+
+void CodecPool::setMaxIdlePerKey(int n) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    maxIdlePerKey_ = n > 0 ? n : 0;
+}
+
+void CodecPool::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& kv : idle_) {
+        for (AVCodecContext* ctx : kv.second) {
+            avcodec_free_context(&ctx);
+        }
+    }
+    idle_.clear();
+}
+
+std::string CodecPool::decoderKey(const AVCodecParameters* par) {
+    if (!par) return std::string();
+
+    // extradata 用 FNV-1a 摘要，SPS/PPS 不同的流不能共用上下文
+    uint64_t hash = 1469598103934665603ULL;
+    for (int i = 0; i < par->extradata_size; ++i) {
+        hash ^= par->extradata[i];
+        hash *= 1099511628211ULL;
+    }
+
+    std::ostringstream ss;
+    ss << "dec:" << par->codec_id
+       << ":" << par->width << "x" << par->height
+       << ":" << par->format
+       << ":" << par->sample_rate << ":" << par->channels
+       << ":" << par->channel_layout
+       << ":" << par->profile
+       << ":" << par->extradata_size << ":" << std::hex << hash;
+    return ss.str();
+}
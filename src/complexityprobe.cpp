@@ -0,0 +1,178 @@
+#include "complexityprobe.h"
+#include "demuxer.h"
+#include "videodecoder.h"
+#include "videoencoder.h"
+#include "pixelconverter.h"
+#include "threadpool.h"
+#include "queue.h"
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+ComplexityProbe::ComplexityProbe(int segments, double segmentSeconds, int maxProbeHeight)
+    : segmentCount_(std::max(1, segments)), segmentSeconds_(segmentSeconds > 0 ? segmentSeconds : 2.0),
+      maxProbeHeight_(maxProbeHeight > 0 ? maxProbeHeight : 540) {
+    profile_ = EncoderProfile::throughput();
+    profile_.name = "probe";
+    profile_.gop = 250;
+    profile_.lookahead = 10;
+}
+
+bool ComplexityProbe::probeSegment(const std::string& filename, ComplexitySegment& seg) {
+    auto t0 = std::chrono::steady_clock::now();
+
+    // 每段自己的 Demuxer / 解码器 / 编码器，段与段之间不共享状态
+    Demuxer demuxer(filename);
+    if (!demuxer.open() || !demuxer.seek(seg.start)) return false;
+
+    VideoDecoder decoder(demuxer.getVideoCodecParameters());
+    if (!decoder.open()) return false;
+
+    PixelConverter converter;
+    if (!converter.init(probeW_, probeH_, AV_PIX_FMT_YUV420P, SWS_FAST_BILINEAR)) return false;
+
+    VideoEncoder encoder;
+    EncoderProfile p = profile_;
+    if (p.threads <= 0)
+        p.threads = std::max(1, (int)std::thread::hardware_concurrency() / segmentCount_);
+    encoder.setProfile(p);
+    int fps = std::max(1, (int)(av_q2d(fps_) + 0.5));
+    if (!encoder.open(probeW_, probeH_, av_inv_q(fps_), AV_PIX_FMT_YUV420P, fps)) return false;
+
+    // seek 落在关键帧上，从那里读够一段的包（一个视频包一帧）
+    const int target = std::max(1, (int)(segmentSeconds_ * av_q2d(fps_) + 0.5));
+    PacketQueue<AVPacket*> packets;
+    for (int i = 0; i < target; ++i) {
+        AVPacket* pkt = demuxer.readVideoPacket();
+        if (!pkt) break;
+        packets.push(pkt);
+    }
+    packets.push(nullptr);
+
+    PacketQueue<AVPacket*> out;
+    auto drain = [&] {
+        while (!out.empty()) {
+            AVPacket* pkt = out.pop();
+            seg.bytes += pkt->size;
+            av_packet_free(&pkt);
+        }
+    };
+
+    decoder.decode(packets, [&](AVFrame* frame) {
+        if (seg.frames >= target) return;
+        AVFrame* small = converter.convert(frame);
+        if (!small) return;
+        // 解码出来的 P/B 类型不能带给编码器；pts 重新编号（只关心码率）
+        small->pict_type = AV_PICTURE_TYPE_NONE;
+        small->pts = seg.frames;
+        if (encoder.encode(small, out)) ++seg.frames;
+        av_frame_free(&small);
+        drain();
+    });
+    encoder.flush(out);
+    drain();
+
+    seg.encodeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    if (seg.frames == 0) return false;
+
+    seg.kbps = seg.bytes * 8.0 / (seg.frames / av_q2d(fps_)) / 1000.0;
+    seg.bitsPerPixel = seg.bytes * 8.0 / ((double)seg.frames * probeW_ * probeH_);
+    return true;
+}
+
+bool ComplexityProbe::run(const std::string& filename) {
+    auto t0 = std::chrono::steady_clock::now();
+    segments_.clear();
+
+    double duration;
+    {
+        Demuxer demuxer(filename);
+        if (!demuxer.open()) return false;
+        AVCodecParameters* par = demuxer.getVideoCodecParameters();
+        if (!par || par->width <= 0 || par->height <= 0) {
+            std::cerr << "ComplexityProbe: no video stream in " << filename << "\n";
+            return false;
+        }
+        srcW_ = par->width;
+        srcH_ = par->height;
+        duration = demuxer.duration();
+        AVRational r = demuxer.videoFrameRate();
+        fps_ = r.num > 0 && r.den > 0 ? r : AVRational{25, 1};
+    }
+
+    // 探测分辨率：高度不超过 maxProbeHeight，宽按比例，都取偶数
+    probeH_ = std::min(srcH_, maxProbeHeight_) & ~1;
+    probeW_ = (int)((int64_t)srcW_ * probeH_ / srcH_) & ~1;
+    if (probeW_ < 16 || probeH_ < 16) {
+        std::cerr << "ComplexityProbe: video too small\n";
+        return false;
+    }
+
+    // 采样点均匀分布在片中（每段居中于自己的区间），短片只取开头一段
+    int n = duration > segmentSeconds_ * 2 ? segmentCount_ : 1;
+    double span = std::max(0.0, duration - segmentSeconds_);
+    std::vector<ComplexitySegment> segs(n);
+    for (int i = 0; i < n; ++i) segs[i].start = n == 1 ? 0.0 : span * (i + 0.5) / n;
+
+    std::vector<char> ok(n, 0);
+    ThreadPool::shared().parallelFor(n, [&](int i) { ok[i] = probeSegment(filename, segs[i]); });
+
+    for (int i = 0; i < n; ++i) {
+        if (ok[i]) segments_.push_back(segs[i]);
+        else std::cerr << "ComplexityProbe: segment at " << segs[i].start << "s failed\n";
+    }
+    wallMs_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    return !segments_.empty();
+}
+
+double ComplexityProbe::titleBitsPerPixel() const {
+    if (segments_.empty()) return 0.0;
+    std::vector<double> v;
+    for (const ComplexitySegment& s : segments_) v.push_back(s.bitsPerPixel);
+    std::sort(v.begin(), v.end());
+    return v[(size_t)(0.75 * (v.size() - 1) + 0.5)];
+}
+
+double ComplexityProbe::titleKbps() const {
+    return titleBitsPerPixel() * probeW_ * probeH_ * av_q2d(fps_) / 1000.0;
+}
+
+std::vector<LadderRung> ComplexityProbe::deriveLadder(const std::vector<LadderRung>& fixedLadder,
+                                                      double floorRatio) const {
+    std::vector<LadderRung> out = fixedLadder;
+    const double kbps = titleKbps();
+    if (kbps <= 0.0 || srcW_ <= 0 || srcH_ <= 0) return out;
+
+    for (LadderRung& r : out) {
+        // LadderFilter 的约定：<= 0 的一边按源宽高比计算
+        double w = r.width, h = r.height;
+        if (w <= 0 && h <= 0) continue;
+        if (w <= 0) w = h * srcW_ / srcH_;
+        if (h <= 0) h = w * srcH_ / srcW_;
+
+        double ratio = w * h / ((double)probeW_ * probeH_);
+        double bitrate = kbps * 1000.0 * std::pow(ratio, 0.75);
+        if (r.bitrate > 0) bitrate = std::min((double)r.bitrate, std::max(bitrate, floorRatio * r.bitrate));
+        r.bitrate = (int64_t)bitrate;
+    }
+    return out;
+}
+
+void ComplexityProbe::printStats() const {
+    double content = 0.0;
+    std::cout << "[ComplexityProbe] probe " << probeW_ << "x" << probeH_ << " @ " << av_q2d(fps_) << "fps\n";
+    std::cout << std::fixed << std::setprecision(3);
+    for (const ComplexitySegment& s : segments_) {
+        content += s.frames / av_q2d(fps_);
+        std::cout << "  @" << std::setprecision(1) << s.start << "s: " << s.frames << " frames, "
+                  << s.kbps << " kbps, " << std::setprecision(3) << s.bitsPerPixel << " bpp, "
+                  << std::setprecision(0) << s.encodeMs << " ms\n";
+    }
+    std::cout << std::setprecision(1) << "  title: " << titleKbps() << " kbps ("
+              << std::setprecision(3) << titleBitsPerPixel() << " bpp), probed " << std::setprecision(1)
+              << content << "s of content in " << wallMs_ / 1000.0 << "s\n";
+    std::cout << std::defaultfloat;
+}
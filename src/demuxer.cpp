@@ -37,6 +37,7 @@ bool Demuxer::open() {
      // 设置视频流的 time_base 为 1/24
     if (videoStreamIndex_ >= 0) {
         AVStream* videoStream = fmtCtx_->streams[videoStreamIndex_];
+        videoTimeBase_ = videoStream->time_base;
         // 手动设置 time_base 为 1/24 (24 FPS)
         videoStream->time_base = (AVRational){1, 24};
     }
@@ -79,6 +80,46 @@ AVCodecParameters* Demuxer::getAudioCodecParameters() const {
     return nullptr; 
 }
 
+double Demuxer::duration() const {
+    if (!fmtCtx_) return 0.0;
+    if (fmtCtx_->duration != AV_NOPTS_VALUE && fmtCtx_->duration > 0)
+        return fmtCtx_->duration / (double)AV_TIME_BASE;
+    return 0.0;
+}
+
+AVRational Demuxer::videoFrameRate() const {
+    if (videoStreamIndex_ < 0) return {0, 1};
+    return av_guess_frame_rate(fmtCtx_, fmtCtx_->streams[videoStreamIndex_], nullptr);
+}
+
+bool Demuxer::seek(double seconds) {
+    if (!fmtCtx_) return false;
+    // 用 AV_TIME_BASE 单位、不指定流，不受上面改写过的视频流 time_base 影响
+    int64_t ts = (int64_t)(seconds * AV_TIME_BASE);
+    if (fmtCtx_->start_time != AV_NOPTS_VALUE) ts += fmtCtx_->start_time;
+    if (avformat_seek_file(fmtCtx_, -1, INT64_MIN, ts, ts, 0) < 0) {
+        std::cerr << "Demuxer: seek to " << seconds << "s failed\n";
+        return false;
+    }
+    return true;
+}
+
+AVPacket* Demuxer::readVideoPacket() {
+    if (!fmtCtx_ || videoStreamIndex_ < 0) return nullptr;
+    AVPacket* pkt = av_packet_alloc();
+    while (av_read_frame(fmtCtx_, pkt) >= 0) {
+        if (pkt->stream_index == videoStreamIndex_) return pkt;
+        av_packet_unref(pkt);
+    }
+    av_packet_free(&pkt);
+    return nullptr;
+}
+
+AVRational Demuxer::getAudioTimeBase() const {
+    if (audioStreamIndex_ >= 0) return fmtCtx_->streams[audioStreamIndex_]->time_base;
+    return {1, 1};
+}
+
 AVCodecParameters* Demuxer::getVideoCodecParameters() const { 
     if (videoStreamIndex_ >= 0) 
         return fmtCtx_->streams[videoStreamIndex_]->codecpar; 
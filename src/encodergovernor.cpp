@@ -0,0 +1,59 @@
+#include "encodergovernor.h"
+#include <iostream>
+#include <algorithm>
+
+EncoderGovernor::EncoderGovernor(double targetFps, const std::string& startPreset,
+                                 const std::vector<std::string>& presets)
+    : targetFps_(targetFps > 0 ? targetFps : 25.0), presets_(presets) {
+    if (presets_.empty()) presets_.push_back(startPreset);
+    auto it = std::find(presets_.begin(), presets_.end(), startPreset);
+    index_ = it != presets_.end() ? (int)(it - presets_.begin()) : (int)presets_.size() / 2;
+}
+
+void EncoderGovernor::addSample(double encodeMs) {
+    windowMs_ += encodeMs;
+    ++windowFrames_;
+}
+
+const std::string& EncoderGovernor::decide(int64_t frameIndex) {
+    if (windowFrames_ == 0) return preset();
+
+    const double fps = windowMs_ > 0.0 ? 1000.0 * windowFrames_ / windowMs_ : 1e9;
+    const double fill = queueProbe_ ? queueProbe_() : 0.0;
+    windowMs_ = 0.0;
+    windowFrames_ = 0;
+
+    int next = index_;
+    if (fps < targetFps_ * (1.0 + lowMargin_) || fill > 0.5) {
+        // 跟不上或输入在堆积：立刻加速
+        calmGops_ = 0;
+        if (index_ > 0) next = index_ - 1;
+    } else if (fps > targetFps_ * (1.0 + highMargin_) && fill < 0.1) {
+        // 余量要连续保持两个 GOP 才减速，避免来回切换
+        if (++calmGops_ >= 2 && index_ + 1 < (int)presets_.size()) {
+            next = index_ + 1;
+            calmGops_ = 0;
+        }
+    } else {
+        calmGops_ = 0;
+    }
+
+    if (next != index_) {
+        Switch s;
+        s.frame = frameIndex;
+        s.from = presets_[index_];
+        s.to = presets_[next];
+        s.encodeFps = fps;
+        s.queueFill = fill;
+        switches_.push_back(s);
+        std::cout << "[EncoderGovernor] frame " << frameIndex << ": " << s.from << " -> " << s.to
+                  << " (encode " << fps << " fps, target " << targetFps_ << ", queue "
+                  << (int)(fill * 100) << "%)\n";
+        index_ = next;
+    }
+    return preset();
+}
+
+void EncoderGovernor::printStats() const {
+    std::cout << "[EncoderGovernor] final preset " << preset() << ", " << switches_.size() << " switches\n";
+}
@@ -0,0 +1,231 @@
+#include "encoderprofile.h"
+#include <iostream>
+#include <sstream>
+#include <cstdlib>
+#include <cerrno>
+extern "C" {
+#include <libavutil/opt.h>
+}
+
+EncoderProfile EncoderProfile::defaults() {
+    EncoderProfile p;
+    p.name = "default";
+    p.preset = "fast";
+    return p;
+}
+
+EncoderProfile EncoderProfile::throughput() {
+    EncoderProfile p;
+    p.name = "throughput";
+    p.preset = "veryfast";
+    p.quality = 23;
+    p.gop = 250;
+    p.bFrames = 3;
+    p.lookahead = 20;
+    return p;
+}
+
+EncoderProfile EncoderProfile::latency() {
+    EncoderProfile p;
+    p.name = "latency";
+    p.preset = "veryfast";
+    p.tune = "zerolatency";
+    p.quality = 23;
+    p.gop = 60;
+    p.bFrames = 0;
+    p.lookahead = 0;
+    return p;
+}
+
+EncoderProfile EncoderProfile::live() {
+    EncoderProfile p;
+    p.name = "live";
+    p.preset = "superfast";
+    p.tune = "zerolatency";
+    p.rateControl = RC_CBR;
+    p.bitrate = 3000000;
+    p.bufferFrames = 1;            // 约一帧，打开编码器时按实际帧率换算
+    p.gop = 60;                    // 开启 intra-refresh 后为刷新周期
+    p.bFrames = 0;
+    p.lookahead = 0;
+    p.options["intra-refresh"] = "1";
+    p.options["sliced-threads"] = "1";
+    return p;
+}
+
+EncoderProfile EncoderProfile::archive() {
+    EncoderProfile p;
+    p.name = "archive";
+    p.preset = "slow";
+    p.quality = 18;
+    p.gop = 250;
+    p.bFrames = 3;
+    p.lookahead = 60;
+    return p;
+}
+
+bool EncoderProfile::byName(const std::string& name, EncoderProfile& out) {
+    if (name == "default") out = defaults();
+    else if (name == "throughput") out = throughput();
+    else if (name == "latency") out = latency();
+    else if (name == "live") out = live();
+    else if (name == "archive") out = archive();
+    else return false;
+    return true;
+}
+
+// 整个字符串都是 [lo, hi] 范围内的整数时写入 out
+static bool parseInt(const std::string& k, const std::string& v, int64_t lo, int64_t hi, int64_t& out) {
+    char* end = nullptr;
+    errno = 0;
+    long long n = strtoll(v.c_str(), &end, 10);
+    if (v.empty() || *end || errno == ERANGE || n < lo || n > hi) {
+        std::cerr << "EncoderProfile: bad value " << k << "=" << v << ", expected an integer in ["
+                  << lo << ", " << hi << "]\n";
+        return false;
+    }
+    out = n;
+    return true;
+}
+
+static bool parseInt(const std::string& k, const std::string& v, int lo, int hi, int& out) {
+    int64_t n = 0;
+    if (!parseInt(k, v, (int64_t)lo, (int64_t)hi, n)) return false;
+    out = (int)n;
+    return true;
+}
+
+static bool parseDouble(const std::string& k, const std::string& v, double lo, double hi, double& out) {
+    char* end = nullptr;
+    errno = 0;
+    double d = strtod(v.c_str(), &end);
+    if (v.empty() || *end || errno == ERANGE || !(d >= lo && d <= hi)) {
+        std::cerr << "EncoderProfile: bad value " << k << "=" << v << ", expected a number in ["
+                  << lo << ", " << hi << "]\n";
+        return false;
+    }
+    out = d;
+    return true;
+}
+
+bool EncoderProfile::parse(const std::string& spec, EncoderProfile& out) {
+    std::stringstream ss(spec);
+    std::string item;
+    std::getline(ss, item, ':');
+
+    EncoderProfile p;
+    if (!byName(item.empty() ? "default" : item, p)) {
+        std::cerr << "EncoderProfile: unknown profile " << item << "\n";
+        return false;
+    }
+
+    while (std::getline(ss, item, ':')) {
+        size_t eq = item.find('=');
+        if (eq == std::string::npos || eq == 0) {
+            std::cerr << "EncoderProfile: bad option \"" << item << "\"\n";
+            return false;
+        }
+        std::string k = item.substr(0, eq), v = item.substr(eq + 1);
+        const int64_t maxRate = 2000000000;   // 2 Gbps
+        bool ok = true;
+        if (k == "codec") p.codec = v;
+        else if (k == "preset") p.preset = v;
+        else if (k == "tune") p.tune = v;
+        else if (k == "crf") { p.rateControl = RC_CRF; ok = parseDouble(k, v, 0, 63, p.quality); }
+        else if (k == "qp") { p.rateControl = RC_CQP; ok = parseDouble(k, v, 0, 69, p.quality); }
+        else if (k == "b") {
+            ok = parseInt(k, v, 1, maxRate, p.bitrate);
+            if (p.rateControl != RC_CBR) p.rateControl = RC_ABR;
+        }
+        else if (k == "cbr") { p.rateControl = RC_CBR; ok = parseInt(k, v, 1, maxRate, p.bitrate); }
+        else if (k == "maxrate") ok = parseInt(k, v, 0, maxRate, p.maxBitrate);
+        else if (k == "bufsize") {
+            ok = parseInt(k, v, 0, maxRate, p.bufferSize);
+            p.bufferFrames = 0;   // 显式给出的缓冲大小优先
+        }
+        else if (k == "g") ok = parseInt(k, v, 1, 100000, p.gop);
+        else if (k == "bf") ok = parseInt(k, v, 0, 16, p.bFrames);
+        else if (k == "threads") ok = parseInt(k, v, 0, 256, p.threads);
+        else if (k == "lookahead") ok = parseInt(k, v, -1, 250, p.lookahead);
+        else if (k == "passes") ok = parseInt(k, v, 1, 2, p.passes);
+        else p.options[k] = v;
+        if (!ok) return false;
+    }
+    p.name = spec;
+    out = p;
+    return true;
+}
+
+static void setOption(AVCodecContext* ctx, const char* key, const std::string& value) {
+    if (av_opt_set(ctx, key, value.c_str(), AV_OPT_SEARCH_CHILDREN) < 0)
+        std::cerr << "EncoderProfile: " << (ctx->codec ? ctx->codec->name : "encoder")
+                  << " does not support option " << key << "=" << value << "\n";
+}
+
+void EncoderProfile::applyTo(AVCodecContext* ctx) const {
+    const bool video = ctx->codec_type == AVMEDIA_TYPE_VIDEO;
+
+    if (video) {
+        ctx->gop_size = gop;
+        ctx->max_b_frames = bFrames;
+        if (!preset.empty()) setOption(ctx, "preset", preset);
+        if (!tune.empty()) setOption(ctx, "tune", tune);
+        if (lookahead >= 0) setOption(ctx, "rc-lookahead", std::to_string(lookahead));
+    }
+    if (threads > 0) ctx->thread_count = threads;
+
+    switch (rateControl) {
+    case RC_CRF:
+        if (quality >= 0) {
+            if (video) {
+                setOption(ctx, "crf", std::to_string(quality));
+            } else {
+                // 音频的恒定质量：qscale 模式（libmp3lame / aac 等）
+                ctx->flags |= AV_CODEC_FLAG_QSCALE;
+                ctx->global_quality = (int)(quality * FF_QP2LAMBDA);
+            }
+        }
+        break;
+    case RC_CQP:
+        if (quality >= 0) setOption(ctx, "qp", std::to_string((int)quality));
+        break;
+    case RC_ABR:
+        if (bitrate > 0) ctx->bit_rate = bitrate;
+        break;
+    case RC_CBR:
+        if (bitrate > 0) {
+            ctx->bit_rate = bitrate;
+            ctx->rc_min_rate = bitrate;
+            ctx->rc_max_rate = bitrate;
+            ctx->rc_buffer_size = (int)vbvSize(ctx, bitrate);
+            if (video) setOption(ctx, "nal-hrd", "cbr");
+        }
+        break;
+    }
+
+    if (maxBitrate > 0 && rateControl != RC_CBR) {
+        ctx->rc_max_rate = maxBitrate;
+        ctx->rc_buffer_size = (int)vbvSize(ctx, maxBitrate);
+    }
+
+    for (const auto& kv : options) setOption(ctx, kv.first.c_str(), kv.second);
+}
+
+int64_t EncoderProfile::vbvSize(const AVCodecContext* ctx, int64_t rate) const {
+    if (bufferSize > 0) return bufferSize;
+    if (bufferFrames > 0) {
+        // 帧率未知时（音频等）退回 25fps
+        double fps = ctx->framerate.num > 0 && ctx->framerate.den > 0 ? av_q2d(ctx->framerate) : 25.0;
+        return (int64_t)(rate * bufferFrames / fps);
+    }
+    return rate;
+}
+
+std::string EncoderProfile::key() const {
+    std::ostringstream ss;
+    ss << codec << "/" << preset << "/" << tune << "/" << rateControl << "/" << quality << "/"
+       << bitrate << "/" << maxBitrate << "/" << bufferSize << "/" << bufferFrames << "/" << gop << "/" << bFrames << "/"
+       << threads << "/" << lookahead << "/" << passes;
+    for (const auto& kv : options) ss << "/" << kv.first << "=" << kv.second;
+    return ss.str();
+}
@@ -0,0 +1,117 @@
+#include "framededup.h"
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <algorithm>
+extern "C" {
+#include <libavutil/pixdesc.h>
+#include <libavutil/imgutils.h>
+#include <libavutil/common.h>
+}
+
+static const int kBlock = 8;
+
+FrameDedup::FrameDedup(double threshold, int gridStep, int maxDropRun)
+    : threshold_(threshold), gridStep_(std::max(1, gridStep)), maxDropRun_(maxDropRun) {
+    // 8x8，解码帧的地址不保证对齐
+    sad8_ = av_pixelutils_get_sad_fn(3, 3, 0, nullptr);
+}
+
+FrameDedup::~FrameDedup() {
+    av_frame_free(&ref_);
+}
+
+void FrameDedup::reset() {
+    av_frame_free(&ref_);
+    run_ = 0;
+    phase_ = 0;
+    stats_ = DedupStats();
+}
+
+bool FrameDedup::compare(const AVFrame* a, const AVFrame* b) {
+    if (a->width != b->width || a->height != b->height || a->format != b->format) return false;
+
+    AVPixelFormat fmt = (AVPixelFormat)a->format;
+    const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(fmt);
+    if (!desc || (desc->flags & (AV_PIX_FMT_FLAG_HWACCEL | AV_PIX_FMT_FLAG_BITSTREAM | AV_PIX_FMT_FLAG_PAL)))
+        return false;
+
+    // 按字节比较，高位深格式的差值会偏大，但完全相同的帧仍然是 0
+    const int64_t limit = (int64_t)(threshold_ * kBlock * kBlock);
+    const int px = phase_ % gridStep_;
+    const int py = phase_ / gridStep_;
+
+    int planes = av_pix_fmt_count_planes(fmt);
+    for (int p = 0; p < planes; ++p) {
+        int bytes = av_image_get_linesize(fmt, a->width, p);
+        int rows = (p == 1 || p == 2) ? AV_CEIL_RSHIFT(a->height, desc->log2_chroma_h) : a->height;
+        if (bytes <= 0) return false;
+
+        const uint8_t* pa = a->data[p];
+        const uint8_t* pb = b->data[p];
+        const ptrdiff_t sa = a->linesize[p], sb = b->linesize[p];
+        const int bw = bytes / kBlock, bh = rows / kBlock;
+
+        for (int by = py; by < bh; by += gridStep_) {
+            for (int bx = px; bx < bw; bx += gridStep_) {
+                const uint8_t* ra = pa + (ptrdiff_t)by * kBlock * sa + bx * kBlock;
+                const uint8_t* rb = pb + (ptrdiff_t)by * kBlock * sb + bx * kBlock;
+                int64_t sad = 0;
+                if (sad8_) {
+                    sad = sad8_(ra, sa, rb, sb);
+                } else {
+                    for (int r = 0; r < kBlock; ++r)
+                        for (int c = 0; c < kBlock; ++c) sad += abs(ra[r * sa + c] - rb[r * sb + c]);
+                }
+                if (sad > limit) return false;
+            }
+        }
+
+        // 不足一个块的右边、下边残余部分全部比较，避免漏掉边缘的变化
+        int64_t edgeSad = 0, edgeCount = 0;
+        for (int y = 0; y < rows; ++y) {
+            int x0 = y >= bh * kBlock ? 0 : bw * kBlock;
+            const uint8_t* ra = pa + y * sa;
+            const uint8_t* rb = pb + y * sb;
+            for (int x = x0; x < bytes; ++x) edgeSad += abs(ra[x] - rb[x]);
+            edgeCount += bytes - x0;
+        }
+        if (edgeCount && edgeSad > threshold_ * edgeCount) return false;
+    }
+    return true;
+}
+
+bool FrameDedup::isDuplicate(const AVFrame* frame) {
+    if (!frame || !frame->data[0]) return false;
+
+    auto t0 = std::chrono::steady_clock::now();
+    ++stats_.frames;
+
+    bool dup = ref_ && (maxDropRun_ <= 0 || run_ < maxDropRun_) && compare(frame, ref_);
+    phase_ = (phase_ + 1) % (gridStep_ * gridStep_);
+
+    if (dup) {
+        ++stats_.dropped;
+        ++run_;
+        stats_.longestRun = std::max(stats_.longestRun, run_);
+    } else {
+        run_ = 0;
+        // 只持有引用：解码器的 buffer 在引用释放前不会被复用
+        if (!ref_) ref_ = av_frame_alloc();
+        else av_frame_unref(ref_);
+        if (ref_ && av_frame_ref(ref_, frame) < 0) av_frame_free(&ref_);
+    }
+
+    stats_.analyzeMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    return dup;
+}
+
+double FrameDedup::savedMs(double downstreamMsPerFrame) const {
+    return stats_.dropped * downstreamMsPerFrame - stats_.analyzeMs;
+}
+
+void FrameDedup::printStats(double downstreamMsPerFrame) const {
+    std::cout << "[FrameDedup] frames " << stats_.frames << ", dropped " << stats_.dropped
+              << " (longest run " << stats_.longestRun << "), compare " << stats_.analyzeMs
+              << " ms, saved ~" << savedMs(downstreamMsPerFrame) << " ms\n";
+}
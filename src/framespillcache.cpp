@@ -0,0 +1,259 @@
+#include "framespillcache.h"
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+extern "C" {
+#include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
+#include <libavutil/opt.h>
+}
+
+FrameSpillCache::~FrameSpillCache() {
+    close();
+}
+
+bool FrameSpillCache::open(const std::string& spillPath, size_t memoryBudget, uint64_t diskBudget, Mode mode) {
+    close();
+    path_ = spillPath;
+    memBudget_ = memoryBudget;
+    diskBudget_ = diskBudget;
+    mode_ = mode;
+    return true;
+}
+
+void FrameSpillCache::close() {
+    for (AVFrame* f : memory_) av_frame_free(&f);
+    memory_.clear();
+    index_.clear();
+    readPos_ = 0;
+
+    bool hadFile = writer_.isOpen() || readFd_ >= 0;
+    writer_.close();
+    if (readFd_ >= 0) {
+        ::close(readFd_);
+        readFd_ = -1;
+    }
+    if (hadFile) unlink(path_.c_str());
+
+    avcodec_free_context(&enc_);
+    avcodec_free_context(&dec_);
+    av_packet_free(&pkt_);
+    frames_ = 0;
+    memBytes_ = 0;
+    diskBytes_ = 0;
+}
+
+bool FrameSpillCache::openCodec(const AVFrame* frame) {
+    AVCodec* codec = avcodec_find_encoder(AV_CODEC_ID_FFV1);
+    if (!codec) return false;
+
+    bool supported = false;
+    for (const AVPixelFormat* p = codec->pix_fmts; p && *p != AV_PIX_FMT_NONE; ++p) {
+        if (*p == frame->format) supported = true;
+    }
+    if (!supported) {
+        std::cerr << "FrameSpillCache: FFV1 does not support pixel format " << frame->format << ", spilling raw\n";
+        return false;
+    }
+
+    enc_ = avcodec_alloc_context3(codec);
+    pkt_ = av_packet_alloc();
+    if (!enc_ || !pkt_) return false;
+    enc_->width = frame->width;
+    enc_->height = frame->height;
+    enc_->pix_fmt = (AVPixelFormat)frame->format;
+    enc_->time_base = {1, 25};
+    enc_->gop_size = 1;
+    enc_->thread_count = 0;
+    // level 3 才支持 slice 多线程；每帧独立，解码端用同一份 extradata
+    enc_->level = 3;
+    av_opt_set_int(enc_->priv_data, "slicecrc", 0, 0);
+    if (avcodec_open2(enc_, codec, nullptr) < 0) {
+        std::cerr << "FrameSpillCache: failed to open FFV1 encoder, spilling raw\n";
+        avcodec_free_context(&enc_);
+        return false;
+    }
+    return true;
+}
+
+bool FrameSpillCache::push(const AVFrame* frame) {
+    if (!frame || !frame->data[0]) return false;
+
+    int size = av_image_get_buffer_size((AVPixelFormat)frame->format, frame->width, frame->height, 1);
+    if (size <= 0) return false;
+
+    // 内存预算内（且还没有开始落盘，保持顺序）直接持有引用
+    if (index_.empty() && memBytes_ + size <= memBudget_) {
+        AVFrame* ref = av_frame_clone(frame);
+        if (!ref) return false;
+        memory_.push_back(ref);
+        memBytes_ += size;
+        ++frames_;
+        return true;
+    }
+
+    if (!writer_.isOpen()) {
+        if (diskBudget_ == 0 || !writer_.open(path_, false, true)) {
+            std::cerr << "FrameSpillCache: memory budget exhausted and no spill file\n";
+            return false;
+        }
+        if (mode_ == SPILL_FFV1 && !openCodec(frame)) mode_ = SPILL_RAW;
+    }
+
+    Entry e;
+    e.pts = frame->pts;
+    e.duration = frame->pkt_duration;
+    e.pictType = frame->pict_type;
+    e.width = frame->width;
+    e.height = frame->height;
+    e.format = frame->format;
+    e.colorRange = frame->color_range;
+    e.sar = frame->sample_aspect_ratio;
+    if (const AVFrameSideData* sd = av_frame_get_side_data(frame, AV_FRAME_DATA_REGIONS_OF_INTEREST))
+        e.roi.assign(sd->data, sd->data + sd->size);
+
+    uint64_t before = writer_.bytesWritten();
+    bool ok;
+    if (enc_ && frame->width == enc_->width && frame->height == enc_->height && frame->format == enc_->pix_fmt) {
+        // FFV1 是帧内编码，送一帧立刻出一个包
+        AVFrame* tmp = av_frame_clone(frame);
+        if (!tmp) return false;
+        tmp->pict_type = AV_PICTURE_TYPE_NONE;
+        tmp->pts = frames_;
+        ok = avcodec_send_frame(enc_, tmp) >= 0 && avcodec_receive_packet(enc_, pkt_) >= 0;
+        av_frame_free(&tmp);
+        if (ok) {
+            ok = writer_.write(pkt_->data, pkt_->size);
+            e.size = pkt_->size;
+            e.compressed = true;
+            av_packet_unref(pkt_);
+        }
+    } else {
+        ok = writer_.writeVideo(frame);
+        e.size = size;
+    }
+    if (!ok) {
+        std::cerr << "FrameSpillCache: failed to spill frame\n";
+        return false;
+    }
+
+    // 写完才知道压缩后的大小，超出预算的这一帧已经在文件里，但不再计入
+    diskBytes_ += writer_.bytesWritten() - before;
+    if (diskBytes_ > diskBudget_) {
+        std::cerr << "FrameSpillCache: disk budget of " << diskBudget_ << " bytes exceeded\n";
+        return false;
+    }
+    index_.push_back(e);
+    ++frames_;
+    return true;
+}
+
+bool FrameSpillCache::rewind() {
+    readPos_ = 0;
+    if (index_.empty()) return true;
+
+    if (writer_.isOpen() && !writer_.close()) {
+        std::cerr << "FrameSpillCache: write error in spill file\n";
+        return false;
+    }
+    if (readFd_ >= 0) ::close(readFd_);
+    readFd_ = ::open(path_.c_str(), O_RDONLY);
+    if (readFd_ < 0) {
+        std::cerr << "FrameSpillCache: cannot reopen " << path_ << "\n";
+        return false;
+    }
+    posix_fadvise(readFd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    if (enc_ && !dec_) {
+        AVCodec* codec = avcodec_find_decoder(AV_CODEC_ID_FFV1);
+        dec_ = codec ? avcodec_alloc_context3(codec) : nullptr;
+        if (!dec_) return false;
+        dec_->width = enc_->width;
+        dec_->height = enc_->height;
+        dec_->pix_fmt = enc_->pix_fmt;
+        dec_->thread_count = 0;
+        // 与编码端一致用 slice 多线程：帧多线程要攒够每个线程一个包才输出，
+        // 送一个包后立刻 receive 会得到 EAGAIN
+        dec_->thread_type = FF_THREAD_SLICE;
+        if (enc_->extradata_size > 0) {
+            dec_->extradata = (uint8_t*)av_mallocz(enc_->extradata_size + AV_INPUT_BUFFER_PADDING_SIZE);
+            if (!dec_->extradata) return false;
+            memcpy(dec_->extradata, enc_->extradata, enc_->extradata_size);
+            dec_->extradata_size = enc_->extradata_size;
+        }
+        if (avcodec_open2(dec_, codec, nullptr) < 0) {
+            std::cerr << "FrameSpillCache: failed to open FFV1 decoder\n";
+            avcodec_free_context(&dec_);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool FrameSpillCache::readFully(uint8_t* dst, size_t size) {
+    while (size > 0) {
+        ssize_t n = ::read(readFd_, dst, size);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        dst += n;
+        size -= n;
+    }
+    return true;
+}
+
+AVFrame* FrameSpillCache::readRaw(const Entry& e) {
+    // 尾部留出 padding，容忍 SIMD 越界读
+    AVBufferRef* buf = av_buffer_alloc(e.size + AV_INPUT_BUFFER_PADDING_SIZE);
+    AVFrame* f = av_frame_alloc();
+    if (!buf || !f || !readFully(buf->data, e.size)) {
+        av_buffer_unref(&buf);
+        av_frame_free(&f);
+        return nullptr;
+    }
+    // 平面直接指向读入的缓冲区，不再拷贝
+    f->buf[0] = buf;
+    f->format = e.format;
+    f->width = e.width;
+    f->height = e.height;
+    av_image_fill_arrays(f->data, f->linesize, buf->data, (AVPixelFormat)e.format, e.width, e.height, 1);
+    return f;
+}
+
+AVFrame* FrameSpillCache::readFfv1(const Entry& e) {
+    if (!dec_ || !pkt_ || av_new_packet(pkt_, (int)e.size) < 0) return nullptr;
+    AVFrame* f = av_frame_alloc();
+    bool ok = f && readFully(pkt_->data, e.size) &&
+              avcodec_send_packet(dec_, pkt_) >= 0 && avcodec_receive_frame(dec_, f) >= 0;
+    av_packet_unref(pkt_);
+    if (!ok) av_frame_free(&f);
+    return f;
+}
+
+AVFrame* FrameSpillCache::pop() {
+    if (!memory_.empty()) {
+        AVFrame* f = memory_.front();
+        memory_.pop_front();
+        memBytes_ -= av_image_get_buffer_size((AVPixelFormat)f->format, f->width, f->height, 1);
+        return f;
+    }
+    if (readPos_ >= index_.size() || readFd_ < 0) return nullptr;
+
+    const Entry& e = index_[readPos_++];
+    AVFrame* f = e.compressed ? readFfv1(e) : readRaw(e);
+    if (!f) {
+        std::cerr << "FrameSpillCache: failed to read frame " << readPos_ - 1 << " from spill file\n";
+        return nullptr;
+    }
+    f->pts = e.pts;
+    f->pkt_duration = e.duration;
+    f->pict_type = (AVPictureType)e.pictType;
+    f->color_range = (AVColorRange)e.colorRange;
+    f->sample_aspect_ratio = e.sar;
+    if (!e.roi.empty()) {
+        AVFrameSideData* sd = av_frame_new_side_data(f, AV_FRAME_DATA_REGIONS_OF_INTEREST, e.roi.size());
+        if (sd) memcpy(sd->data, e.roi.data(), e.roi.size());
+    }
+    return f;
+}
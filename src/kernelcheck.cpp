@@ -0,0 +1,226 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstring>
+#include <cstdint>
+#include <memory>
+#include <functional>
+#include <algorithm>
+
+#include "pixelkernels.h"
+
+// pixelkernels 的正确性检查和基准：
+//   kernelcheck        依次强制每一级指令集，在奇数宽度、非对齐地址、非对齐 / 负 stride 上
+//                      与标量版本逐字节比较（包括行尾之外的字节，检查越界写），不一致时返回 1
+//   kernelcheck bench  1920x1080 平面上每个内核、每一级指令集的单次耗时（多次运行取最快）
+
+static const char* kIsas[] = {"c", "sse4.1", "avx2", "avx512"};
+
+static uint32_t nextRandom(uint32_t& s) {
+    s ^= s << 13;
+    s ^= s >> 17;
+    s ^= s << 5;
+    return s;
+}
+
+// 一个平面：mem 是整块内存（含行尾填充和前后空隙），row0 指向第一行，stride 可以为负
+struct Plane {
+    std::vector<uint8_t> mem;
+    uint8_t* row0 = nullptr;
+    ptrdiff_t stride = 0;
+};
+
+// rowBytes 为每行有效字节数；off 为起始地址相对分配地址的偏移（制造非对齐），
+// elem 为元素大小（16 位平面的地址和 stride 保持 2 字节对齐）
+static Plane makePlane(int rowBytes, int height, int off, bool negative, int elem, uint32_t seed,
+                       uint16_t valueMask = 0xffff) {
+    Plane p;
+    ptrdiff_t stride = rowBytes + elem * (3 + off);
+    p.mem.resize((size_t)stride * height + 64 + elem * off);
+    if (elem == 2) {
+        for (size_t i = 0; i + 1 < p.mem.size(); i += 2) {
+            uint16_t v = (uint16_t)(nextRandom(seed) & valueMask);
+            memcpy(&p.mem[i], &v, 2);
+        }
+    } else {
+        for (uint8_t& b : p.mem) b = (uint8_t)nextRandom(seed);
+    }
+    uint8_t* base = p.mem.data() + 32 + elem * off;
+    p.row0 = negative ? base + (height - 1) * stride : base;
+    p.stride = negative ? -stride : stride;
+    return p;
+}
+
+enum Kernel {
+    K_INTERLEAVE = 0,
+    K_DEINTERLEAVE,
+    K_DITHER,
+    K_HFLIP1,
+    K_HFLIP2,
+    K_HFLIP4,
+    K_BOX,
+    K_BLEND,
+    K_COUNT
+};
+
+static const char* kernelName(int k) {
+    static const char* names[] = {"interleave", "deinterleave", "dither 10->8", "hflip 8bit",
+                                  "hflip 16bit", "hflip 32bit", "box 2x2", "blend"};
+    return names[k];
+}
+
+// 一次内核调用：按 (w, h, off, negative, seed) 生成的输入 / 输出平面和调用本身。
+// run 使用调用时选中的指令集；outputs 为输出平面在 planes 中的下标
+struct Job {
+    std::vector<Plane> planes;
+    std::vector<int> outputs;
+    std::function<void()> run;
+
+    // 所有输出平面的完整内存（包括行尾之外的字节）
+    std::vector<uint8_t> result() const {
+        std::vector<uint8_t> out;
+        for (int i : outputs) out.insert(out.end(), planes[i].mem.begin(), planes[i].mem.end());
+        return out;
+    }
+};
+
+static std::unique_ptr<Job> makeJob(int k, int w, int h, int off, bool neg, uint32_t seed) {
+    std::unique_ptr<Job> j(new Job);
+    std::vector<Plane>& p = j->planes;
+    switch (k) {
+    case K_INTERLEAVE:
+        p.push_back(makePlane(w, h, off, neg, 1, seed));
+        p.push_back(makePlane(w, h, off + 1, neg, 1, seed + 1));
+        p.push_back(makePlane(2 * w, h, off + 2, neg, 1, seed + 2));
+        j->outputs = {2};
+        j->run = [&p, w, h] {
+            interleaveUV(p[0].row0, p[0].stride, p[1].row0, p[1].stride, p[2].row0, p[2].stride, w, h);
+        };
+        break;
+    case K_DEINTERLEAVE:
+        p.push_back(makePlane(2 * w, h, off, neg, 1, seed));
+        p.push_back(makePlane(w, h, off + 1, neg, 1, seed + 1));
+        p.push_back(makePlane(w, h, off + 2, neg, 1, seed + 2));
+        j->outputs = {1, 2};
+        j->run = [&p, w, h] {
+            deinterleaveUV(p[0].row0, p[0].stride, p[1].row0, p[1].stride, p[2].row0, p[2].stride, w, h);
+        };
+        break;
+    case K_DITHER:
+        p.push_back(makePlane(2 * w, h, off, neg, 2, seed, 0x3ff));
+        p.push_back(makePlane(w, h, off + 1, neg, 1, seed + 1));
+        j->outputs = {1};
+        j->run = [&p, w, h, off] {
+            dither10to8((const uint16_t*)p[0].row0, p[0].stride, p[1].row0, p[1].stride, w, h, off);
+        };
+        break;
+    case K_HFLIP1:
+    case K_HFLIP2:
+    case K_HFLIP4: {
+        int e = k == K_HFLIP1 ? 1 : k == K_HFLIP2 ? 2 : 4;
+        p.push_back(makePlane(w * e, h, off, neg, e, seed));
+        p.push_back(makePlane(w * e, h, off + 1, neg, e, seed + 1));
+        j->outputs = {1};
+        j->run = [&p, w, h, e] { hflipPlane(p[0].row0, p[0].stride, p[1].row0, p[1].stride, w, h, e); };
+        break;
+    }
+    case K_BOX:
+        p.push_back(makePlane(2 * w, 2 * h, off, neg, 1, seed));
+        p.push_back(makePlane(w, h, off + 1, neg, 1, seed + 1));
+        j->outputs = {1};
+        j->run = [&p, w, h] { boxDownscale2x(p[0].row0, p[0].stride, p[1].row0, p[1].stride, w, h); };
+        break;
+    case K_BLEND:
+        // premul 不超过 255 - invAlpha（真实叠加层满足的约束）时没有饱和，这里用任意值，饱和路径也一并检查
+        p.push_back(makePlane(w, h, off, neg, 1, seed));
+        p.push_back(makePlane(w, h, off + 1, neg, 1, seed + 1));
+        p.push_back(makePlane(w, h, off + 2, neg, 1, seed + 2));
+        j->outputs = {0};
+        j->run = [&p, w, h] {
+            blendPremultiplied(p[0].row0, p[0].stride, p[1].row0, p[1].stride, p[2].row0, p[2].stride, w, h);
+        };
+        break;
+    }
+    return j;
+}
+
+static int check() {
+    std::vector<int> widths;
+    for (int w = 1; w <= 130; ++w) widths.push_back(w);
+    for (int w : {255, 257, 511, 513, 1023, 1917}) widths.push_back(w);
+
+    int failures = 0;
+    for (const char* isa : kIsas) {
+        if (!strcmp(isa, "c")) continue;
+        if (!setPixelKernelIsa(isa)) {
+            std::cout << "[kernelcheck] " << isa << ": not supported by this CPU, skipped\n";
+            continue;
+        }
+        for (int k = 0; k < K_COUNT; ++k) {
+            int cases = 0, bad = 0;
+            for (int w : widths) {
+                for (int off = 0; off < 4; ++off) {
+                    for (bool neg : {false, true}) {
+                        const int h = 3;
+                        uint32_t seed = 0x9e3779b9u ^ (uint32_t)(w * 131 + off * 7 + neg);
+                        std::unique_ptr<Job> ref = makeJob(k, w, h, off, neg, seed);
+                        std::unique_ptr<Job> got = makeJob(k, w, h, off, neg, seed);
+                        setPixelKernelIsa("c");
+                        ref->run();
+                        setPixelKernelIsa(isa);
+                        got->run();
+                        ++cases;
+                        if (ref->result() != got->result()) {
+                            if (bad++ == 0)
+                                std::cout << "[kernelcheck] " << isa << " " << kernelName(k) << " differs from c at width "
+                                          << w << ", offset " << off << (neg ? ", negative stride" : "") << "\n";
+                        }
+                    }
+                }
+            }
+            std::cout << "[kernelcheck] " << std::left << std::setw(7) << isa << std::setw(14) << kernelName(k)
+                      << std::right << (bad ? "FAILED " : "ok ") << cases - bad << "/" << cases << "\n";
+            failures += bad;
+        }
+    }
+    setPixelKernelIsa("c");
+    return failures ? 1 : 0;
+}
+
+static void bench() {
+    const int w = 1920, h = 1080, iterations = 50;
+    std::vector<double> cMs(K_COUNT, 0.0);
+    std::cout << "[kernelbench] " << w << "x" << h << ", ms per call (speedup vs c)\n";
+    for (const char* isa : kIsas) {
+        if (!setPixelKernelIsa(isa)) continue;
+        for (int k = 0; k < K_COUNT; ++k) {
+            // 宽度按输出元素算：interleave / deinterleave / box 的输出宽度取一半，数据量与整帧平面相当
+            int kw = (k == K_INTERLEAVE || k == K_DEINTERLEAVE || k == K_BOX) ? w / 2 : w;
+            int kh = k == K_BOX ? h / 2 : h;
+            std::unique_ptr<Job> job = makeJob(k, kw, kh, 0, false, 1);
+            job->run();  // 预热
+            double best = 1e9;
+            for (int i = 0; i < iterations; ++i) {
+                auto t0 = std::chrono::steady_clock::now();
+                job->run();
+                best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count());
+            }
+            if (!strcmp(isa, "c")) cMs[k] = best;
+            std::cout << "  " << std::left << std::setw(7) << isa << std::setw(14) << kernelName(k) << std::right
+                      << std::fixed << std::setprecision(3) << best << " ms";
+            if (strcmp(isa, "c")) std::cout << " (" << std::setprecision(1) << cMs[k] / best << "x)";
+            std::cout << "\n" << std::defaultfloat;
+        }
+    }
+    setPixelKernelIsa("c");
+}
+
+int main(int argc, char* argv[]) {
+    if (argc >= 2 && !strcmp(argv[1], "bench")) {
+        bench();
+        return 0;
+    }
+    return check();
+}
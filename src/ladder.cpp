@@ -0,0 +1,121 @@
+#include <iostream>
+#include <thread>
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+
+#include "demuxer.h"
+#include "queue.h"
+#include "videodecoder.h"
+#include "abrladder.h"
+#include "muxer.h"
+#include "complexityprobe.h"
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+}
+
+// 码率阶梯（ABR）输出：源只解码一次，按阶梯缩放成多档分别编码，每档写一个 MP4（<prefix>_<高度>p.mp4）。
+// 各档只有视频，音频作为单独的一路在打包（HLS / DASH）时加入。
+// 默认先用 ComplexityProbe 试编码几段，按片源复杂度给各档定码率（per-title），再正式编码。
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " input.mp4 [output_prefix] [mode]\n"
+                  << "  mode: probe (default, per-title bitrates) | fixed (fixed ladder) | print (probe, print the ladder and exit)\n";
+        return -1;
+    }
+    const std::string inputFile = argv[1];
+    const std::string prefix = argc >= 3 ? argv[2] : "ladder";
+    const std::string mode = argc >= 4 ? argv[3] : "probe";
+    if (mode != "probe" && mode != "fixed" && mode != "print") {
+        std::cerr << "Unknown mode: " << mode << "\n";
+        return -1;
+    }
+
+    Demuxer demuxer(inputFile);
+    if (!demuxer.open() || !demuxer.getVideoCodecParameters()) {
+        std::cerr << "Failed to open input file\n";
+        return -1;
+    }
+
+    VideoDecoder decoder(demuxer.getVideoCodecParameters());
+    if (!decoder.open()) {
+        std::cerr << "Failed to open video decoder\n";
+        return -1;
+    }
+    AVCodecContext* decCtx = decoder.getCodecContext();
+
+    // 固定阶梯，高于源的档不输出（不放大）
+    const LadderRung fixedLadder[] = {
+        {-2, 1080, 5000000},
+        {-2, 720, 3000000},
+        {-2, 480, 1500000},
+        {-2, 360, 800000},
+    };
+    std::vector<LadderRung> rungs;
+    for (const LadderRung& r : fixedLadder) {
+        if (r.height <= decCtx->height) rungs.push_back(r);
+    }
+    if (rungs.empty()) rungs.push_back(fixedLadder[3]);
+
+    if (mode != "fixed") {
+        ComplexityProbe probe;
+        bool probed = probe.run(inputFile);
+        if (probed) {
+            probe.printStats();
+            std::vector<LadderRung> derived = probe.deriveLadder(rungs);
+            for (size_t i = 0; i < rungs.size(); ++i) {
+                std::cout << "[Ladder] " << rungs[i].height << "p: " << rungs[i].bitrate / 1000 << " -> "
+                          << derived[i].bitrate / 1000 << " kbps\n";
+            }
+            rungs = derived;
+        } else {
+            std::cerr << "ComplexityProbe failed, using the fixed ladder\n";
+        }
+        if (mode == "print") return probed ? 0 : -1;
+    }
+
+    AVRational frameRate = demuxer.videoFrameRate();
+    int fps = std::max(1, (int)(av_q2d(frameRate) + 0.5));
+
+    // 帧的 pts 沿用输入包的时间戳，滤镜和编码器按包实际的时间基建立
+    AbrLadder ladder;
+    if (!ladder.open(decCtx, rungs, fps, 60, demuxer.getVideoTimeBase())) {
+        std::cerr << "Failed to open AbrLadder\n";
+        return -1;
+    }
+
+    // 每档一个 Muxer，直接读该档的输出队列
+    std::vector<std::unique_ptr<Muxer>> muxers;
+    for (int i = 0; i < ladder.rungCount(); ++i) {
+        std::string name = prefix + "_" + std::to_string(ladder.encoderContext(i)->height) + "p.mp4";
+        std::unique_ptr<Muxer> muxer(new Muxer(name));
+        if (muxer->addStream(ladder.encoderContext(i), ladder.output(i)) < 0 || !muxer->start()) {
+            std::cerr << "Failed to start Muxer for " << name << "\n";
+            return -1;
+        }
+        muxers.push_back(std::move(muxer));
+    }
+
+    PacketQueue<AVPacket*> videoQueue;
+    std::thread reader([&]{
+        while (AVPacket* pkt = demuxer.readVideoPacket()) videoQueue.push(pkt);
+        videoQueue.push(nullptr);
+    });
+
+    decoder.decode(videoQueue, [&](AVFrame* frame) {
+        if (frame && frame->data[0]) ladder.pushFrame(frame);
+    });
+    reader.join();
+
+    // 各档编码线程退出后输出队列随之结束，Muxer 写完剩余的包后收尾
+    ladder.finish();
+    bool ok = true;
+    for (auto& m : muxers) {
+        if (!m->finish()) ok = false;
+        m->printStats();
+    }
+    if (!ok) std::cerr << "Failed to write ladder outputs\n";
+    return ok ? 0 : -1;
+}
@@ -0,0 +1,110 @@
+#include "ladderfilter.h"
+#include <iostream>
+#include <sstream>
+
+LadderFilter::LadderFilter() {}
+LadderFilter::~LadderFilter() {
+    if (filterGraph_) {
+        avfilter_graph_free(&filterGraph_);
+    }
+}
+
+bool LadderFilter::init(AVCodecContext* decCtx, const std::vector<LadderRung>& rungs, AVRational timeBase) {
+    if (!decCtx || decCtx->width <=0 || decCtx->height <=0 || rungs.empty()) {
+        std::cerr << "LadderFilter: invalid codec context or empty ladder\n";
+        return false;
+    }
+
+    AVRational tb = timeBase.num > 0 ? timeBase : decCtx->time_base;
+    if (tb.num <=0 || tb.den <=0) tb = {1,25};
+
+    AVRational sar = decCtx->sample_aspect_ratio;
+    if (sar.num <=0 || sar.den <=0) sar = {1,1};
+
+    char args[512];
+    snprintf(args, sizeof(args),
+             "video_size=%dx%d:pix_fmt=%d:time_base=%d/%d:pixel_aspect=%d/%d",
+             decCtx->width, decCtx->height, decCtx->pix_fmt,
+             tb.num, tb.den,
+             sar.num, sar.den);
+
+    filterGraph_ = avfilter_graph_alloc();
+    if (!filterGraph_) return false;
+
+    int ret = avfilter_graph_create_filter(&buffersrcCtx_, avfilter_get_by_name("buffer"), "src",
+                                           args, nullptr, filterGraph_);
+    if (ret < 0) {
+        std::cerr << "LadderFilter: failed to create buffer source\n";
+        return false;
+    }
+
+    int n = (int)rungs.size();
+    sinkCtxs_.assign(n, nullptr);
+
+    // [in]split=N[s0][s1]...;[s0]scale=w=..:h=..[out0];...
+    std::ostringstream desc;
+    desc << "[in]split=" << n;
+    for (int i = 0; i < n; ++i) desc << "[s" << i << "]";
+    for (int i = 0; i < n; ++i) {
+        desc << ";[s" << i << "]scale=w=" << rungs[i].width << ":h=" << rungs[i].height
+             << "[out" << i << "]";
+    }
+
+    AVFilterInOut* inputs = nullptr;
+    for (int i = n - 1; i >= 0; --i) {
+        std::string name = "sink" + std::to_string(i);
+        ret = avfilter_graph_create_filter(&sinkCtxs_[i], avfilter_get_by_name("buffersink"),
+                                           name.c_str(), nullptr, nullptr, filterGraph_);
+        if (ret < 0) {
+            std::cerr << "LadderFilter: failed to create buffer sink " << i << "\n";
+            avfilter_inout_free(&inputs);
+            return false;
+        }
+
+        AVFilterInOut* in = avfilter_inout_alloc();
+        in->name       = av_strdup(("out" + std::to_string(i)).c_str());
+        in->filter_ctx = sinkCtxs_[i];
+        in->pad_idx    = 0;
+        in->next       = inputs;
+        inputs = in;
+    }
+
+    AVFilterInOut* outputs = avfilter_inout_alloc();
+    outputs->name       = av_strdup("in");
+    outputs->filter_ctx = buffersrcCtx_;
+    outputs->pad_idx    = 0;
+    outputs->next       = nullptr;
+
+    ret = avfilter_graph_parse_ptr(filterGraph_, desc.str().c_str(), &inputs, &outputs, nullptr);
+    avfilter_inout_free(&inputs);
+    avfilter_inout_free(&outputs);
+    if (ret < 0) {
+        char errbuf[128]; av_strerror(ret, errbuf, sizeof(errbuf));
+        std::cerr << "LadderFilter: failed to parse graph: " << errbuf << "\n";
+        return false;
+    }
+
+    if ((ret = avfilter_graph_config(filterGraph_, nullptr)) < 0) {
+        char errbuf[128]; av_strerror(ret, errbuf, sizeof(errbuf));
+        std::cerr << "LadderFilter: failed to configure graph: " << errbuf << "\n";
+        return false;
+    }
+
+    return true;
+}
+
+void LadderFilter::filterFrame(AVFrame* frame, std::function<void(int, AVFrame*)> callback) {
+    if (!filterGraph_) return;
+
+    int ret = av_buffersrc_add_frame_flags(buffersrcCtx_, frame, AV_BUFFERSRC_FLAG_KEEP_REF);
+    if (ret < 0) return;
+
+    AVFrame* filtFrame = av_frame_alloc();
+    for (int i = 0; i < (int)sinkCtxs_.size(); ++i) {
+        while (av_buffersink_get_frame(sinkCtxs_[i], filtFrame) >= 0) {
+            callback(i, filtFrame);
+            av_frame_unref(filtFrame);
+        }
+    }
+    av_frame_free(&filtFrame);
+}
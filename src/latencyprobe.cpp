@@ -0,0 +1,77 @@
+#include "latencyprobe.h"
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+
+static const char* kStageNames[LatencyProbe::STAGE_COUNT] = {"encoded", "sent", "displayed"};
+
+// 超过这个数量的未完成记录按最早的开始清理（对应的帧已经丢了）
+static const size_t kMaxPending = 1024;
+
+int64_t LatencyProbe::nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void LatencyProbe::capture(int64_t pts) {
+    int64_t now = nowUs();
+    std::lock_guard<std::mutex> lock(mutex_);
+    captured_[pts] = now;
+    ++captures_;
+    while (captured_.size() > kMaxPending) captured_.erase(captured_.begin());
+}
+
+void LatencyProbe::mark(int64_t pts, Stage stage) {
+    int64_t now = nowUs();
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = captured_.find(pts);
+    if (it == captured_.end()) return;
+    samples_[stage].push_back(now - it->second);
+    // 最后一个阶段之后不会再用到
+    if (stage == STAGE_DISPLAYED) captured_.erase(it);
+}
+
+int64_t LatencyProbe::lost() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return captures_ - (int64_t)samples_[STAGE_DISPLAYED].size();
+}
+
+double LatencyProbe::percentile(Stage stage, double p) const {
+    std::vector<int64_t> v;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        v = samples_[stage];
+    }
+    if (v.empty()) return -1.0;
+    size_t k = std::min(v.size() - 1, (size_t)(p / 100.0 * (v.size() - 1) + 0.5));
+    std::nth_element(v.begin(), v.begin() + k, v.end());
+    return v[k] / 1000.0;
+}
+
+double LatencyProbe::mean(Stage stage) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const std::vector<int64_t>& v = samples_[stage];
+    if (v.empty()) return -1.0;
+    double sum = 0.0;
+    for (int64_t x : v) sum += x;
+    return sum / v.size() / 1000.0;
+}
+
+void LatencyProbe::printStats() const {
+    int64_t captures;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        captures = captures_;
+    }
+    std::cout << "[LatencyProbe] captured " << captures << " frames, lost " << lost() << "\n";
+    std::cout << std::fixed << std::setprecision(1);
+    for (int s = 0; s < STAGE_COUNT; ++s) {
+        Stage st = (Stage)s;
+        if (percentile(st, 50) < 0) continue;
+        std::cout << "  " << std::setw(9) << kStageNames[s] << ": mean " << mean(st)
+                  << " ms, p50 " << percentile(st, 50) << " ms, p95 " << percentile(st, 95)
+                  << " ms, max " << percentile(st, 100) << " ms\n";
+    }
+    std::cout << std::defaultfloat;
+}
@@ -0,0 +1,148 @@
+#include <iostream>
+#include <thread>
+#include <cstdlib>
+#include <cstdio>
+#include <atomic>
+
+#include "queue.h"
+#include "ringbuffer.h"
+#include "videodecoder.h"
+#include "videoencoder.h"
+#include "encoderprofile.h"
+#include "syntheticsource.h"
+#include "latencyprobe.h"
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+}
+
+// 低延迟直播链路：合成信号源 -> 编码（live profile）-> MPEG-TS 逐包立即写出 -> 本地解码（模拟观看端），
+// 用 LatencyProbe 测量每帧从“采集”到解码出画面的延迟（glass-to-glass，不含显示器刷新）。
+// 各环节都不攒帧：采集到编码之间只有一格缓冲，满了丢帧；编码出的包当场写出并送给观看端。
+int main(int argc, char* argv[]) {
+    int seconds = argc >= 2 ? std::atoi(argv[1]) : 10;
+    const std::string outputFile = argc >= 3 ? argv[2] : "live.ts";
+    const std::string profileSpec = argc >= 4 ? argv[3] : "live";
+    int width = 1280, height = 720;
+    if (argc >= 5 && sscanf(argv[4], "%dx%d", &width, &height) != 2) {
+        std::cerr << "Usage: " << argv[0] << " [seconds] [output.ts] [profile] [WxH] [fps]\n";
+        return -1;
+    }
+    int fps = argc >= 6 ? std::atoi(argv[5]) : 30;
+
+    EncoderProfile profile;
+    if (!EncoderProfile::parse(profileSpec, profile)) return -1;
+
+    LatencyProbe probe;
+    SyntheticSource source(width, height, fps);
+    source.setLatencyProbe(&probe);
+
+    VideoEncoder encoder;
+    encoder.setProfile(profile);
+    if (!encoder.open(source.width(), source.height(), source.timeBase(), source.pixelFormat(), source.fps())) {
+        std::cerr << "Failed to open VideoEncoder\n";
+        return -1;
+    }
+    AVCodecContext* encCtx = encoder.getCodecContext();
+
+    // 输出：MPEG-TS，每个包写完立即 flush 到文件 / 网络
+    AVFormatContext* outCtx = nullptr;
+    if (avformat_alloc_output_context2(&outCtx, nullptr, "mpegts", outputFile.c_str()) < 0) {
+        std::cerr << "Failed to allocate output context\n";
+        return -1;
+    }
+    AVStream* outStream = avformat_new_stream(outCtx, nullptr);
+    if (!outStream || avcodec_parameters_from_context(outStream->codecpar, encCtx) < 0) {
+        std::cerr << "Failed to create output stream\n";
+        return -1;
+    }
+    outStream->time_base = encCtx->time_base;
+    outCtx->flush_packets = 1;
+    if (!(outCtx->oformat->flags & AVFMT_NOFILE) &&
+        avio_open(&outCtx->pb, outputFile.c_str(), AVIO_FLAG_WRITE) < 0) {
+        std::cerr << "Failed to open output file " << outputFile << "\n";
+        return -1;
+    }
+    if (avformat_write_header(outCtx, nullptr) < 0) {
+        std::cerr << "Failed to write output header\n";
+        return -1;
+    }
+
+    // 观看端：低延迟解码，解出一帧即记为显示
+    AVCodecParameters* viewerPar = avcodec_parameters_alloc();
+    avcodec_parameters_from_context(viewerPar, encCtx);
+    VideoDecoder viewer(viewerPar);
+    viewer.setLowDelay(true);
+    if (!viewer.open()) {
+        std::cerr << "Failed to open viewer decoder\n";
+        return -1;
+    }
+    PacketQueue<AVPacket*> viewerQueue;
+    std::thread viewerThread([&] {
+        viewer.decode(viewerQueue, [&](AVFrame* frame) {
+            int64_t pts = frame->pts != AV_NOPTS_VALUE ? frame->pts : frame->best_effort_timestamp;
+            probe.mark(pts, LatencyProbe::STAGE_DISPLAYED);
+        });
+    });
+
+    // 采集 -> 编码只留一格：编码跟不上时丢新帧，延迟不会累积
+    RingBuffer<AVFrame*> frames(1);
+    std::atomic<int64_t> ringDrops{0};
+
+    std::thread encodeThread([&] {
+        PacketQueue<AVPacket*> pktQueue;
+        // 编码出的包立即写出，同时送给观看端
+        auto send = [&] {
+            while (!pktQueue.empty()) {
+                AVPacket* pkt = pktQueue.pop();
+                probe.mark(pkt->pts, LatencyProbe::STAGE_ENCODED);
+
+                AVPacket* muxPkt = av_packet_clone(pkt);
+                if (muxPkt) {
+                    av_packet_rescale_ts(muxPkt, encCtx->time_base, outStream->time_base);
+                    muxPkt->stream_index = outStream->index;
+                    if (av_write_frame(outCtx, muxPkt) < 0) std::cerr << "Failed to write packet\n";
+                    av_packet_free(&muxPkt);
+                }
+                probe.mark(pkt->pts, LatencyProbe::STAGE_SENT);
+                viewerQueue.push(pkt);
+            }
+        };
+
+        AVFrame* frame = nullptr;
+        while (frames.pop(frame)) {
+            if (!frame) continue;
+            if (!encoder.encode(frame, pktQueue)) std::cerr << "[EncodeThread] encode failed\n";
+            av_frame_free(&frame);
+            send();
+        }
+        encoder.flush(pktQueue);
+        send();
+        viewerQueue.stop();
+    });
+
+    std::cout << "Live: " << source.width() << "x" << source.height() << "@" << source.fps()
+              << " for " << seconds << "s, profile " << profile.name << " -> " << outputFile << "\n";
+    source.run((int64_t)seconds * source.fps(), [&](AVFrame* frame) {
+        AVFrame* ref = av_frame_clone(frame);
+        if (ref && !frames.tryPush(ref)) {
+            av_frame_free(&ref);
+            ++ringDrops;
+        }
+    });
+    frames.stop();
+
+    encodeThread.join();
+    viewerThread.join();
+
+    av_write_trailer(outCtx);
+    if (!(outCtx->oformat->flags & AVFMT_NOFILE)) avio_closep(&outCtx->pb);
+    avformat_free_context(outCtx);
+    encoder.close();
+    avcodec_parameters_free(&viewerPar);
+
+    std::cout << "[Source] produced " << source.produced() << ", dropped at source " << source.dropped()
+              << ", dropped before encoder " << ringDrops.load() << "\n";
+    probe.printStats();
+    return 0;
+}
@@ -0,0 +1,111 @@
+#include "motionanalyzer.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+MotionAnalyzer::MotionAnalyzer(double staticThreshold, double staticFrameRatio, int minStaticFrames)
+    : staticThreshold_(staticThreshold),
+      staticFrameRatio_(staticFrameRatio),
+      minStaticFrames_(minStaticFrames) {}
+
+static double median(std::vector<double>& v) {
+    if (v.empty()) return 0.0;
+    size_t mid = v.size() / 2;
+    std::nth_element(v.begin(), v.begin() + mid, v.end());
+    return v[mid];
+}
+
+MotionSummary MotionAnalyzer::analyze(const AVFrame* frame) {
+    MotionSummary s;
+    if (!frame) return s;
+
+    s.pts = frame->best_effort_timestamp != AV_NOPTS_VALUE ? frame->best_effort_timestamp : frame->pts;
+    frames_++;
+
+    AVFrameSideData* sd = av_frame_get_side_data(frame, AV_FRAME_DATA_MOTION_VECTORS);
+    if (!sd || sd->size < (int)sizeof(AVMotionVector)) {
+        // I 帧：没有运动信息，不影响静止片段判断
+        return s;
+    }
+
+    const AVMotionVector* mvs = (const AVMotionVector*)sd->data;
+    int count = sd->size / sizeof(AVMotionVector);
+
+    dxs_.clear();
+    dys_.clear();
+
+    double weighted = 0.0;
+    double area = 0.0;
+    double staticArea = 0.0;
+    for (int i = 0; i < count; ++i) {
+        const AVMotionVector& mv = mvs[i];
+        double scale = mv.motion_scale ? mv.motion_scale : 1.0;
+        double dx = mv.motion_x / scale;
+        double dy = mv.motion_y / scale;
+        // 参考未来帧的矢量方向相反，统一成“相对前一帧”的位移
+        if (mv.source > 0) { dx = -dx; dy = -dy; }
+
+        double mag = std::sqrt(dx * dx + dy * dy);
+        double blockArea = (double)mv.w * mv.h;
+
+        weighted += mag * blockArea;
+        area += blockArea;
+        if (mag < staticThreshold_) staticArea += blockArea;
+        if (mag > s.maxMagnitude) s.maxMagnitude = mag;
+
+        dxs_.push_back(dx);
+        dys_.push_back(dy);
+    }
+
+    s.hasVectors = true;
+    s.vectorCount = count;
+    if (area > 0) {
+        s.meanMagnitude = weighted / area;
+        s.staticRatio = staticArea / area;
+    }
+    s.globalDx = median(dxs_);
+    s.globalDy = median(dys_);
+
+    motionFrames_++;
+    magnitudeSum_ += s.meanMagnitude;
+
+    if (frames_ > thumbSkipFrames_ &&
+        (thumbPts_ == AV_NOPTS_VALUE || s.meanMagnitude < thumbMagnitude_)) {
+        thumbPts_ = s.pts;
+        thumbMagnitude_ = s.meanMagnitude;
+    }
+
+    updateStaticSegment(s);
+    return s;
+}
+
+void MotionAnalyzer::updateStaticSegment(const MotionSummary& s) {
+    if (s.staticRatio >= staticFrameRatio_) {
+        if (current_.frames == 0) current_.startPts = s.pts;
+        current_.endPts = s.pts;
+        current_.frames++;
+        return;
+    }
+
+    if (current_.frames >= minStaticFrames_) segments_.push_back(current_);
+    current_ = StaticSegment();
+}
+
+void MotionAnalyzer::finish() {
+    if (current_.frames >= minStaticFrames_) segments_.push_back(current_);
+    current_ = StaticSegment();
+}
+
+double MotionAnalyzer::averageMagnitude() const {
+    return motionFrames_ ? magnitudeSum_ / motionFrames_ : 0.0;
+}
+
+void MotionAnalyzer::printStats(AVRational timeBase) const {
+    auto seconds = [&](int64_t pts) { return pts == AV_NOPTS_VALUE ? -1.0 : pts * av_q2d(timeBase); };
+    std::cout << "[MotionAnalyzer] frames: " << frames_ << ", average motion: " << averageMagnitude()
+              << " px, thumbnail at " << seconds(thumbPts_) << "s\n";
+    for (const StaticSegment& seg : segments_) {
+        std::cout << "  static " << seconds(seg.startPts) << "s - " << seconds(seg.endPts) << "s ("
+                  << seg.frames << " frames)\n";
+    }
+}
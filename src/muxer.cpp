@@ -0,0 +1,334 @@
+#include "muxer.h"
+#include <iostream>
+#include <chrono>
+#include <climits>
+#include <cstring>
+
+Muxer::Muxer(const std::string& filename, const std::string& format)
+    : filename_(filename) {
+    if (avformat_alloc_output_context2(&fmtCtx_, nullptr, format.empty() ? nullptr : format.c_str(),
+                                       filename.c_str()) < 0 || !fmtCtx_) {
+        std::cerr << "Muxer: failed to allocate output context for " << filename << "\n";
+        fmtCtx_ = nullptr;
+    }
+}
+
+Muxer::~Muxer() {
+    if (thread_.joinable()) {
+        // 生产者没有结束队列时也不能卡在析构里
+        abort_ = true;
+        thread_.join();
+    }
+    finish();
+}
+
+int Muxer::addStream(const AVCodecParameters* par, AVRational packetTimeBase, PacketQueue<AVPacket*>& queue) {
+    if (!fmtCtx_ || !par || headerWritten_) return -1;
+    if (fragmented_ && par->codec_type == AVMEDIA_TYPE_VIDEO && par->extradata_size <= 0) {
+        std::cerr << "Muxer: fragmented output needs the video parameter sets in extradata "
+                     "(open the encoder with a global header)\n";
+        return -1;
+    }
+
+    AVStream* st = avformat_new_stream(fmtCtx_, nullptr);
+    if (!st || avcodec_parameters_copy(st->codecpar, par) < 0) {
+        std::cerr << "Muxer: failed to add stream\n";
+        return -1;
+    }
+    // 编码器的 tag 不一定适合这个容器，交给封装器选
+    st->codecpar->codec_tag = 0;
+    // 只是建议值，写文件头时封装器可能改成自己的时间基
+    st->time_base = packetTimeBase;
+
+    std::unique_ptr<Stream> s(new Stream);
+    s->st = st;
+    s->index = st->index;
+    s->type = par->codec_type;
+    s->queue = &queue;
+    s->srcTb = packetTimeBase;
+    streams_.push_back(std::move(s));
+    return st->index;
+}
+
+int Muxer::addStream(const AVCodecContext* encCtx, PacketQueue<AVPacket*>& queue) {
+    if (!encCtx) return -1;
+    AVCodecParameters* par = avcodec_parameters_alloc();
+    if (!par) return -1;
+    int index = -1;
+    // 音频编码器的包以 1/sample_rate 计时（没有设置 time_base 时）
+    AVRational tb = encCtx->time_base;
+    if ((tb.num <= 0 || tb.den <= 0) && encCtx->sample_rate > 0) tb = AVRational{1, encCtx->sample_rate};
+    if (avcodec_parameters_from_context(par, encCtx) >= 0)
+        index = addStream(par, tb, queue);
+    avcodec_parameters_free(&par);
+    return index;
+}
+
+void Muxer::setFragmented(FragmentCallback callback, double fragmentSeconds) {
+    if (headerWritten_) return;
+    fragmented_ = true;
+    fragmentCb_ = std::move(callback);
+    fragmentSeconds_ = fragmentSeconds;
+}
+
+bool Muxer::start() {
+    if (!fmtCtx_ || streams_.empty() || headerWritten_) return false;
+
+    if (fragmented_) {
+        if (!openFragmentedOutput()) return false;
+    } else if (!(fmtCtx_->oformat->flags & AVFMT_NOFILE) &&
+               avio_open(&fmtCtx_->pb, filename_.c_str(), AVIO_FLAG_WRITE) < 0) {
+        std::cerr << "Muxer: failed to open " << filename_ << "\n";
+        return false;
+    }
+
+    // libavformat 内部的交错缓冲也按同一个窗口限制
+    fmtCtx_->max_interleave_delta = windowUs_;
+
+    AVDictionary* opts = nullptr;
+    for (const auto& kv : options_) av_dict_set(&opts, kv.first.c_str(), kv.second.c_str(), 0);
+    int ret = avformat_write_header(fmtCtx_, &opts);
+    AVDictionaryEntry* e = nullptr;
+    while ((e = av_dict_get(opts, "", e, AV_DICT_IGNORE_SUFFIX)))
+        std::cerr << "Muxer: option " << e->key << " not used by " << fmtCtx_->oformat->name << "\n";
+    av_dict_free(&opts);
+    if (ret < 0) {
+        std::cerr << "Muxer: failed to write header\n";
+        return false;
+    }
+    headerWritten_ = true;
+    // 初始化段
+    if (fragmented_) emitFragments(AV_NOPTS_VALUE);
+
+    abort_ = false;
+    thread_ = std::thread(&Muxer::run, this);
+    return true;
+}
+
+bool Muxer::finish() {
+    if (thread_.joinable()) thread_.join();
+    if (!fmtCtx_) return !failed_;
+
+    if (headerWritten_ && av_write_trailer(fmtCtx_) < 0) {
+        std::cerr << "Muxer: failed to write trailer\n";
+        failed_ = true;
+    }
+    if (fragmented_) {
+        // 最后一个分片在写文件尾时刷出，结束时间取已写出的包的最大结束时间
+        if (headerWritten_) emitFragments(lastEndUs_);
+        if (fmtCtx_->pb) av_freep(&fmtCtx_->pb->buffer);
+        avio_context_free(&fmtCtx_->pb);
+        avio_closep(&sink_);
+    } else if (!(fmtCtx_->oformat->flags & AVFMT_NOFILE)) {
+        avio_closep(&fmtCtx_->pb);
+    }
+
+    // 没写出去的包（中途放弃时）
+    for (auto& s : streams_) {
+        for (AVPacket* p : s->pending) av_packet_free(&p);
+        s->pending.clear();
+    }
+    avformat_free_context(fmtCtx_);
+    fmtCtx_ = nullptr;
+    return !failed_;
+}
+
+int64_t Muxer::packetTime(const Stream& s, const AVPacket* pkt) const {
+    int64_t t = pkt->dts != AV_NOPTS_VALUE ? pkt->dts : pkt->pts;
+    if (t == AV_NOPTS_VALUE) return INT64_MIN;
+    return av_rescale_q(t, s.srcTb, AV_TIME_BASE_Q);
+}
+
+void Muxer::pull(Stream& s, int waitMs) {
+    AVPacket* pkt = nullptr;
+    while (!s.ended && s.queue->tryPop(pkt, std::chrono::milliseconds(waitMs))) {
+        waitMs = 0;
+        // 有的生产者用 nullptr 表示结束
+        if (!pkt) {
+            s.ended = true;
+            break;
+        }
+        s.pending.push_back(pkt);
+    }
+    if (!s.ended && s.queue->finished()) s.ended = true;
+}
+
+void Muxer::writeHead(Stream& s) {
+    AVPacket* pkt = s.pending.front();
+    s.pending.pop_front();
+
+    int64_t t = packetTime(s, pkt);
+    if (t != INT64_MIN) {
+        if (fragStartUs_ == AV_NOPTS_VALUE) fragStartUs_ = t;
+        int64_t end = t + (pkt->duration > 0 ? av_rescale_q(pkt->duration, s.srcTb, AV_TIME_BASE_Q) : 0);
+        if (lastEndUs_ == AV_NOPTS_VALUE || end > lastEndUs_) lastEndUs_ = end;
+    }
+
+    av_packet_rescale_ts(pkt, s.srcTb, s.st->time_base);
+    pkt->stream_index = s.st->index;
+    // dts 单调递增的唯一保证：换算后的取整、编码器换实例 / 分段编码的段首外推都可能让 dts 不增，封装器要求严格递增
+    if (pkt->dts != AV_NOPTS_VALUE && s.lastDts != AV_NOPTS_VALUE && pkt->dts <= s.lastDts) {
+        pkt->dts = s.lastDts + 1;
+        if (pkt->pts != AV_NOPTS_VALUE && pkt->pts < pkt->dts) pkt->pts = pkt->dts;
+    }
+    if (pkt->dts != AV_NOPTS_VALUE) s.lastDts = pkt->dts;
+
+    s.packets++;
+    s.bytes += pkt->size;
+    // av_interleaved_write_frame 接管包的数据，包本身仍由这里释放。
+    // 分片模式下包已经按 dts 交错好，直接写出：封装器在这个包（关键帧）之前切分片，
+    // 写完返回时刚切出的分片已经完整，结束时间就是这个包的时间
+    int ret = fragmented_ ? av_write_frame(fmtCtx_, pkt) : av_interleaved_write_frame(fmtCtx_, pkt);
+    if (ret < 0) {
+        if (!failed_) std::cerr << "Muxer: failed to write packet to stream " << s.st->index << "\n";
+        failed_ = true;
+    }
+    av_packet_free(&pkt);
+    if (fragmented_) emitFragments(t != INT64_MIN ? t : lastEndUs_);
+}
+
+bool Muxer::openFragmentedOutput() {
+    const char* name = fmtCtx_->oformat->name;
+    if (strcmp(name, "mp4") != 0 && strcmp(name, "mov") != 0) {
+        std::cerr << "Muxer: fragmented output needs mp4 or mov, not " << name << "\n";
+        return false;
+    }
+
+    // 关键帧处切分片、文件头只有空的 moov、moof 内偏移以自身为基准（CMAF 的要求），
+    // 不写文件尾的 mfra：输出文件就是初始化段加各个分片
+    auto it = options_.find("movflags");
+    options_["movflags"] = (it == options_.end() ? std::string() : it->second + "+") +
+                           "frag_keyframe+empty_moov+default_base_moof+cmaf+skip_trailer";
+    bool hasVideo = false;
+    for (const auto& s : streams_) {
+        if (s->type != AVMEDIA_TYPE_VIDEO) continue;
+        hasVideo = true;
+        // setFragmented 在 addStream 之后调用时在这里检查
+        if (s->st->codecpar->extradata_size <= 0) {
+            std::cerr << "Muxer: video stream " << s->index << " has no extradata for the init segment\n";
+            return false;
+        }
+    }
+    double seconds = fragmentSeconds_ > 0 ? fragmentSeconds_ : 2.0;
+    if (!hasVideo)
+        options_["frag_duration"] = std::to_string((int64_t)(seconds * AV_TIME_BASE));
+    else if (fragmentSeconds_ > 0)
+        options_["min_frag_duration"] = std::to_string((int64_t)(seconds * AV_TIME_BASE));
+
+    if (avio_open(&sink_, filename_.c_str(), AVIO_FLAG_WRITE) < 0) {
+        std::cerr << "Muxer: failed to open " << filename_ << "\n";
+        return false;
+    }
+    const int bufSize = 64 * 1024;
+    uint8_t* buf = (uint8_t*)av_malloc(bufSize);
+    AVIOContext* pb = buf ? avio_alloc_context(buf, bufSize, 1, this, nullptr, &Muxer::writePacket, nullptr) : nullptr;
+    if (!pb) {
+        av_free(buf);
+        avio_closep(&sink_);
+        std::cerr << "Muxer: failed to allocate output context\n";
+        return false;
+    }
+    // 不可 seek：封装器不会回头改写已经交给下游的字节
+    pb->seekable = 0;
+    pb->write_data_type = &Muxer::writeData;
+    fmtCtx_->pb = pb;
+    fmtCtx_->flags |= AVFMT_FLAG_CUSTOM_IO;
+    return true;
+}
+
+int Muxer::writeData(void* opaque, uint8_t* buf, int size, AVIODataMarkerType type, int64_t) {
+    Muxer* self = static_cast<Muxer*>(opaque);
+    // 分片起点（moof 之前的标记）总是开始新区间；文件头 / 文件尾的数据在类型变化时开始新区间；
+    // 没有标记的数据是前一个区间被缓冲区切开的后半段
+    bool marker = type == AVIO_DATA_MARKER_SYNC_POINT || type == AVIO_DATA_MARKER_BOUNDARY_POINT;
+    if (type == AVIO_DATA_MARKER_HEADER || type == AVIO_DATA_MARKER_TRAILER)
+        marker = self->spans_.empty() || self->spans_.back().kind != type;
+    if (marker || self->spans_.empty()) {
+        Span sp;
+        sp.offset = self->outBytes_;
+        sp.kind = type == AVIO_DATA_MARKER_UNKNOWN ? AVIO_DATA_MARKER_SYNC_POINT : type;
+        self->spans_.push_back(sp);
+    }
+    self->spans_.back().size += size;
+    self->outBytes_ += size;
+
+    avio_write(self->sink_, buf, size);
+    return self->sink_->error < 0 ? self->sink_->error : size;
+}
+
+int Muxer::writePacket(void* opaque, uint8_t* buf, int size) {
+    return writeData(opaque, buf, size, AVIO_DATA_MARKER_UNKNOWN, AV_NOPTS_VALUE);
+}
+
+void Muxer::emitFragments(int64_t endUs) {
+    // 分片由封装器一次写出，刷新之后最后一个区间也已经完整；数据先落到文件再通知下游
+    avio_flush(fmtCtx_->pb);
+    avio_flush(sink_);
+
+    bool media = false;
+    for (const Span& sp : spans_) {
+        if (sp.size <= 0 || sp.kind == AVIO_DATA_MARKER_TRAILER) continue;
+        MuxerFragment f;
+        f.offset = sp.offset;
+        f.size = sp.size;
+        if (sp.kind != AVIO_DATA_MARKER_HEADER) {
+            media = true;
+            f.index = ++fragmentCount_;
+            f.startTime = fragStartUs_ != AV_NOPTS_VALUE ? fragStartUs_ / (double)AV_TIME_BASE : 0.0;
+            f.endTime = endUs != AV_NOPTS_VALUE ? endUs / (double)AV_TIME_BASE : f.startTime;
+        }
+        if (fragmentCb_) fragmentCb_(f);
+    }
+    spans_.clear();
+    if (media) fragStartUs_ = endUs;
+}
+
+void Muxer::run() {
+    while (!abort_) {
+        bool allEnded = true;
+        size_t pending = 0;
+        for (auto& s : streams_) {
+            pull(*s, 0);
+            if (!s->ended || !s->pending.empty()) allEnded = false;
+            pending += s->pending.size();
+        }
+        if (allEnded) break;
+        if (pending > maxPending_) maxPending_ = pending;
+
+        // dts 最小的队头；还没结束、却暂时没有包的流记为 missing
+        Stream* next = nullptr;
+        Stream* missing = nullptr;
+        int64_t nextTime = INT64_MAX, newest = INT64_MIN;
+        for (auto& s : streams_) {
+            if (s->pending.empty()) {
+                if (!s->ended) missing = s.get();
+                continue;
+            }
+            int64_t t = packetTime(*s, s->pending.front());
+            if (t < nextTime || !next) {
+                nextTime = t;
+                next = s.get();
+            }
+            int64_t last = packetTime(*s, s->pending.back());
+            if (last > newest) newest = last;
+        }
+
+        // 有一路没有包：其他路领先不到一个窗口时等它（阻塞在这一路的队列上），超过窗口就不再等
+        if (missing && (!next || (nextTime != INT64_MIN && newest - nextTime < windowUs_))) {
+            pull(*missing, 10);
+            continue;
+        }
+        writeHead(*next);
+    }
+}
+
+void Muxer::printStats() const {
+    std::cout << "[Muxer] " << filename_ << ": max buffered packets " << maxPending_;
+    if (fragmented_) std::cout << ", " << fragmentCount_ << " fragments";
+    std::cout << "\n";
+    for (const auto& s : streams_) {
+        const char* type = av_get_media_type_string(s->type);
+        std::cout << "  stream " << s->index << " (" << (type ? type : "unknown") << "): "
+                  << s->packets << " packets, " << s->bytes << " bytes\n";
+    }
+}
@@ -0,0 +1,270 @@
+#include "overlaycompositor.h"
+#include "pixelkernels.h"
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <algorithm>
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libavutil/pixdesc.h>
+#include <libavutil/imgutils.h>
+#include <libavutil/common.h>
+#include <libswscale/swscale.h>
+}
+
+// 进程级缓存：key = logo key + 像素格式 + 色彩范围
+static std::mutex gCacheMutex;
+static std::map<std::string, std::shared_ptr<const PreparedOverlay>> gCache;
+
+OverlayCompositor::~OverlayCompositor() {
+    close();
+}
+
+void OverlayCompositor::close() {
+    av_frame_free(&logo_);
+    cur_.reset();
+    curFmt_ = AV_PIX_FMT_NONE;
+    curRange_ = -1;
+    path_.clear();
+    key_.clear();
+}
+
+void OverlayCompositor::clearCache() {
+    std::lock_guard<std::mutex> lock(gCacheMutex);
+    gCache.clear();
+}
+
+bool OverlayCompositor::init(const std::string& logoPath, int x, int y) {
+    close();
+    // 图片等到第一次缓存未命中时才解码，缓存命中的任务完全不碰文件
+    path_ = logoPath;
+    key_ = "file:" + logoPath;
+    x_ = x;
+    y_ = y;
+    return true;
+}
+
+bool OverlayCompositor::init(const AVFrame* logo, const std::string& key, int x, int y) {
+    close();
+    if (!logo || logo->width <= 0 || logo->height <= 0) {
+        std::cerr << "OverlayCompositor: invalid logo frame\n";
+        return false;
+    }
+    logo_ = av_frame_clone(logo);
+    if (!logo_) return false;
+    key_ = "frame:" + key;
+    x_ = x;
+    y_ = y;
+    return true;
+}
+
+bool OverlayCompositor::loadLogo() {
+    if (logo_) return true;
+    if (path_.empty()) return false;
+
+    AVFormatContext* fmtCtx = nullptr;
+    if (avformat_open_input(&fmtCtx, path_.c_str(), nullptr, nullptr) < 0) {
+        std::cerr << "OverlayCompositor: cannot open " << path_ << "\n";
+        return false;
+    }
+
+    AVCodecContext* ctx = nullptr;
+    AVPacket* pkt = av_packet_alloc();
+    AVFrame* frame = av_frame_alloc();
+    bool ok = false;
+
+    int idx = av_find_best_stream(fmtCtx, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+    AVCodec* codec = idx >= 0 ? avcodec_find_decoder(fmtCtx->streams[idx]->codecpar->codec_id) : nullptr;
+    if (codec && pkt && frame && (ctx = avcodec_alloc_context3(codec)) &&
+        avcodec_parameters_to_context(ctx, fmtCtx->streams[idx]->codecpar) >= 0 &&
+        avcodec_open2(ctx, codec, nullptr) >= 0) {
+        // 只要第一帧
+        while (!ok && av_read_frame(fmtCtx, pkt) >= 0) {
+            if (pkt->stream_index == idx && avcodec_send_packet(ctx, pkt) >= 0)
+                ok = avcodec_receive_frame(ctx, frame) >= 0;
+            av_packet_unref(pkt);
+        }
+        if (!ok && avcodec_send_packet(ctx, nullptr) >= 0)
+            ok = avcodec_receive_frame(ctx, frame) >= 0;
+    }
+
+    if (ok) {
+        logo_ = frame;
+        frame = nullptr;
+    } else {
+        std::cerr << "OverlayCompositor: failed to decode " << path_ << "\n";
+    }
+    av_frame_free(&frame);
+    av_packet_free(&pkt);
+    avcodec_free_context(&ctx);
+    avformat_close_input(&fmtCtx);
+    return ok;
+}
+
+// 目标格式是否支持：8bit，无 alpha，亮度平面每像素一个字节，色度为平面或 UV 交错
+static bool overlaySupported(const AVPixFmtDescriptor* d) {
+    if (!d || (d->flags & (AV_PIX_FMT_FLAG_RGB | AV_PIX_FMT_FLAG_PAL | AV_PIX_FMT_FLAG_BITSTREAM |
+                           AV_PIX_FMT_FLAG_HWACCEL | AV_PIX_FMT_FLAG_ALPHA)))
+        return false;
+    if (d->nb_components != 3 || !(d->flags & AV_PIX_FMT_FLAG_PLANAR)) return false;
+    for (int c = 0; c < 3; ++c) {
+        if (d->comp[c].depth != 8 || d->comp[c].shift != 0) return false;
+    }
+    return d->comp[0].plane == 0 && d->comp[0].step == 1;
+}
+
+std::shared_ptr<PreparedOverlay> OverlayCompositor::build(AVPixelFormat fmt, bool fullRange) {
+    if (!loadLogo()) return nullptr;
+
+    const int w = logo_->width, h = logo_->height;
+    const AVPixFmtDescriptor* d = av_pix_fmt_desc_get(fmt);
+
+    // 先转成不下采样的 YUVA444P，色度下采样放到预乘之后自己做
+    AVFrame* yuva = av_frame_alloc();
+    if (!yuva) return nullptr;
+    yuva->format = AV_PIX_FMT_YUVA444P;
+    yuva->width = w;
+    yuva->height = h;
+    SwsContext* sws = sws_getContext(w, h, (AVPixelFormat)logo_->format, w, h, AV_PIX_FMT_YUVA444P,
+                                     SWS_BICUBIC, nullptr, nullptr, nullptr);
+    if (!sws || av_frame_get_buffer(yuva, 0) < 0) {
+        std::cerr << "OverlayCompositor: cannot convert logo\n";
+        sws_freeContext(sws);
+        av_frame_free(&yuva);
+        return nullptr;
+    }
+    if (fullRange) {
+        int* inv;
+        int* tbl;
+        int srcRange, dstRange, bri, con, sat;
+        if (sws_getColorspaceDetails(sws, &inv, &srcRange, &tbl, &dstRange, &bri, &con, &sat) >= 0)
+            sws_setColorspaceDetails(sws, inv, srcRange, tbl, 1, bri, con, sat);
+    }
+    sws_scale(sws, logo_->data, logo_->linesize, 0, h, yuva->data, yuva->linesize);
+    sws_freeContext(sws);
+
+    // 源图没有 alpha 时 swscale 把 alpha 平面填成 255，整块不透明覆盖
+    auto ov = std::make_shared<PreparedOverlay>();
+    ov->width = w;
+    ov->height = h;
+    ov->planes = av_pix_fmt_count_planes(fmt);
+    for (int p = 0; p < ov->planes; ++p) {
+        ov->planeBytes[p] = av_image_get_linesize(fmt, w, p);
+        ov->planeRows[p] = p ? AV_CEIL_RSHIFT(h, d->log2_chroma_h) : h;
+        ov->premul[p].assign((size_t)ov->planeBytes[p] * ov->planeRows[p], 0);
+        ov->invAlpha[p].assign((size_t)ov->planeBytes[p] * ov->planeRows[p], 255);
+    }
+
+    const uint8_t* A = yuva->data[3];
+    const ptrdiff_t as = yuva->linesize[3];
+    for (int c = 0; c < 3; ++c) {
+        const AVComponentDescriptor& comp = d->comp[c];
+        const int sw = c ? d->log2_chroma_w : 0, sh = c ? d->log2_chroma_h : 0;
+        const int cw = AV_CEIL_RSHIFT(w, sw), ch = AV_CEIL_RSHIFT(h, sh);
+        const uint8_t* C = yuva->data[c];
+        const ptrdiff_t cs = yuva->linesize[c];
+        const int bytes = ov->planeBytes[comp.plane];
+
+        for (int y = 0; y < ch; ++y) {
+            for (int x = 0; x < cw; ++x) {
+                // 覆盖的亮度像素在预乘域内求平均，透明像素的颜色不参与
+                int sumCA = 0, sumA = 0, n = 0;
+                for (int yy = y << sh; yy < std::min(h, (y + 1) << sh); ++yy) {
+                    for (int xx = x << sw; xx < std::min(w, (x + 1) << sw); ++xx) {
+                        int a = A[yy * as + xx];
+                        sumCA += C[yy * cs + xx] * a;
+                        sumA += a;
+                        ++n;
+                    }
+                }
+                size_t pos = (size_t)y * bytes + (size_t)x * comp.step + comp.offset;
+                ov->premul[comp.plane][pos] = (uint8_t)((sumCA + 255 * n / 2) / (255 * n));
+                ov->invAlpha[comp.plane][pos] = (uint8_t)(255 - (sumA + n / 2) / n);
+            }
+        }
+    }
+
+    av_frame_free(&yuva);
+    return ov;
+}
+
+std::shared_ptr<const PreparedOverlay> OverlayCompositor::prepared(AVPixelFormat fmt, int colorRange) {
+    if (cur_ && fmt == curFmt_ && colorRange == curRange_) return cur_;
+
+    const AVPixFmtDescriptor* d = av_pix_fmt_desc_get(fmt);
+    if (!overlaySupported(d)) {
+        if (fmt != curFmt_) std::cerr << "OverlayCompositor: unsupported pixel format " << fmt << "\n";
+        curFmt_ = fmt;
+        curRange_ = colorRange;
+        cur_.reset();
+        return nullptr;
+    }
+
+    // yuvj 系列和标记为全范围的帧按全范围准备
+    bool fullRange = colorRange == AVCOL_RANGE_JPEG || fmt == AV_PIX_FMT_YUVJ420P ||
+                     fmt == AV_PIX_FMT_YUVJ422P || fmt == AV_PIX_FMT_YUVJ444P;
+    std::string key = key_ + ":" + std::to_string(fmt) + (fullRange ? ":full" : ":tv");
+
+    std::shared_ptr<const PreparedOverlay> ov;
+    {
+        std::lock_guard<std::mutex> lock(gCacheMutex);
+        auto it = gCache.find(key);
+        if (it != gCache.end()) ov = it->second;
+    }
+    if (!ov) {
+        // 转换在锁外做；两个任务同时未命中时各自准备一次，结果相同，后放入的覆盖前者
+        std::shared_ptr<const PreparedOverlay> built = build(fmt, fullRange);
+        if (built) {
+            std::lock_guard<std::mutex> lock(gCacheMutex);
+            gCache[key] = built;
+        }
+        ov = built;
+    }
+
+    curFmt_ = fmt;
+    curRange_ = colorRange;
+    cur_ = ov;
+    return ov;
+}
+
+bool OverlayCompositor::apply(AVFrame* frame) {
+    if (!frame || key_.empty()) return false;
+
+    std::shared_ptr<const PreparedOverlay> ov = prepared((AVPixelFormat)frame->format, frame->color_range);
+    if (!ov) return false;
+
+    const AVPixFmtDescriptor* d = av_pix_fmt_desc_get((AVPixelFormat)frame->format);
+    const int alignX = 1 << d->log2_chroma_w, alignY = 1 << d->log2_chroma_h;
+
+    // 左上角位置，对齐到色度采样边界后再和画面求交
+    int left = x_ >= 0 ? x_ : frame->width - ov->width + x_;
+    int top = y_ >= 0 ? y_ : frame->height - ov->height + y_;
+    left &= ~(alignX - 1);
+    top &= ~(alignY - 1);
+
+    const int ox = std::max(0, -left), oy = std::max(0, -top);
+    const int fx = std::max(0, left), fy = std::max(0, top);
+    const int w = std::min(ov->width - ox, frame->width - fx);
+    const int h = std::min(ov->height - oy, frame->height - fy);
+    if (w <= 0 || h <= 0) return true;   // 完全在画面外
+
+    if (av_frame_make_writable(frame) < 0) {
+        std::cerr << "OverlayCompositor: frame not writable\n";
+        return false;
+    }
+
+    for (int p = 0; p < ov->planes; ++p) {
+        const int sw = p ? d->log2_chroma_w : 0, sh = p ? d->log2_chroma_h : 0;
+        // 每个平面按字节计的宽度比例（nv12 的 UV 平面每个色度点 2 字节）
+        const int bpp = ov->planeBytes[p] / AV_CEIL_RSHIFT(ov->width, sw);
+        const int px = (ox >> sw) * bpp, py = oy >> sh;
+        const int bw = AV_CEIL_RSHIFT(w, sw) * bpp, bh = AV_CEIL_RSHIFT(h, sh);
+        const size_t off = (size_t)py * ov->planeBytes[p] + px;
+
+        blendPremultiplied(frame->data[p] + (ptrdiff_t)(fy >> sh) * frame->linesize[p] + (fx >> sw) * bpp,
+                           frame->linesize[p], ov->premul[p].data() + off, ov->planeBytes[p],
+                           ov->invAlpha[p].data() + off, ov->planeBytes[p], bw, bh);
+    }
+    return true;
+}
@@ -0,0 +1,214 @@
+#include "pixelconverter.h"
+#include "threadpool.h"
+#include "pixelkernels.h"
+#include <iostream>
+#include <atomic>
+#include <algorithm>
+extern "C" {
+#include <libavutil/pixdesc.h>
+#include <libavutil/imgutils.h>
+#include <libavutil/common.h>
+}
+
+PixelConverter::~PixelConverter() {
+    close();
+}
+
+void PixelConverter::close() {
+    for (auto& kv : cache_) {
+        for (SwsContext* c : kv.second.slices) sws_freeContext(c);
+    }
+    cache_.clear();
+
+    // 已经发出去的帧持有池中的 buffer，uninit 后等它们全部释放时池才真正销毁
+    for (auto& kv : pools_) av_buffer_pool_uninit(&kv.second);
+    pools_.clear();
+}
+
+bool PixelConverter::init(int dstWidth, int dstHeight, AVPixelFormat dstFmt, int flags, int threads) {
+    close();
+    if (dstFmt == AV_PIX_FMT_NONE || !av_pix_fmt_desc_get(dstFmt)) {
+        std::cerr << "PixelConverter: invalid destination format\n";
+        return false;
+    }
+    dstWidth_ = dstWidth;
+    dstHeight_ = dstHeight;
+    dstFmt_ = dstFmt;
+    flags_ = flags;
+    threads_ = threads > 0 ? threads : 1;
+    return true;
+}
+
+// 平面 1、2 是色度（调色板格式的平面 1 是调色板，不按行偏移）
+static int planeRowShift(const AVPixFmtDescriptor* desc, int plane) {
+    return (plane == 1 || plane == 2) ? desc->log2_chroma_h : 0;
+}
+
+bool PixelConverter::buildEntry(const AVFrame* src, int dstW, int dstH, Entry& e) {
+    AVPixelFormat srcFmt = (AVPixelFormat)src->format;
+    const AVPixFmtDescriptor* sd = av_pix_fmt_desc_get(srcFmt);
+    const AVPixFmtDescriptor* dd = av_pix_fmt_desc_get(dstFmt_);
+    if (!sd || !dd) return false;
+
+    // 没有垂直缩放、色度垂直采样相同，每行输出只依赖同一行输入，横带之间互不影响
+    bool sliceable = threads_ > 1 && src->height == dstH &&
+                     sd->log2_chroma_h == dd->log2_chroma_h &&
+                     !(sd->flags & AV_PIX_FMT_FLAG_PAL) && !(dd->flags & AV_PIX_FMT_FLAG_PAL);
+
+    // 横带起点按 8 行对齐：色度行不跨带，swscale 的有序抖动图案也保持连续
+    int align = std::max(8, 1 << sd->log2_chroma_h);
+    int bandH = FFALIGN((src->height + threads_ - 1) / threads_, align);
+    if (!sliceable || bandH >= src->height) bandH = src->height;
+
+    for (int y = 0; y < src->height; y += bandH) {
+        int h = std::min(bandH, src->height - y);
+        int oh = bandH == src->height ? dstH : h;
+        SwsContext* c = sws_getContext(src->width, h, srcFmt, dstW, oh, dstFmt_,
+                                       flags_, nullptr, nullptr, nullptr);
+        if (!c) {
+            std::cerr << "PixelConverter: sws_getContext failed for "
+                      << av_get_pix_fmt_name(srcFmt) << " -> " << av_get_pix_fmt_name(dstFmt_) << "\n";
+            return false;
+        }
+        e.slices.push_back(c);
+        e.sliceY.push_back(y);
+    }
+    return true;
+}
+
+PixelConverter::Entry* PixelConverter::getEntry(const AVFrame* src, int dstW, int dstH) {
+    std::string key = std::to_string(src->width) + "x" + std::to_string(src->height) + ":" +
+                      std::to_string(src->format) + ">" + std::to_string(dstW) + "x" +
+                      std::to_string(dstH) + ":" + std::to_string(dstFmt_) + ":" +
+                      std::to_string(flags_);
+
+    auto it = cache_.find(key);
+    if (it != cache_.end()) return &it->second;
+
+    Entry e;
+    if (!buildEntry(src, dstW, dstH, e)) {
+        for (SwsContext* c : e.slices) sws_freeContext(c);
+        return nullptr;
+    }
+    return &cache_.emplace(key, e).first->second;
+}
+
+AVFrame* PixelConverter::allocDst(int width, int height) {
+    // linesize 按 32 字节对齐，方便 swscale 的 SIMD 路径
+    int linesizes[4];
+    if (av_image_fill_linesizes(linesizes, dstFmt_, width) < 0) return nullptr;
+    ptrdiff_t aligned[4];
+    for (int i = 0; i < 4; ++i) {
+        linesizes[i] = FFALIGN(linesizes[i], 32);
+        aligned[i] = linesizes[i];
+    }
+
+    size_t sizes[4];
+    if (av_image_fill_plane_sizes(sizes, dstFmt_, height, aligned) < 0) return nullptr;
+    size_t total = sizes[0] + sizes[1] + sizes[2] + sizes[3];
+
+    std::string key = std::to_string(width) + "x" + std::to_string(height) + ":" + std::to_string(dstFmt_);
+    AVBufferPool*& pool = pools_[key];
+    if (!pool) {
+        // 尾部多留 64 字节，容忍 SIMD 越界读写
+        pool = av_buffer_pool_init(total + 64, nullptr);
+        if (!pool) return nullptr;
+    }
+
+    AVFrame* out = av_frame_alloc();
+    if (!out) return nullptr;
+    out->buf[0] = av_buffer_pool_get(pool);
+    if (!out->buf[0]) {
+        av_frame_free(&out);
+        return nullptr;
+    }
+
+    uint8_t* p = out->buf[0]->data;
+    for (int i = 0; i < 4; ++i) {
+        out->data[i] = sizes[i] ? p : nullptr;
+        out->linesize[i] = sizes[i] ? linesizes[i] : 0;
+        p += sizes[i];
+    }
+    out->extended_data = out->data;
+    out->format = dstFmt_;
+    out->width = width;
+    out->height = height;
+    return out;
+}
+
+bool PixelConverter::convertFast(const AVFrame* src, AVFrame* out) {
+    if (src->width != out->width || src->height != out->height) return false;
+
+    int w = src->width, h = src->height;
+    int cw = AV_CEIL_RSHIFT(w, 1), ch = AV_CEIL_RSHIFT(h, 1);
+    AVPixelFormat sf = (AVPixelFormat)src->format;
+
+    if (sf == AV_PIX_FMT_NV12 && dstFmt_ == AV_PIX_FMT_YUV420P) {
+        copyPlane(src->data[0], src->linesize[0], out->data[0], out->linesize[0], w, h);
+        deinterleaveUV(src->data[1], src->linesize[1], out->data[1], out->linesize[1],
+                       out->data[2], out->linesize[2], cw, ch);
+        return true;
+    }
+    if (sf == AV_PIX_FMT_YUV420P && dstFmt_ == AV_PIX_FMT_NV12) {
+        copyPlane(src->data[0], src->linesize[0], out->data[0], out->linesize[0], w, h);
+        interleaveUV(src->data[1], src->linesize[1], src->data[2], src->linesize[2],
+                     out->data[1], out->linesize[1], cw, ch);
+        return true;
+    }
+    if (sf == AV_PIX_FMT_YUV420P10LE && dstFmt_ == AV_PIX_FMT_YUV420P) {
+        for (int p = 0; p < 3; ++p) {
+            dither10to8((const uint16_t*)src->data[p], src->linesize[p], out->data[p], out->linesize[p],
+                        p ? cw : w, p ? ch : h);
+        }
+        return true;
+    }
+    return false;
+}
+
+AVFrame* PixelConverter::convert(const AVFrame* src) {
+    if (!src || dstFmt_ == AV_PIX_FMT_NONE) return nullptr;
+
+    int dstW = dstWidth_ > 0 ? dstWidth_ : src->width;
+    int dstH = dstHeight_ > 0 ? dstHeight_ : src->height;
+
+    if (src->format == dstFmt_ && src->width == dstW && src->height == dstH)
+        return av_frame_clone(src);
+
+    AVFrame* out = allocDst(dstW, dstH);
+    if (!out) return nullptr;
+    av_frame_copy_props(out, src);
+
+    if (convertFast(src, out)) return out;
+
+    Entry* e = getEntry(src, dstW, dstH);
+    if (!e) {
+        av_frame_free(&out);
+        return nullptr;
+    }
+
+    const AVPixFmtDescriptor* sd = av_pix_fmt_desc_get((AVPixelFormat)src->format);
+    const AVPixFmtDescriptor* dd = av_pix_fmt_desc_get(dstFmt_);
+    std::atomic<bool> ok(true);
+
+    auto runSlice = [&](int i) {
+        int y = e->sliceY[i];
+        const uint8_t* s[4];
+        uint8_t* d[4];
+        for (int p = 0; p < 4; ++p) {
+            s[p] = src->data[p] ? src->data[p] + (ptrdiff_t)(y >> planeRowShift(sd, p)) * src->linesize[p] : nullptr;
+            d[p] = out->data[p] ? out->data[p] + (ptrdiff_t)(y >> planeRowShift(dd, p)) * out->linesize[p] : nullptr;
+        }
+        int h = (i + 1 < (int)e->sliceY.size() ? e->sliceY[i + 1] : src->height) - y;
+        if (sws_scale(e->slices[i], s, src->linesize, 0, h, d, out->linesize) <= 0) ok = false;
+    };
+
+    if (e->slices.size() > 1) ThreadPool::shared().parallelFor((int)e->slices.size(), runSlice);
+    else runSlice(0);
+
+    if (!ok) {
+        std::cerr << "PixelConverter: sws_scale failed\n";
+        av_frame_free(&out);
+        return nullptr;
+    }
+    return out;
+}
@@ -0,0 +1,509 @@
+#include "pixelkernels.h"
+#include <cstring>
+extern "C" {
+#include <libavutil/cpu.h>
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PIXEL_X86 1
+#endif
+
+// 8x8 Bayer 矩阵右移 4 位（0..3），作为 10bit 右移 2 位前的抖动量；
+// 只舍去 2 bit 时高位部分正好退化成 2x2 图案
+static const uint16_t kDither8x8[8][8] = {
+    {0, 2, 0, 2, 0, 2, 0, 2},
+    {3, 1, 3, 1, 3, 1, 3, 1},
+    {0, 2, 0, 2, 0, 2, 0, 2},
+    {3, 1, 3, 1, 3, 1, 3, 1},
+    {0, 2, 0, 2, 0, 2, 0, 2},
+    {3, 1, 3, 1, 3, 1, 3, 1},
+    {0, 2, 0, 2, 0, 2, 0, 2},
+    {3, 1, 3, 1, 3, 1, 3, 1},
+};
+
+// ---------------- 标量实现 ----------------
+
+static void interleaveRowC(const uint8_t* u, const uint8_t* v, uint8_t* uv, int w) {
+    for (int x = 0; x < w; ++x) {
+        uv[2 * x] = u[x];
+        uv[2 * x + 1] = v[x];
+    }
+}
+
+static void deinterleaveRowC(const uint8_t* uv, uint8_t* u, uint8_t* v, int w) {
+    for (int x = 0; x < w; ++x) {
+        u[x] = uv[2 * x];
+        v[x] = uv[2 * x + 1];
+    }
+}
+
+static void ditherRowC(const uint16_t* src, uint8_t* dst, int w, const uint16_t* d) {
+    for (int x = 0; x < w; ++x) {
+        int v = (src[x] + d[x & 7]) >> 2;
+        dst[x] = (uint8_t)(v > 255 ? 255 : v);
+    }
+}
+
+template<typename T>
+static void hflipRowT(const uint8_t* src, uint8_t* dst, int w) {
+    const T* s = (const T*)src;
+    T* d = (T*)dst;
+    for (int x = 0; x < w; ++x) d[x] = s[w - 1 - x];
+}
+
+static void hflipRowC(const uint8_t* src, uint8_t* dst, int w, int e) {
+    if (e == 1) hflipRowT<uint8_t>(src, dst, w);
+    else if (e == 2) hflipRowT<uint16_t>(src, dst, w);
+    else hflipRowT<uint32_t>(src, dst, w);
+}
+
+static void boxRowC(const uint8_t* s0, const uint8_t* s1, uint8_t* dst, int w) {
+    for (int x = 0; x < w; ++x)
+        dst[x] = (uint8_t)((s0[2 * x] + s0[2 * x + 1] + s1[2 * x] + s1[2 * x + 1] + 2) >> 2);
+}
+
+// v / 255 四舍五入，v 在 0..255*255 之间时与 (v + 127) / 255 的结果一致
+static inline int div255(int v) {
+    v += 128;
+    return (v + (v >> 8)) >> 8;
+}
+
+static void blendRowC(uint8_t* dst, const uint8_t* pre, const uint8_t* ia, int w) {
+    for (int x = 0; x < w; ++x) {
+        int v = pre[x] + div255(dst[x] * ia[x]);
+        dst[x] = (uint8_t)(v > 255 ? 255 : v);
+    }
+}
+
+// ---------------- x86 SIMD 内核 ----------------
+// 每个向量版本只处理整块，剩余的尾部交给标量
+
+#ifdef PIXEL_X86
+
+// 按元素倒序 16 字节的 pshufb 掩码
+static void reverseMask(int e, uint8_t mask[16]) {
+    for (int i = 0; i < 16; ++i) mask[i] = (uint8_t)((16 / e - 1 - i / e) * e + i % e);
+}
+
+// SSE4.1
+
+__attribute__((target("sse4.1")))
+static void interleaveRowSse41(const uint8_t* u, const uint8_t* v, uint8_t* uv, int w) {
+    int x = 0;
+    for (; x + 16 <= w; x += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(u + x));
+        __m128i b = _mm_loadu_si128((const __m128i*)(v + x));
+        _mm_storeu_si128((__m128i*)(uv + 2 * x), _mm_unpacklo_epi8(a, b));
+        _mm_storeu_si128((__m128i*)(uv + 2 * x + 16), _mm_unpackhi_epi8(a, b));
+    }
+    interleaveRowC(u + x, v + x, uv + 2 * x, w - x);
+}
+
+__attribute__((target("sse4.1")))
+static void deinterleaveRowSse41(const uint8_t* uv, uint8_t* u, uint8_t* v, int w) {
+    const __m128i split = _mm_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15);
+    int x = 0;
+    for (; x + 16 <= w; x += 16) {
+        __m128i a = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(uv + 2 * x)), split);
+        __m128i b = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(uv + 2 * x + 16)), split);
+        _mm_storeu_si128((__m128i*)(u + x), _mm_unpacklo_epi64(a, b));
+        _mm_storeu_si128((__m128i*)(v + x), _mm_unpackhi_epi64(a, b));
+    }
+    deinterleaveRowC(uv + 2 * x, u + x, v + x, w - x);
+}
+
+__attribute__((target("sse4.1")))
+static void ditherRowSse41(const uint16_t* src, uint8_t* dst, int w, const uint16_t* d) {
+    const __m128i dv = _mm_loadu_si128((const __m128i*)d);
+    int x = 0;
+    for (; x + 16 <= w; x += 16) {
+        __m128i a = _mm_srli_epi16(_mm_add_epi16(_mm_loadu_si128((const __m128i*)(src + x)), dv), 2);
+        __m128i b = _mm_srli_epi16(_mm_add_epi16(_mm_loadu_si128((const __m128i*)(src + x + 8)), dv), 2);
+        _mm_storeu_si128((__m128i*)(dst + x), _mm_packus_epi16(a, b));
+    }
+    ditherRowC(src + x, dst + x, w - x, d);
+}
+
+__attribute__((target("sse4.1")))
+static void hflipRowSse41(const uint8_t* src, uint8_t* dst, int w, int e) {
+    uint8_t m[16];
+    reverseMask(e, m);
+    const __m128i mask = _mm_loadu_si128((const __m128i*)m);
+    const int n = 16 / e;
+    int x = 0;
+    for (; x + n <= w; x += n) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + (ptrdiff_t)(w - n - x) * e));
+        _mm_storeu_si128((__m128i*)(dst + (ptrdiff_t)x * e), _mm_shuffle_epi8(v, mask));
+    }
+    // 剩余的 w - x 个元素来自源的开头
+    hflipRowC(src, dst + (ptrdiff_t)x * e, w - x, e);
+}
+
+__attribute__((target("sse4.1")))
+static void boxRowSse41(const uint8_t* s0, const uint8_t* s1, uint8_t* dst, int w) {
+    const __m128i ones = _mm_set1_epi8(1);
+    const __m128i two = _mm_set1_epi16(2);
+    int x = 0;
+    for (; x + 16 <= w; x += 16) {
+        __m128i lo = _mm_add_epi16(_mm_maddubs_epi16(_mm_loadu_si128((const __m128i*)(s0 + 2 * x)), ones),
+                                   _mm_maddubs_epi16(_mm_loadu_si128((const __m128i*)(s1 + 2 * x)), ones));
+        __m128i hi = _mm_add_epi16(_mm_maddubs_epi16(_mm_loadu_si128((const __m128i*)(s0 + 2 * x + 16)), ones),
+                                   _mm_maddubs_epi16(_mm_loadu_si128((const __m128i*)(s1 + 2 * x + 16)), ones));
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, two), 2);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, two), 2);
+        _mm_storeu_si128((__m128i*)(dst + x), _mm_packus_epi16(lo, hi));
+    }
+    boxRowC(s0 + 2 * x, s1 + 2 * x, dst + x, w - x);
+}
+
+// 16 位乘法 + div255，和 premul 饱和相加；unpack 与 pack 成对使用，顺序不变
+__attribute__((target("sse4.1")))
+static void blendRowSse41(uint8_t* dst, const uint8_t* pre, const uint8_t* ia, int w) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i r128 = _mm_set1_epi16(128);
+    int x = 0;
+    for (; x + 16 <= w; x += 16) {
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + x));
+        __m128i a = _mm_loadu_si128((const __m128i*)(ia + x));
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), _mm_unpacklo_epi8(a, zero)), r128);
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), _mm_unpackhi_epi8(a, zero)), r128);
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+        __m128i v = _mm_adds_epu8(_mm_packus_epi16(lo, hi), _mm_loadu_si128((const __m128i*)(pre + x)));
+        _mm_storeu_si128((__m128i*)(dst + x), v);
+    }
+    blendRowC(dst + x, pre + x, ia + x, w - x);
+}
+
+// AVX2：unpack / pack 都在 128 位 lane 内进行，结果需要跨 lane 重排
+
+__attribute__((target("avx2")))
+static void interleaveRowAvx2(const uint8_t* u, const uint8_t* v, uint8_t* uv, int w) {
+    int x = 0;
+    for (; x + 32 <= w; x += 32) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(u + x));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(v + x));
+        __m256i lo = _mm256_unpacklo_epi8(a, b);
+        __m256i hi = _mm256_unpackhi_epi8(a, b);
+        _mm256_storeu_si256((__m256i*)(uv + 2 * x), _mm256_permute2x128_si256(lo, hi, 0x20));
+        _mm256_storeu_si256((__m256i*)(uv + 2 * x + 32), _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+    interleaveRowC(u + x, v + x, uv + 2 * x, w - x);
+}
+
+__attribute__((target("avx2")))
+static void deinterleaveRowAvx2(const uint8_t* uv, uint8_t* u, uint8_t* v, int w) {
+    const __m256i split = _mm256_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15,
+                                           0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15);
+    int x = 0;
+    for (; x + 32 <= w; x += 32) {
+        __m256i a = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(uv + 2 * x)), split);
+        __m256i b = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(uv + 2 * x + 32)), split);
+        _mm256_storeu_si256((__m256i*)(u + x), _mm256_permute4x64_epi64(_mm256_unpacklo_epi64(a, b), 0xD8));
+        _mm256_storeu_si256((__m256i*)(v + x), _mm256_permute4x64_epi64(_mm256_unpackhi_epi64(a, b), 0xD8));
+    }
+    deinterleaveRowC(uv + 2 * x, u + x, v + x, w - x);
+}
+
+__attribute__((target("avx2")))
+static void ditherRowAvx2(const uint16_t* src, uint8_t* dst, int w, const uint16_t* d) {
+    const __m256i dv = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)d));
+    int x = 0;
+    for (; x + 32 <= w; x += 32) {
+        __m256i a = _mm256_srli_epi16(_mm256_add_epi16(_mm256_loadu_si256((const __m256i*)(src + x)), dv), 2);
+        __m256i b = _mm256_srli_epi16(_mm256_add_epi16(_mm256_loadu_si256((const __m256i*)(src + x + 16)), dv), 2);
+        _mm256_storeu_si256((__m256i*)(dst + x), _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8));
+    }
+    ditherRowC(src + x, dst + x, w - x, d);
+}
+
+__attribute__((target("avx2")))
+static void hflipRowAvx2(const uint8_t* src, uint8_t* dst, int w, int e) {
+    uint8_t m[16];
+    reverseMask(e, m);
+    const __m256i mask = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)m));
+    const int n = 32 / e;
+    int x = 0;
+    for (; x + n <= w; x += n) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(src + (ptrdiff_t)(w - n - x) * e));
+        v = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(v, mask), 0x4E);
+        _mm256_storeu_si256((__m256i*)(dst + (ptrdiff_t)x * e), v);
+    }
+    hflipRowC(src, dst + (ptrdiff_t)x * e, w - x, e);
+}
+
+__attribute__((target("avx2")))
+static void boxRowAvx2(const uint8_t* s0, const uint8_t* s1, uint8_t* dst, int w) {
+    const __m256i ones = _mm256_set1_epi8(1);
+    const __m256i two = _mm256_set1_epi16(2);
+    int x = 0;
+    for (; x + 32 <= w; x += 32) {
+        __m256i lo = _mm256_add_epi16(_mm256_maddubs_epi16(_mm256_loadu_si256((const __m256i*)(s0 + 2 * x)), ones),
+                                      _mm256_maddubs_epi16(_mm256_loadu_si256((const __m256i*)(s1 + 2 * x)), ones));
+        __m256i hi = _mm256_add_epi16(_mm256_maddubs_epi16(_mm256_loadu_si256((const __m256i*)(s0 + 2 * x + 32)), ones),
+                                      _mm256_maddubs_epi16(_mm256_loadu_si256((const __m256i*)(s1 + 2 * x + 32)), ones));
+        lo = _mm256_srli_epi16(_mm256_add_epi16(lo, two), 2);
+        hi = _mm256_srli_epi16(_mm256_add_epi16(hi, two), 2);
+        _mm256_storeu_si256((__m256i*)(dst + x), _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), 0xD8));
+    }
+    boxRowC(s0 + 2 * x, s1 + 2 * x, dst + x, w - x);
+}
+
+__attribute__((target("avx2")))
+static void blendRowAvx2(uint8_t* dst, const uint8_t* pre, const uint8_t* ia, int w) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i r128 = _mm256_set1_epi16(128);
+    int x = 0;
+    for (; x + 32 <= w; x += 32) {
+        __m256i d = _mm256_loadu_si256((const __m256i*)(dst + x));
+        __m256i a = _mm256_loadu_si256((const __m256i*)(ia + x));
+        __m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero), _mm256_unpacklo_epi8(a, zero)), r128);
+        __m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero), _mm256_unpackhi_epi8(a, zero)), r128);
+        lo = _mm256_srli_epi16(_mm256_add_epi16(lo, _mm256_srli_epi16(lo, 8)), 8);
+        hi = _mm256_srli_epi16(_mm256_add_epi16(hi, _mm256_srli_epi16(hi, 8)), 8);
+        __m256i v = _mm256_adds_epu8(_mm256_packus_epi16(lo, hi), _mm256_loadu_si256((const __m256i*)(pre + x)));
+        _mm256_storeu_si256((__m256i*)(dst + x), v);
+    }
+    blendRowC(dst + x, pre + x, ia + x, w - x);
+}
+
+// AVX-512（F + BW）：同样是 lane 内运算，最后用 64 位置换恢复顺序
+
+__attribute__((target("avx512f,avx512bw")))
+static void interleaveRowAvx512(const uint8_t* u, const uint8_t* v, uint8_t* uv, int w) {
+    const __m512i idxLo = _mm512_setr_epi64(0, 1, 8, 9, 2, 3, 10, 11);
+    const __m512i idxHi = _mm512_setr_epi64(4, 5, 12, 13, 6, 7, 14, 15);
+    int x = 0;
+    for (; x + 64 <= w; x += 64) {
+        __m512i a = _mm512_loadu_si512((const void*)(u + x));
+        __m512i b = _mm512_loadu_si512((const void*)(v + x));
+        __m512i lo = _mm512_unpacklo_epi8(a, b);
+        __m512i hi = _mm512_unpackhi_epi8(a, b);
+        _mm512_storeu_si512((void*)(uv + 2 * x), _mm512_permutex2var_epi64(lo, idxLo, hi));
+        _mm512_storeu_si512((void*)(uv + 2 * x + 64), _mm512_permutex2var_epi64(lo, idxHi, hi));
+    }
+    interleaveRowC(u + x, v + x, uv + 2 * x, w - x);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void deinterleaveRowAvx512(const uint8_t* uv, uint8_t* u, uint8_t* v, int w) {
+    const __m512i split = _mm512_broadcast_i32x4(
+        _mm_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15));
+    const __m512i order = _mm512_setr_epi64(0, 2, 4, 6, 1, 3, 5, 7);
+    int x = 0;
+    for (; x + 64 <= w; x += 64) {
+        __m512i a = _mm512_shuffle_epi8(_mm512_loadu_si512((const void*)(uv + 2 * x)), split);
+        __m512i b = _mm512_shuffle_epi8(_mm512_loadu_si512((const void*)(uv + 2 * x + 64)), split);
+        _mm512_storeu_si512((void*)(u + x), _mm512_permutexvar_epi64(order, _mm512_unpacklo_epi64(a, b)));
+        _mm512_storeu_si512((void*)(v + x), _mm512_permutexvar_epi64(order, _mm512_unpackhi_epi64(a, b)));
+    }
+    deinterleaveRowC(uv + 2 * x, u + x, v + x, w - x);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void ditherRowAvx512(const uint16_t* src, uint8_t* dst, int w, const uint16_t* d) {
+    const __m512i dv = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i*)d));
+    const __m512i order = _mm512_setr_epi64(0, 2, 4, 6, 1, 3, 5, 7);
+    int x = 0;
+    for (; x + 64 <= w; x += 64) {
+        __m512i a = _mm512_srli_epi16(_mm512_add_epi16(_mm512_loadu_si512((const void*)(src + x)), dv), 2);
+        __m512i b = _mm512_srli_epi16(_mm512_add_epi16(_mm512_loadu_si512((const void*)(src + x + 32)), dv), 2);
+        _mm512_storeu_si512((void*)(dst + x), _mm512_permutexvar_epi64(order, _mm512_packus_epi16(a, b)));
+    }
+    ditherRowC(src + x, dst + x, w - x, d);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void hflipRowAvx512(const uint8_t* src, uint8_t* dst, int w, int e) {
+    uint8_t m[16];
+    reverseMask(e, m);
+    const __m512i mask = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i*)m));
+    const int n = 64 / e;
+    int x = 0;
+    for (; x + n <= w; x += n) {
+        __m512i v = _mm512_loadu_si512((const void*)(src + (ptrdiff_t)(w - n - x) * e));
+        v = _mm512_shuffle_epi8(v, mask);
+        v = _mm512_shuffle_i64x2(v, v, 0x1B);
+        _mm512_storeu_si512((void*)(dst + (ptrdiff_t)x * e), v);
+    }
+    hflipRowC(src, dst + (ptrdiff_t)x * e, w - x, e);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void boxRowAvx512(const uint8_t* s0, const uint8_t* s1, uint8_t* dst, int w) {
+    const __m512i ones = _mm512_set1_epi8(1);
+    const __m512i two = _mm512_set1_epi16(2);
+    const __m512i order = _mm512_setr_epi64(0, 2, 4, 6, 1, 3, 5, 7);
+    int x = 0;
+    for (; x + 64 <= w; x += 64) {
+        __m512i lo = _mm512_add_epi16(_mm512_maddubs_epi16(_mm512_loadu_si512((const void*)(s0 + 2 * x)), ones),
+                                      _mm512_maddubs_epi16(_mm512_loadu_si512((const void*)(s1 + 2 * x)), ones));
+        __m512i hi = _mm512_add_epi16(_mm512_maddubs_epi16(_mm512_loadu_si512((const void*)(s0 + 2 * x + 64)), ones),
+                                      _mm512_maddubs_epi16(_mm512_loadu_si512((const void*)(s1 + 2 * x + 64)), ones));
+        lo = _mm512_srli_epi16(_mm512_add_epi16(lo, two), 2);
+        hi = _mm512_srli_epi16(_mm512_add_epi16(hi, two), 2);
+        _mm512_storeu_si512((void*)(dst + x), _mm512_permutexvar_epi64(order, _mm512_packus_epi16(lo, hi)));
+    }
+    boxRowC(s0 + 2 * x, s1 + 2 * x, dst + x, w - x);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void blendRowAvx512(uint8_t* dst, const uint8_t* pre, const uint8_t* ia, int w) {
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i r128 = _mm512_set1_epi16(128);
+    int x = 0;
+    for (; x + 64 <= w; x += 64) {
+        __m512i d = _mm512_loadu_si512((const void*)(dst + x));
+        __m512i a = _mm512_loadu_si512((const void*)(ia + x));
+        __m512i lo = _mm512_add_epi16(_mm512_mullo_epi16(_mm512_unpacklo_epi8(d, zero), _mm512_unpacklo_epi8(a, zero)), r128);
+        __m512i hi = _mm512_add_epi16(_mm512_mullo_epi16(_mm512_unpackhi_epi8(d, zero), _mm512_unpackhi_epi8(a, zero)), r128);
+        lo = _mm512_srli_epi16(_mm512_add_epi16(lo, _mm512_srli_epi16(lo, 8)), 8);
+        hi = _mm512_srli_epi16(_mm512_add_epi16(hi, _mm512_srli_epi16(hi, 8)), 8);
+        __m512i v = _mm512_adds_epu8(_mm512_packus_epi16(lo, hi), _mm512_loadu_si512((const void*)(pre + x)));
+        _mm512_storeu_si512((void*)(dst + x), v);
+    }
+    blendRowC(dst + x, pre + x, ia + x, w - x);
+}
+
+#endif // PIXEL_X86
+
+// ---------------- 运行时选择 ----------------
+
+typedef void (*InterleaveRowFn)(const uint8_t*, const uint8_t*, uint8_t*, int);
+typedef void (*DeinterleaveRowFn)(const uint8_t*, uint8_t*, uint8_t*, int);
+typedef void (*DitherRowFn)(const uint16_t*, uint8_t*, int, const uint16_t*);
+typedef void (*HflipRowFn)(const uint8_t*, uint8_t*, int, int);
+typedef void (*BoxRowFn)(const uint8_t*, const uint8_t*, uint8_t*, int);
+typedef void (*BlendRowFn)(uint8_t*, const uint8_t*, const uint8_t*, int);
+
+struct PixelKernels {
+    const char* isa = "c";
+    InterleaveRowFn interleave = interleaveRowC;
+    DeinterleaveRowFn deinterleave = deinterleaveRowC;
+    DitherRowFn dither = ditherRowC;
+    HflipRowFn hflip = hflipRowC;
+    BoxRowFn box = boxRowC;
+    BlendRowFn blend = blendRowC;
+};
+
+// flags 中的每一级依次覆盖上一级，取支持的最高一级
+static PixelKernels selectKernels(int flags) {
+    PixelKernels r;
+#ifdef PIXEL_X86
+    if (flags & AV_CPU_FLAG_SSE4) {
+        r.isa = "sse4.1";
+        r.interleave = interleaveRowSse41;
+        r.deinterleave = deinterleaveRowSse41;
+        r.dither = ditherRowSse41;
+        r.hflip = hflipRowSse41;
+        r.box = boxRowSse41;
+        r.blend = blendRowSse41;
+    }
+    if (flags & AV_CPU_FLAG_AVX2) {
+        r.isa = "avx2";
+        r.interleave = interleaveRowAvx2;
+        r.deinterleave = deinterleaveRowAvx2;
+        r.dither = ditherRowAvx2;
+        r.hflip = hflipRowAvx2;
+        r.box = boxRowAvx2;
+        r.blend = blendRowAvx2;
+    }
+    if (flags & AV_CPU_FLAG_AVX512) {
+        r.isa = "avx512";
+        r.interleave = interleaveRowAvx512;
+        r.deinterleave = deinterleaveRowAvx512;
+        r.dither = ditherRowAvx512;
+        r.hflip = hflipRowAvx512;
+        r.box = boxRowAvx512;
+        r.blend = blendRowAvx512;
+    }
+#else
+    (void)flags;
+#endif
+    return r;
+}
+
+static PixelKernels& kernels() {
+    static PixelKernels k = selectKernels(av_get_cpu_flags());
+    return k;
+}
+
+const char* pixelKernelIsa() {
+    return kernels().isa;
+}
+
+bool setPixelKernelIsa(const char* isa) {
+    int want;
+    if (!strcmp(isa, "c")) want = 0;
+#ifdef PIXEL_X86
+    else if (!strcmp(isa, "sse4.1")) want = AV_CPU_FLAG_SSE4;
+    else if (!strcmp(isa, "avx2")) want = AV_CPU_FLAG_SSE4 | AV_CPU_FLAG_AVX2;
+    else if (!strcmp(isa, "avx512")) want = AV_CPU_FLAG_SSE4 | AV_CPU_FLAG_AVX2 | AV_CPU_FLAG_AVX512;
+#endif
+    else return false;
+    if ((av_get_cpu_flags() & want) != want) return false;
+    kernels() = selectKernels(want);
+    return true;
+}
+
+// ---------------- 平面接口 ----------------
+
+void copyPlane(const uint8_t* src, ptrdiff_t srcStride, uint8_t* dst, ptrdiff_t dstStride,
+               int widthBytes, int height) {
+    // libc 的 memcpy 已经按 CPU 选了最快的实现，这里只负责把连续的行合并成一次拷贝
+    if (srcStride == widthBytes && dstStride == widthBytes) {
+        memcpy(dst, src, (size_t)widthBytes * height);
+        return;
+    }
+    for (int y = 0; y < height; ++y)
+        memcpy(dst + y * dstStride, src + y * srcStride, widthBytes);
+}
+
+void interleaveUV(const uint8_t* u, ptrdiff_t uStride, const uint8_t* v, ptrdiff_t vStride,
+                  uint8_t* uv, ptrdiff_t uvStride, int width, int height) {
+    InterleaveRowFn fn = kernels().interleave;
+    for (int y = 0; y < height; ++y)
+        fn(u + y * uStride, v + y * vStride, uv + y * uvStride, width);
+}
+
+void deinterleaveUV(const uint8_t* uv, ptrdiff_t uvStride, uint8_t* u, ptrdiff_t uStride,
+                    uint8_t* v, ptrdiff_t vStride, int width, int height) {
+    DeinterleaveRowFn fn = kernels().deinterleave;
+    for (int y = 0; y < height; ++y)
+        fn(uv + y * uvStride, u + y * uStride, v + y * vStride, width);
+}
+
+void dither10to8(const uint16_t* src, ptrdiff_t srcStride, uint8_t* dst, ptrdiff_t dstStride,
+                 int width, int height, int rowOffset) {
+    DitherRowFn fn = kernels().dither;
+    for (int y = 0; y < height; ++y) {
+        fn((const uint16_t*)((const uint8_t*)src + y * srcStride), dst + y * dstStride, width,
+           kDither8x8[(rowOffset + y) & 7]);
+    }
+}
+
+void hflipRow(const uint8_t* src, uint8_t* dst, int width, int elemSize) {
+    kernels().hflip(src, dst, width, elemSize);
+}
+
+void hflipPlane(const uint8_t* src, ptrdiff_t srcStride, uint8_t* dst, ptrdiff_t dstStride,
+                int width, int height, int elemSize) {
+    HflipRowFn fn = kernels().hflip;
+    for (int y = 0; y < height; ++y)
+        fn(src + y * srcStride, dst + y * dstStride, width, elemSize);
+}
+
+void boxDownscale2x(const uint8_t* src, ptrdiff_t srcStride, uint8_t* dst, ptrdiff_t dstStride,
+                    int dstWidth, int dstHeight) {
+    BoxRowFn fn = kernels().box;
+    for (int y = 0; y < dstHeight; ++y)
+        fn(src + 2 * y * srcStride, src + (2 * y + 1) * srcStride, dst + y * dstStride, dstWidth);
+}
+
+void blendPremultiplied(uint8_t* dst, ptrdiff_t dstStride, const uint8_t* premul, ptrdiff_t premulStride,
+                        const uint8_t* invAlpha, ptrdiff_t alphaStride, int width, int height) {
+    BlendRowFn fn = kernels().blend;
+    for (int y = 0; y < height; ++y)
+        fn(dst + y * dstStride, premul + y * premulStride, invAlpha + y * alphaStride, width);
+}
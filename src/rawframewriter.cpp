@@ -0,0 +1,367 @@
+#include "rawframewriter.h"
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+extern "C" {
+#include <libavutil/pixdesc.h>
+#include <libavutil/imgutils.h>
+#include <libavutil/samplefmt.h>
+#include <libavutil/common.h>
+}
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+// O_DIRECT 要求缓冲地址、长度和文件偏移都按块对齐
+static const size_t kAlign = 4096;
+// 后台模式最多同时存在的暂存块（写盘跟不上时调用线程在此阻塞）
+static const size_t kMaxBlocks = 4;
+
+RawFrameWriter::~RawFrameWriter() {
+    close();
+}
+
+bool RawFrameWriter::open(const std::string& path, bool direct, bool background, size_t blockSize) {
+    close();
+
+    blockSize_ = std::max(kAlign, (blockSize + kAlign - 1) / kAlign * kAlign);
+    direct_ = direct;
+    background_ = background;
+    error_ = false;
+    bytes_ = 0;
+
+    int flags = O_WRONLY | O_CREAT | O_TRUNC;
+#ifdef O_DIRECT
+    if (direct_) {
+        fd_ = ::open(path.c_str(), flags | O_DIRECT, 0644);
+        if (fd_ < 0 && errno == EINVAL) {
+            std::cerr << "RawFrameWriter: O_DIRECT not supported on " << path << ", using buffered IO\n";
+            direct_ = false;
+        }
+    }
+#else
+    direct_ = false;
+#endif
+    if (fd_ < 0) fd_ = ::open(path.c_str(), flags, 0644);
+    if (fd_ < 0) {
+        std::cerr << "RawFrameWriter: failed to open " << path << ": " << strerror(errno) << "\n";
+        return false;
+    }
+
+    stop_ = false;
+    if (background_) writer_ = std::thread([this]{ writerLoop(); });
+    return true;
+}
+
+bool RawFrameWriter::close() {
+    if (fd_ < 0) return !error_;
+
+    if (cur_ && cur_->used > 0) submitBlock(cur_);
+    else if (cur_) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        free_.push_back(cur_);
+    }
+    cur_ = nullptr;
+
+    if (writer_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cond_.notify_all();
+        writer_.join();
+    }
+
+    for (Block* b : blocks_) {
+        free(b->data);
+        delete b;
+    }
+    blocks_.clear();
+    free_.clear();
+    pending_.clear();
+
+    ::close(fd_);
+    fd_ = -1;
+    return !error_;
+}
+
+// ---------------- 暂存块 ----------------
+
+RawFrameWriter::Block* RawFrameWriter::acquireBlock() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (background_) {
+        cond_.wait(lock, [&]{ return !free_.empty() || blocks_.size() < kMaxBlocks; });
+    }
+    if (!free_.empty()) {
+        Block* b = free_.back();
+        free_.pop_back();
+        b->used = 0;
+        return b;
+    }
+
+    Block* b = new Block();
+    if (posix_memalign((void**)&b->data, kAlign, blockSize_) != 0) {
+        delete b;
+        error_ = true;
+        return nullptr;
+    }
+    blocks_.push_back(b);
+    return b;
+}
+
+void RawFrameWriter::submitBlock(Block* b) {
+    if (background_) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pending_.push_back(b);
+        }
+        cond_.notify_all();
+        return;
+    }
+
+    writeBlock(b);
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_.push_back(b);
+}
+
+void RawFrameWriter::writerLoop() {
+    while (true) {
+        Block* b = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cond_.wait(lock, [&]{ return !pending_.empty() || stop_; });
+            if (pending_.empty()) return;
+            b = pending_.front();
+            pending_.pop_front();
+        }
+
+        writeBlock(b);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            free_.push_back(b);
+        }
+        cond_.notify_all();
+    }
+}
+
+void RawFrameWriter::writeBlock(Block* b) {
+    size_t size = b->used;
+    b->used = 0;
+    if (size == 0) return;
+
+    // 只有最后一块可能不满；O_DIRECT 下先写对齐部分，尾巴关掉 O_DIRECT 后再写
+    size_t aligned = direct_ ? size / kAlign * kAlign : size;
+    if (aligned > 0 && !writeAll(b->data, aligned)) return;
+    if (aligned < size) {
+#ifdef O_DIRECT
+        int flags = fcntl(fd_, F_GETFL);
+        if (flags >= 0) fcntl(fd_, F_SETFL, flags & ~O_DIRECT);
+#endif
+        writeAll(b->data + aligned, size - aligned);
+    }
+}
+
+bool RawFrameWriter::writeAll(const uint8_t* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = ::write(fd_, data, size);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "RawFrameWriter: write failed: " << strerror(errno) << "\n";
+            error_ = true;
+            return false;
+        }
+        data += n;
+        size -= (size_t)n;
+        bytes_ += (uint64_t)n;
+    }
+    return true;
+}
+
+uint8_t* RawFrameWriter::reserve(size_t* avail) {
+    if (!cur_) cur_ = acquireBlock();
+    if (!cur_) {
+        *avail = 0;
+        return nullptr;
+    }
+    *avail = blockSize_ - cur_->used;
+    return cur_->data + cur_->used;
+}
+
+void RawFrameWriter::commit(size_t size) {
+    cur_->used += size;
+    if (cur_->used == blockSize_) {
+        submitBlock(cur_);
+        cur_ = nullptr;
+    }
+}
+
+void RawFrameWriter::append(const uint8_t* data, size_t size) {
+    while (size > 0) {
+        size_t avail = 0;
+        uint8_t* dst = reserve(&avail);
+        if (!dst) return;
+        size_t n = std::min(avail, size);
+        memcpy(dst, data, n);
+        commit(n);
+        data += n;
+        size -= n;
+    }
+}
+
+// ---------------- 写出 ----------------
+
+bool RawFrameWriter::writeIov(std::vector<struct iovec>& iov, size_t total) {
+    if (fd_ < 0) return false;
+
+    // 小数据拷进暂存块合并；O_DIRECT 和后台模式也必须经过暂存块（对齐 / 调用方随后会释放帧）
+    if (direct_ || background_ || total < blockSize_ / 4) {
+        for (const struct iovec& v : iov) append((const uint8_t*)v.iov_base, v.iov_len);
+        return !error_;
+    }
+
+    // 大帧直接 writev，之前暂存的数据先落盘保证顺序
+    if (cur_ && cur_->used > 0) writeBlock(cur_);
+
+    size_t first = 0;
+    while (first < iov.size()) {
+        int cnt = (int)std::min<size_t>(iov.size() - first, IOV_MAX);
+        ssize_t n = ::writev(fd_, &iov[first], cnt);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "RawFrameWriter: writev failed: " << strerror(errno) << "\n";
+            error_ = true;
+            return false;
+        }
+        bytes_ += (uint64_t)n;
+
+        // 跳过已完整写出的 iovec，部分写出的那个前移起点
+        size_t left = (size_t)n;
+        while (first < iov.size() && left >= iov[first].iov_len) {
+            left -= iov[first].iov_len;
+            ++first;
+        }
+        if (first < iov.size() && left > 0) {
+            iov[first].iov_base = (uint8_t*)iov[first].iov_base + left;
+            iov[first].iov_len -= left;
+        }
+    }
+    return true;
+}
+
+bool RawFrameWriter::write(const void* data, size_t size) {
+    if (!data || size == 0) return true;
+    std::vector<struct iovec> iov(1);
+    iov[0].iov_base = const_cast<void*>(data);
+    iov[0].iov_len = size;
+    return writeIov(iov, size);
+}
+
+bool RawFrameWriter::writeVideo(const AVFrame* frame) {
+    if (!frame || fd_ < 0) return false;
+
+    AVPixelFormat fmt = (AVPixelFormat)frame->format;
+    const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(fmt);
+    if (!desc || (desc->flags & (AV_PIX_FMT_FLAG_HWACCEL | AV_PIX_FMT_FLAG_BITSTREAM))) {
+        std::cerr << "RawFrameWriter: unsupported pixel format " << frame->format << "\n";
+        return false;
+    }
+
+    std::vector<struct iovec> iov;
+    size_t total = 0;
+    int planes = av_pix_fmt_count_planes(fmt);
+    for (int i = 0; i < planes; ++i) {
+        int rowBytes = av_image_get_linesize(fmt, frame->width, i);
+        if (rowBytes <= 0) return false;
+        // 平面 1、2 是色度，其余（亮度 / alpha / 打包格式）是全高
+        int h = (i == 1 || i == 2) ? AV_CEIL_RSHIFT(frame->height, desc->log2_chroma_h) : frame->height;
+
+        const uint8_t* p = frame->data[i];
+        if (frame->linesize[i] == rowBytes) {
+            struct iovec v;
+            v.iov_base = const_cast<uint8_t*>(p);
+            v.iov_len = (size_t)rowBytes * h;
+            iov.push_back(v);
+        } else {
+            for (int y = 0; y < h; ++y) {
+                struct iovec v;
+                v.iov_base = const_cast<uint8_t*>(p + (ptrdiff_t)y * frame->linesize[i]);
+                v.iov_len = rowBytes;
+                iov.push_back(v);
+            }
+        }
+        total += (size_t)rowBytes * h;
+    }
+
+    // 调色板格式：索引平面之后写 256 色调色板
+    if (desc->flags & AV_PIX_FMT_FLAG_PAL) {
+        struct iovec v;
+        v.iov_base = frame->data[1];
+        v.iov_len = 256 * 4;
+        iov.push_back(v);
+        total += v.iov_len;
+    }
+
+    return writeIov(iov, total);
+}
+
+template<typename T>
+static void interleave(uint8_t* dst, const uint8_t* const* src, int channels, int offset, int count) {
+    T* d = (T*)dst;
+    for (int i = 0; i < count; ++i) {
+        for (int c = 0; c < channels; ++c) *d++ = ((const T*)src[c])[offset + i];
+    }
+}
+
+static void interleaveSamples(uint8_t* dst, const uint8_t* const* src, int channels, int bps,
+                              int offset, int count) {
+    switch (bps) {
+    case 1: interleave<uint8_t>(dst, src, channels, offset, count); break;
+    case 2: interleave<uint16_t>(dst, src, channels, offset, count); break;
+    case 4: interleave<uint32_t>(dst, src, channels, offset, count); break;
+    case 8: interleave<uint64_t>(dst, src, channels, offset, count); break;
+    }
+}
+
+bool RawFrameWriter::writeAudio(const AVFrame* frame) {
+    if (!frame || fd_ < 0) return false;
+
+    AVSampleFormat fmt = (AVSampleFormat)frame->format;
+    int bps = av_get_bytes_per_sample(fmt);
+    int channels = frame->channels;
+    if (bps <= 0 || channels <= 0) return false;
+
+    if (!av_sample_fmt_is_planar(fmt) || channels == 1)
+        return write(frame->data[0], (size_t)frame->nb_samples * channels * bps);
+
+    // 平面格式：直接交错进暂存块，不经过临时缓冲
+    const uint8_t* const* src = frame->extended_data;
+    const size_t sampleBytes = (size_t)channels * bps;
+    int done = 0;
+    while (done < frame->nb_samples) {
+        size_t avail = 0;
+        uint8_t* dst = reserve(&avail);
+        if (!dst) return false;
+
+        int n = std::min<int>(frame->nb_samples - done, (int)(avail / sampleBytes));
+        if (n == 0) {
+            // 暂存块剩余空间不够一个采样点，跨块写
+            uint8_t tmp[8 * 64];
+            if (sampleBytes > sizeof(tmp)) return false;
+            interleaveSamples(tmp, src, channels, bps, done, 1);
+            append(tmp, sampleBytes);
+            ++done;
+            continue;
+        }
+        interleaveSamples(dst, src, channels, bps, done, n);
+        commit((size_t)n * sampleBytes);
+        done += n;
+    }
+    return !error_;
+}
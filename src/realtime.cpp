@@ -0,0 +1,73 @@
+#include "realtime.h"
+#include <chrono>
+#include <iostream>
+extern "C" {
+#include <libavutil/mathematics.h>
+}
+
+RealtimeController::RealtimeController(int latencyMs)
+    : latencyUs_((int64_t)latencyMs * 1000) {
+    for (int i = 0; i < STAGE_COUNT; ++i) {
+        dropped_[i] = 0;
+        passed_[i] = 0;
+    }
+}
+
+int64_t RealtimeController::nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void RealtimeController::stamp(AVFrame* frame, AVRational timeBase) {
+    if (!frame) return;
+
+    int64_t pts = frame->best_effort_timestamp != AV_NOPTS_VALUE ?
+                  frame->best_effort_timestamp : frame->pts;
+    if (pts == AV_NOPTS_VALUE || timeBase.num <= 0 || timeBase.den <= 0) {
+        frame->opaque = nullptr;
+        return;
+    }
+
+    int64_t ptsUs = av_rescale_q(pts, timeBase, AVRational{1, 1000000});
+
+    // 第一帧到达的时刻对齐到它的 pts
+    if (anchorWallUs_.load() == AV_NOPTS_VALUE) {
+        anchorPtsUs_ = ptsUs;
+        anchorWallUs_ = nowUs();
+    }
+
+    int64_t deadline = anchorWallUs_.load() + (ptsUs - anchorPtsUs_.load()) + latencyUs_;
+    frame->opaque = (void*)(intptr_t)deadline;
+}
+
+int64_t RealtimeController::lateness(const AVFrame* frame) const {
+    if (!frame || !frame->opaque) return 0;
+    int64_t deadline = (int64_t)(intptr_t)frame->opaque;
+    return nowUs() - deadline;
+}
+
+bool RealtimeController::shouldDrop(const AVFrame* frame, Stage stage) {
+    int64_t late = lateness(frame);
+
+    if (stage == STAGE_DECODE) behind_ = late > 0;
+
+    bool drop = false;
+    if (late > 0) {
+        bool nonRef = frame->pict_type == AV_PICTURE_TYPE_B;
+        // 严重迟到时保留关键帧，其余全部丢弃
+        drop = nonRef || (late > latencyUs_ && !frame->key_frame);
+    }
+
+    if (drop) dropped_[stage]++;
+    else passed_[stage]++;
+    return drop;
+}
+
+void RealtimeController::printStats() const {
+    static const char* names[STAGE_COUNT] = {"decode", "filter", "encode"};
+    std::cout << "[Realtime] latency target " << latencyUs_ / 1000 << " ms\n";
+    for (int i = 0; i < STAGE_COUNT; ++i) {
+        std::cout << "  " << names[i] << ": passed " << passed_[i].load()
+                  << ", dropped " << dropped_[i].load() << "\n";
+    }
+}
@@ -0,0 +1,231 @@
+#include "roidetector.h"
+#include "pixelkernels.h"
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <utility>
+#include <algorithm>
+extern "C" {
+#include <libavutil/pixdesc.h>
+#include <libavutil/mem.h>
+#include <libavutil/common.h>
+}
+
+bool RoiDetector::attach(AVFrame* frame, const std::vector<AVRegionOfInterest>& regions) {
+    av_frame_remove_side_data(frame, AV_FRAME_DATA_REGIONS_OF_INTEREST);
+    if (regions.empty()) return true;
+
+    AVFrameSideData* sd = av_frame_new_side_data(frame, AV_FRAME_DATA_REGIONS_OF_INTEREST,
+                                                 regions.size() * sizeof(AVRegionOfInterest));
+    if (!sd) return false;
+    memcpy(sd->data, regions.data(), sd->size);
+    return true;
+}
+
+static AVRegionOfInterest makeRegion(int top, int bottom, int left, int right, float offset) {
+    AVRegionOfInterest r;
+    r.self_size = sizeof(AVRegionOfInterest);
+    r.top = top;
+    r.bottom = bottom;
+    r.left = left;
+    r.right = right;
+    r.qoffset = av_make_q((int)lrintf(offset * 1000.0f), 1000);
+    return r;
+}
+
+MotionRoiDetector::MotionRoiDetector(double threshold, float roiOffset, float backgroundOffset,
+                                     int holdFrames, int maxRegions)
+    : threshold_(threshold), roiOffset_(av_clipf(roiOffset, -1.0f, 1.0f)),
+      backgroundOffset_(av_clipf(backgroundOffset, -1.0f, 1.0f)),
+      holdFrames_(std::max(1, holdFrames)), maxRegions_(std::max(1, maxRegions)) {
+    // 8x8，块起点都在 8 字节边界上
+    sad8_ = av_pixelutils_get_sad_fn(3, 3, 2, nullptr);
+}
+
+MotionRoiDetector::~MotionRoiDetector() {
+    reset();
+}
+
+void MotionRoiDetector::reset() {
+    av_freep(&cur_);
+    av_freep(&prev_);
+    inWidth_ = inHeight_ = 0;
+    inFormat_ = -1;
+    supported_ = false;
+    havePrev_ = false;
+    hold_.clear();
+    mask_.clear();
+    frames_ = roiFrames_ = 0;
+    coverageSum_ = 0.0;
+}
+
+bool MotionRoiDetector::prepare(const AVFrame* frame) {
+    if (frame->width == inWidth_ && frame->height == inHeight_ && frame->format == inFormat_)
+        return supported_;
+
+    av_freep(&cur_);
+    av_freep(&prev_);
+    havePrev_ = false;
+    inWidth_ = frame->width;
+    inHeight_ = frame->height;
+    inFormat_ = frame->format;
+    supported_ = false;
+
+    const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get((AVPixelFormat)frame->format);
+    if (!desc || (desc->flags & (AV_PIX_FMT_FLAG_RGB | AV_PIX_FMT_FLAG_PAL |
+                                 AV_PIX_FMT_FLAG_BITSTREAM | AV_PIX_FMT_FLAG_HWACCEL)) ||
+        desc->comp[0].depth != 8 || desc->comp[0].step != 1) {
+        std::cerr << "MotionRoiDetector: unsupported pixel format " << frame->format << ", ROI disabled\n";
+        return false;
+    }
+
+    // 缩小一半后 8x8 一块，不足一块的右边 / 下边并入最后一块
+    int hw = frame->width / 2, hh = frame->height / 2;
+    gridW_ = hw / 8;
+    gridH_ = hh / 8;
+    if (gridW_ < 1 || gridH_ < 1) {
+        std::cerr << "MotionRoiDetector: frame too small, ROI disabled\n";
+        return false;
+    }
+
+    halfStride_ = FFALIGN(hw, 64);
+    cur_ = (uint8_t*)av_malloc((size_t)halfStride_ * hh);
+    prev_ = (uint8_t*)av_malloc((size_t)halfStride_ * hh);
+    if (!cur_ || !prev_) return false;
+
+    hold_.assign((size_t)gridW_ * gridH_, 0);
+    mask_.assign((size_t)gridW_ * gridH_, 0);
+    supported_ = true;
+    return true;
+}
+
+void MotionRoiDetector::buildRegions(std::vector<AVRegionOfInterest>& regions) {
+    // 扩边：运动块四周各扩一块，避免运动物体边缘落在背景的高 QP 里
+    int active = 0;
+    for (int y = 0; y < gridH_; ++y) {
+        for (int x = 0; x < gridW_; ++x) {
+            bool on = false;
+            for (int dy = -1; dy <= 1 && !on; ++dy) {
+                int yy = y + dy;
+                if (yy < 0 || yy >= gridH_) continue;
+                for (int dx = -1; dx <= 1; ++dx) {
+                    int xx = x + dx;
+                    if (xx >= 0 && xx < gridW_ && hold_[(size_t)yy * gridW_ + xx] > 0) {
+                        on = true;
+                        break;
+                    }
+                }
+            }
+            mask_[(size_t)y * gridW_ + x] = on;
+            active += on;
+        }
+    }
+    if (active == 0) return;
+
+    // 每行的连续运动块是一段，上下相邻且左右边界相同的段合并成一个矩形
+    struct Rect {
+        int left, right, top, bottom;   // 块坐标，right / bottom 不含
+    };
+    std::vector<Rect> open, closed, next;
+    int minX = gridW_, maxX = 0, minY = gridH_, maxY = 0;
+    for (int y = 0; y < gridH_; ++y) {
+        const uint8_t* row = &mask_[(size_t)y * gridW_];
+        next.clear();
+        for (int x = 0; x < gridW_;) {
+            if (!row[x]) {
+                ++x;
+                continue;
+            }
+            int x2 = x;
+            while (x2 < gridW_ && row[x2]) ++x2;
+
+            auto it = std::find_if(open.begin(), open.end(),
+                                   [&](const Rect& r) { return r.left == x && r.right == x2; });
+            if (it != open.end()) {
+                it->bottom = y + 1;
+                next.push_back(*it);
+                open.erase(it);
+            } else {
+                next.push_back({x, x2, y, y + 1});
+            }
+            minX = std::min(minX, x);
+            maxX = std::max(maxX, x2);
+            minY = std::min(minY, y);
+            maxY = y + 1;
+            x = x2;
+        }
+        closed.insert(closed.end(), open.begin(), open.end());
+        open.swap(next);
+    }
+    closed.insert(closed.end(), open.begin(), open.end());
+
+    if ((int)closed.size() > maxRegions_) {
+        closed.clear();
+        closed.push_back({minX, maxX, minY, maxY});
+    }
+
+    // 换算成原图像素，最后一行 / 列的块延伸到画面边缘
+    int64_t area = 0;
+    for (const Rect& r : closed) {
+        int left = r.left * 16, top = r.top * 16;
+        int right = r.right == gridW_ ? inWidth_ : r.right * 16;
+        int bottom = r.bottom == gridH_ ? inHeight_ : r.bottom * 16;
+        regions.push_back(makeRegion(top, bottom, left, right, roiOffset_));
+        area += (int64_t)(right - left) * (bottom - top);
+    }
+    // 背景放在最后：重叠时靠前的运动区域生效
+    if (backgroundOffset_ != 0.0f)
+        regions.push_back(makeRegion(0, inHeight_, 0, inWidth_, backgroundOffset_));
+
+    coverageSum_ += (double)area / ((double)inWidth_ * inHeight_);
+}
+
+int MotionRoiDetector::analyze(AVFrame* frame) {
+    if (!frame) return 0;
+    ++frames_;
+
+    std::vector<AVRegionOfInterest> regions;
+    if (prepare(frame)) {
+        int hw = inWidth_ / 2, hh = inHeight_ / 2;
+        boxDownscale2x(frame->data[0], frame->linesize[0], cur_, halfStride_, hw, hh);
+
+        if (havePrev_) {
+            // 块内每像素平均差超过阈值为运动块，之后 holdFrames 帧内仍算运动块
+            const int64_t limit = (int64_t)(threshold_ * 64.0);
+            for (int by = 0; by < gridH_; ++by) {
+                for (int bx = 0; bx < gridW_; ++bx) {
+                    const uint8_t* a = cur_ + (ptrdiff_t)by * 8 * halfStride_ + bx * 8;
+                    const uint8_t* b = prev_ + (ptrdiff_t)by * 8 * halfStride_ + bx * 8;
+                    int64_t sad = 0;
+                    if (sad8_) {
+                        sad = sad8_(a, halfStride_, b, halfStride_);
+                    } else {
+                        for (int r = 0; r < 8; ++r) {
+                            for (int c = 0; c < 8; ++c)
+                                sad += abs(a[r * halfStride_ + c] - b[r * halfStride_ + c]);
+                        }
+                    }
+                    int& h = hold_[(size_t)by * gridW_ + bx];
+                    if (sad >= limit) h = holdFrames_;
+                    else if (h > 0) --h;
+                }
+            }
+            buildRegions(regions);
+        }
+        std::swap(cur_, prev_);
+        havePrev_ = true;
+    }
+
+    if (!attach(frame, regions)) {
+        std::cerr << "MotionRoiDetector: failed to attach side data\n";
+        return 0;
+    }
+    if (!regions.empty()) ++roiFrames_;
+    return (int)regions.size();
+}
+
+void MotionRoiDetector::printStats() const {
+    std::cout << "[MotionRoiDetector] frames: " << frames_ << ", with ROI: " << roiFrames_
+              << ", average ROI coverage: " << averageCoverage() * 100.0 << "%\n";
+}
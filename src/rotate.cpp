@@ -0,0 +1,230 @@
+#include "rotate.h"
+#include "pixelkernels.h"
+#include <algorithm>
+#include <cstring>
+extern "C" {
+#include <libavutil/cpu.h>
+#include <libavutil/pixdesc.h>
+#include <libavutil/common.h>
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define ROTATE_X86 1
+#endif
+
+// 分块大小：64x64 的源块和目标块都能留在 L1 中
+static const int kTile = 64;
+
+// ---------------- 标量实现 ----------------
+
+template<typename T>
+static void transposeTileC(const uint8_t* src, ptrdiff_t ss, uint8_t* dst, ptrdiff_t ds, int w, int h) {
+    for (int y = 0; y < h; ++y) {
+        const T* s = (const T*)(src + y * ss);
+        for (int x = 0; x < w; ++x) {
+            *(T*)(dst + x * ds + y * (ptrdiff_t)sizeof(T)) = s[x];
+        }
+    }
+}
+
+// ---------------- x86 SIMD 内核 ----------------
+
+#ifdef ROTATE_X86
+
+// 16x16 字节转置：4 轮 unpack，每轮把 (行号, 列号) 的 8 位索引循环左移 1 位，4 轮后行列互换
+__attribute__((target("sse2")))
+static void transpose16x16_sse2(const uint8_t* src, ptrdiff_t ss, uint8_t* dst, ptrdiff_t ds) {
+    __m128i r[16], t[16];
+    for (int i = 0; i < 16; ++i) r[i] = _mm_loadu_si128((const __m128i*)(src + i * ss));
+    for (int round = 0; round < 4; ++round) {
+        for (int k = 0; k < 8; ++k) {
+            t[2 * k]     = _mm_unpacklo_epi8(r[k], r[k + 8]);
+            t[2 * k + 1] = _mm_unpackhi_epi8(r[k], r[k + 8]);
+        }
+        for (int i = 0; i < 16; ++i) r[i] = t[i];
+    }
+    for (int i = 0; i < 16; ++i) _mm_storeu_si128((__m128i*)(dst + i * ds), r[i]);
+}
+
+// 16 行 x 32 列：两个 128 位 lane 各自独立完成一个 16x16 转置
+__attribute__((target("avx2")))
+static void transpose32x16_avx2(const uint8_t* src, ptrdiff_t ss, uint8_t* dst, ptrdiff_t ds) {
+    __m256i r[16], t[16];
+    for (int i = 0; i < 16; ++i) r[i] = _mm256_loadu_si256((const __m256i*)(src + i * ss));
+    for (int round = 0; round < 4; ++round) {
+        for (int k = 0; k < 8; ++k) {
+            t[2 * k]     = _mm256_unpacklo_epi8(r[k], r[k + 8]);
+            t[2 * k + 1] = _mm256_unpackhi_epi8(r[k], r[k + 8]);
+        }
+        for (int i = 0; i < 16; ++i) r[i] = t[i];
+    }
+    for (int i = 0; i < 16; ++i) {
+        _mm_storeu_si128((__m128i*)(dst + i * ds), _mm256_castsi256_si128(r[i]));
+        _mm_storeu_si128((__m128i*)(dst + (i + 16) * ds), _mm256_extracti128_si256(r[i], 1));
+    }
+}
+
+__attribute__((target("sse2")))
+static void transposeTile8_sse2(const uint8_t* src, ptrdiff_t ss, uint8_t* dst, ptrdiff_t ds, int w, int h) {
+    int y = 0;
+    for (; y + 16 <= h; y += 16) {
+        int x = 0;
+        for (; x + 16 <= w; x += 16)
+            transpose16x16_sse2(src + y * ss + x, ss, dst + x * ds + y, ds);
+        if (x < w)
+            transposeTileC<uint8_t>(src + y * ss + x, ss, dst + x * ds + y, ds, w - x, 16);
+    }
+    if (y < h)
+        transposeTileC<uint8_t>(src + y * ss, ss, dst + y, ds, w, h - y);
+}
+
+__attribute__((target("avx2")))
+static void transposeTile8_avx2(const uint8_t* src, ptrdiff_t ss, uint8_t* dst, ptrdiff_t ds, int w, int h) {
+    int y = 0;
+    for (; y + 16 <= h; y += 16) {
+        int x = 0;
+        for (; x + 32 <= w; x += 32)
+            transpose32x16_avx2(src + y * ss + x, ss, dst + x * ds + y, ds);
+        for (; x + 16 <= w; x += 16)
+            transpose16x16_sse2(src + y * ss + x, ss, dst + x * ds + y, ds);
+        if (x < w)
+            transposeTileC<uint8_t>(src + y * ss + x, ss, dst + x * ds + y, ds, w - x, 16);
+    }
+    if (y < h)
+        transposeTileC<uint8_t>(src + y * ss, ss, dst + y, ds, w, h - y);
+}
+
+#endif // ROTATE_X86
+
+// ---------------- 运行时选择 ----------------
+
+typedef void (*TransposeTileFn)(const uint8_t*, ptrdiff_t, uint8_t*, ptrdiff_t, int, int);
+
+struct RotateKernels {
+    TransposeTileFn transpose8 = transposeTileC<uint8_t>;
+};
+
+static const RotateKernels& kernels() {
+    static const RotateKernels k = [] {
+        RotateKernels r;
+#ifdef ROTATE_X86
+        int flags = av_get_cpu_flags();
+        if (flags & AV_CPU_FLAG_SSE2) {
+            r.transpose8 = transposeTile8_sse2;
+        }
+        if (flags & AV_CPU_FLAG_AVX2) {
+            r.transpose8 = transposeTile8_avx2;
+        }
+#endif
+        return r;
+    }();
+    return k;
+}
+
+// 分块转置：源 w x h，目标 h x w；stride 可以为负（用于翻转）
+static void transposePlane(const uint8_t* src, ptrdiff_t ss, uint8_t* dst, ptrdiff_t ds,
+                           int w, int h, int elemSize) {
+    TransposeTileFn fn = elemSize == 1 ? kernels().transpose8 :
+                         elemSize == 2 ? transposeTileC<uint16_t> : transposeTileC<uint32_t>;
+    for (int by = 0; by < h; by += kTile) {
+        int bh = std::min(kTile, h - by);
+        for (int bx = 0; bx < w; bx += kTile) {
+            int bw = std::min(kTile, w - bx);
+            fn(src + by * ss + (ptrdiff_t)bx * elemSize, ss,
+               dst + bx * ds + (ptrdiff_t)by * elemSize, ds, bw, bh);
+        }
+    }
+}
+
+void rotatePlane(const uint8_t* src, ptrdiff_t srcStride, int w, int h,
+                 uint8_t* dst, ptrdiff_t dstStride, int elemSize, int angle,
+                 int rowBegin, int rowEnd) {
+    int dstH = (angle == 90 || angle == 270) ? w : h;
+    int r0 = std::max(0, rowBegin);
+    int r1 = (rowEnd < 0 || rowEnd > dstH) ? dstH : rowEnd;
+    if (r0 >= r1) return;
+
+    switch (angle) {
+    case 90:
+        // dst[y][x] = src[h-1-x][y]：源从最后一行开始、负 stride 读，即先垂直翻转再转置
+        // 目标行 r 对应源第 r 列
+        transposePlane(src + (h - 1) * srcStride + (ptrdiff_t)r0 * elemSize, -srcStride,
+                       dst + r0 * dstStride, dstStride, r1 - r0, h, elemSize);
+        break;
+    case 270:
+        // dst[y][x] = src[x][w-1-y]：转置后写入垂直翻转的目标
+        // 目标行 [r0, r1) 对应源列 [w-r1, w-r0)
+        transposePlane(src + (ptrdiff_t)(w - r1) * elemSize, srcStride,
+                       dst + (r1 - 1) * dstStride, -dstStride, r1 - r0, h, elemSize);
+        break;
+    case 180:
+        // 源从第 h-1-r0 行开始倒序读，逐行水平翻转
+        hflipPlane(src + (h - 1 - r0) * srcStride, -srcStride, dst + r0 * dstStride, dstStride,
+                   w, r1 - r0, elemSize);
+        break;
+    default:
+        for (int y = r0; y < r1; ++y)
+            memcpy(dst + y * dstStride, src + y * srcStride, (size_t)w * elemSize);
+        break;
+    }
+}
+
+// 每个平面的元素字节数，不支持时返回 0
+static int planeElemSize(const AVPixFmtDescriptor* desc, int plane) {
+    int step = 0;
+    for (int c = 0; c < desc->nb_components; ++c) {
+        if (desc->comp[c].plane != plane) continue;
+        if (step && step != desc->comp[c].step) return 0;  // 同平面步长不一致（如 YUYV）
+        step = desc->comp[c].step;
+    }
+    return (step == 1 || step == 2 || step == 4) ? step : 0;
+}
+
+bool rotateSupported(AVPixelFormat fmt, int angle) {
+    const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(fmt);
+    if (!desc) return false;
+    if (desc->flags & (AV_PIX_FMT_FLAG_PAL | AV_PIX_FMT_FLAG_BITSTREAM | AV_PIX_FMT_FLAG_HWACCEL))
+        return false;
+    if (angle != 0 && angle != 90 && angle != 180 && angle != 270) return false;
+
+    // 4:2:2 转 90 度会变成 4:4:0，格式不同，交给滤镜处理
+    if ((angle == 90 || angle == 270) && desc->log2_chroma_w != desc->log2_chroma_h)
+        return false;
+
+    int planes = av_pix_fmt_count_planes(fmt);
+    for (int p = 0; p < planes; ++p) {
+        if (!planeElemSize(desc, p)) return false;
+    }
+    return true;
+}
+
+void rotatedSize(int width, int height, int angle, int* outWidth, int* outHeight) {
+    bool swap = angle == 90 || angle == 270;
+    *outWidth = swap ? height : width;
+    *outHeight = swap ? width : height;
+}
+
+bool rotateFrame(const AVFrame* src, AVFrame* dst, int angle, int rowBegin, int rowEnd) {
+    AVPixelFormat fmt = (AVPixelFormat)src->format;
+    if (!rotateSupported(fmt, angle) || dst->format != src->format) return false;
+
+    int outW, outH;
+    rotatedSize(src->width, src->height, angle, &outW, &outH);
+    if (dst->width != outW || dst->height != outH) return false;
+
+    if (rowEnd < 0 || rowEnd > outH) rowEnd = outH;
+
+    const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(fmt);
+    int planes = av_pix_fmt_count_planes(fmt);
+    for (int p = 0; p < planes; ++p) {
+        bool chroma = p == 1 || p == 2;
+        int w = chroma ? AV_CEIL_RSHIFT(src->width, desc->log2_chroma_w) : src->width;
+        int h = chroma ? AV_CEIL_RSHIFT(src->height, desc->log2_chroma_h) : src->height;
+        int shift = chroma ? desc->log2_chroma_h : 0;
+        rotatePlane(src->data[p], src->linesize[p], w, h,
+                    dst->data[p], dst->linesize[p], planeElemSize(desc, p), angle,
+                    AV_CEIL_RSHIFT(rowBegin, shift), AV_CEIL_RSHIFT(rowEnd, shift));
+    }
+    return true;
+}
@@ -0,0 +1,187 @@
+#include "scenedetector.h"
+#include "pixelkernels.h"
+#include <iostream>
+#include <cstdlib>
+#include <utility>
+extern "C" {
+#include <libavutil/pixdesc.h>
+#include <libavutil/mem.h>
+#include <libavutil/common.h>
+}
+
+// 缩小后的最大宽度：再大对切换判断没有帮助，只增加开销
+static const int kMaxSmallWidth = 256;
+static const int kHistBins = 64;
+
+SceneDetector::SceneDetector(double threshold, int minSceneFrames)
+    : threshold_(threshold), minSceneFrames_(minSceneFrames) {
+    // 16x16，两边地址都按 16 字节对齐
+    sad16_ = av_pixelutils_get_sad_fn(4, 4, 2, nullptr);
+}
+
+SceneDetector::~SceneDetector() {
+    reset();
+}
+
+void SceneDetector::reset() {
+    av_freep(&cur_);
+    av_freep(&prev_);
+    av_freep(&scratch_[0]);
+    av_freep(&scratch_[1]);
+    inWidth_ = inHeight_ = 0;
+    inFormat_ = -1;
+    supported_ = false;
+    havePrev_ = false;
+    avgSad_ = 0.0;
+    frameIndex_ = 0;
+    lastCut_ = 0;
+    cuts_.clear();
+}
+
+bool SceneDetector::prepare(const AVFrame* frame) {
+    if (frame->width == inWidth_ && frame->height == inHeight_ && frame->format == inFormat_)
+        return supported_;
+
+    av_freep(&cur_);
+    av_freep(&prev_);
+    av_freep(&scratch_[0]);
+    av_freep(&scratch_[1]);
+    havePrev_ = false;
+    inWidth_ = frame->width;
+    inHeight_ = frame->height;
+    inFormat_ = frame->format;
+    supported_ = false;
+
+    const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get((AVPixelFormat)frame->format);
+    if (!desc || (desc->flags & (AV_PIX_FMT_FLAG_RGB | AV_PIX_FMT_FLAG_PAL |
+                                 AV_PIX_FMT_FLAG_BITSTREAM | AV_PIX_FMT_FLAG_HWACCEL)) ||
+        desc->comp[0].depth != 8 || desc->comp[0].step != 1) {
+        std::cerr << "SceneDetector: unsupported pixel format " << frame->format << ", detection disabled\n";
+        return false;
+    }
+
+    // 每次缩小宽高各减半（向下取整），直到宽度不超过 kMaxSmallWidth
+    int w = frame->width, h = frame->height;
+    levels_ = 0;
+    while (w > kMaxSmallWidth && h / 2 >= 16) {
+        w /= 2;
+        h /= 2;
+        ++levels_;
+    }
+    smallW_ = w & ~15;
+    smallH_ = h & ~15;
+    if (smallW_ < 16 || smallH_ < 16) {
+        std::cerr << "SceneDetector: frame too small, detection disabled\n";
+        return false;
+    }
+
+    smallStride_ = FFALIGN(w, 64);
+    cur_ = (uint8_t*)av_malloc((size_t)smallStride_ * h);
+    prev_ = (uint8_t*)av_malloc((size_t)smallStride_ * h);
+    if (levels_ > 1) {
+        scratchStride_ = FFALIGN(frame->width / 2, 64);
+        scratch_[0] = (uint8_t*)av_malloc((size_t)scratchStride_ * (frame->height / 2));
+        scratch_[1] = (uint8_t*)av_malloc((size_t)scratchStride_ * (frame->height / 2));
+        if (!scratch_[0] || !scratch_[1]) return false;
+    }
+    if (!cur_ || !prev_) return false;
+
+    supported_ = true;
+    return true;
+}
+
+void SceneDetector::downscale(const AVFrame* frame, uint8_t* dst) {
+    const uint8_t* src = frame->data[0];
+    ptrdiff_t ss = frame->linesize[0];
+    int w = frame->width, h = frame->height;
+
+    if (levels_ == 0) {
+        copyPlane(src, ss, dst, smallStride_, w, h);
+        return;
+    }
+
+    for (int i = 0; i < levels_; ++i) {
+        bool last = i == levels_ - 1;
+        uint8_t* out = last ? dst : scratch_[i & 1];
+        ptrdiff_t os = last ? smallStride_ : scratchStride_;
+        w /= 2;
+        h /= 2;
+        boxDownscale2x(src, ss, out, os, w, h);
+        src = out;
+        ss = os;
+    }
+}
+
+int64_t SceneDetector::blockSad(const uint8_t* a, const uint8_t* b) const {
+    int64_t sum = 0;
+    for (int y = 0; y < smallH_; y += 16) {
+        for (int x = 0; x < smallW_; x += 16) {
+            const uint8_t* pa = a + (ptrdiff_t)y * smallStride_ + x;
+            const uint8_t* pb = b + (ptrdiff_t)y * smallStride_ + x;
+            if (sad16_) {
+                sum += sad16_(pa, smallStride_, pb, smallStride_);
+                continue;
+            }
+            // libavutil 没有编译 pixelutils 时的标量兜底
+            for (int r = 0; r < 16; ++r) {
+                for (int c = 0; c < 16; ++c)
+                    sum += abs(pa[r * smallStride_ + c] - pb[r * smallStride_ + c]);
+            }
+        }
+    }
+    return sum;
+}
+
+bool SceneDetector::analyze(AVFrame* frame) {
+    if (!frame || !prepare(frame)) {
+        if (frame) ++frameIndex_;
+        return false;
+    }
+
+    downscale(frame, cur_);
+
+    std::vector<int> hist(kHistBins, 0);
+    for (int y = 0; y < smallH_; ++y) {
+        const uint8_t* row = cur_ + (ptrdiff_t)y * smallStride_;
+        for (int x = 0; x < smallW_; ++x) hist[row[x] >> 2]++;
+    }
+
+    bool cut = false;
+    double histDiff = 0.0, meanSad = 0.0;
+    if (!havePrev_) {
+        // 第一帧或输入尺寸 / 格式变化后的第一帧：新场景的开始
+        cut = true;
+    } else {
+        const double pixels = (double)smallW_ * smallH_;
+        meanSad = blockSad(cur_, prev_) / pixels;
+
+        int64_t diff = 0;
+        for (int i = 0; i < kHistBins; ++i) diff += std::abs(hist[i] - histPrev_[i]);
+        histDiff = diff / (2.0 * pixels);
+
+        // 直方图变化大（排除镜头平移），且 SAD 明显高于场景内的平均水平（排除闪光、渐变中的单帧）
+        cut = frameIndex_ - lastCut_ >= minSceneFrames_ &&
+              histDiff >= threshold_ && meanSad >= 2.0 * avgSad_ + 4.0;
+
+        if (!cut) avgSad_ = avgSad_ > 0.0 ? 0.9 * avgSad_ + 0.1 * meanSad : meanSad;
+    }
+
+    if (cut) {
+        SceneCut c;
+        c.frameIndex = frameIndex_;
+        c.pts = frame->best_effort_timestamp != AV_NOPTS_VALUE ? frame->best_effort_timestamp : frame->pts;
+        c.histDiff = histDiff;
+        c.meanSad = meanSad;
+        cuts_.push_back(c);
+        lastCut_ = frameIndex_;
+        avgSad_ = 0.0;
+    }
+
+    if (markFrames_) frame->pict_type = cut ? AV_PICTURE_TYPE_I : AV_PICTURE_TYPE_NONE;
+
+    std::swap(cur_, prev_);
+    histPrev_.swap(hist);
+    havePrev_ = true;
+    ++frameIndex_;
+    return cut;
+}
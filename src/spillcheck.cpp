@@ -0,0 +1,134 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+
+#include "framespillcache.h"
+extern "C" {
+#include <libavutil/frame.h>
+#include <libavutil/pixdesc.h>
+}
+
+// FrameSpillCache 的往返检查：帧写入缓存再按顺序读回，逐像素比较，并比较 pts / duration / pict_type / ROI。
+// memoryBudget = 0 强制全部落盘（FFV1 和原始两种方式），另有一组先进内存、超出后落盘；
+// 中途改变分辨率，FFV1 模式下这些帧走按原始数据写的路径。有不一致时返回 1
+
+static AVFrame* makeFrame(int index, int width, int height) {
+    AVFrame* f = av_frame_alloc();
+    if (!f) return nullptr;
+    f->format = AV_PIX_FMT_YUV420P;
+    f->width = width;
+    f->height = height;
+    if (av_frame_get_buffer(f, 32) < 0) {
+        av_frame_free(&f);
+        return nullptr;
+    }
+    // 渐变加上伪随机噪声，不至于被无损压缩压成几个字节
+    uint32_t s = 0x12345u + index * 977u;
+    for (int p = 0; p < 3; ++p) {
+        int w = p ? width / 2 : width, h = p ? height / 2 : height;
+        for (int y = 0; y < h; ++y) {
+            uint8_t* row = f->data[p] + y * f->linesize[p];
+            for (int x = 0; x < w; ++x) {
+                s ^= s << 13;
+                s ^= s >> 17;
+                s ^= s << 5;
+                row[x] = (uint8_t)(x + y * 2 + index * 5 + p * 40 + (s & 7));
+            }
+        }
+    }
+    f->pts = index * 3;
+    f->pkt_duration = 3;
+    f->pict_type = index % 10 == 0 ? AV_PICTURE_TYPE_I : AV_PICTURE_TYPE_NONE;
+    if (index % 2) {
+        AVFrameSideData* sd = av_frame_new_side_data(f, AV_FRAME_DATA_REGIONS_OF_INTEREST, sizeof(AVRegionOfInterest));
+        if (sd) {
+            AVRegionOfInterest* roi = (AVRegionOfInterest*)sd->data;
+            roi->self_size = sizeof(AVRegionOfInterest);
+            roi->top = index;
+            roi->bottom = height / 2;
+            roi->left = 0;
+            roi->right = width / 2;
+            roi->qoffset = AVRational{-1, 5};
+        }
+    }
+    return f;
+}
+
+static bool sameFrame(const AVFrame* a, const AVFrame* b) {
+    if (a->width != b->width || a->height != b->height || a->format != b->format) return false;
+    if (a->pts != b->pts || a->pkt_duration != b->pkt_duration || a->pict_type != b->pict_type) return false;
+    for (int p = 0; p < 3; ++p) {
+        int w = p ? a->width / 2 : a->width, h = p ? a->height / 2 : a->height;
+        for (int y = 0; y < h; ++y) {
+            if (memcmp(a->data[p] + y * a->linesize[p], b->data[p] + y * b->linesize[p], w)) return false;
+        }
+    }
+    const AVFrameSideData* ra = av_frame_get_side_data(a, AV_FRAME_DATA_REGIONS_OF_INTEREST);
+    const AVFrameSideData* rb = av_frame_get_side_data(b, AV_FRAME_DATA_REGIONS_OF_INTEREST);
+    if (!ra || !rb) return !ra && !rb;
+    return ra->size == rb->size && !memcmp(ra->data, rb->data, ra->size);
+}
+
+// 写入 frameCount 帧（从第 resizeAt 帧起分辨率减半）再读回比较
+static bool roundTrip(const char* name, FrameSpillCache::Mode mode, size_t memoryBudget) {
+    const int frameCount = 30, resizeAt = 20;
+    const std::string path = "spillcheck.tmp";
+
+    FrameSpillCache cache;
+    cache.open(path, memoryBudget, (uint64_t)1 << 30, mode);
+    std::vector<AVFrame*> frames;
+    bool ok = true;
+    for (int i = 0; i < frameCount && ok; ++i) {
+        AVFrame* f = i < resizeAt ? makeFrame(i, 352, 288) : makeFrame(i, 176, 144);
+        if (!f) {
+            ok = false;
+            break;
+        }
+        frames.push_back(f);
+        if (!cache.push(f)) {
+            std::cout << "[spillcheck] " << name << ": push failed at frame " << i << "\n";
+            ok = false;
+        }
+    }
+    if (ok && !cache.rewind()) {
+        std::cout << "[spillcheck] " << name << ": rewind failed\n";
+        ok = false;
+    }
+
+    int matched = 0;
+    for (size_t i = 0; ok && i < frames.size(); ++i) {
+        AVFrame* f = cache.pop();
+        if (!f) {
+            std::cout << "[spillcheck] " << name << ": frame " << i << " missing\n";
+            ok = false;
+            break;
+        }
+        if (sameFrame(frames[i], f)) ++matched;
+        else {
+            std::cout << "[spillcheck] " << name << ": frame " << i << " differs\n";
+            ok = false;
+        }
+        av_frame_free(&f);
+    }
+    if (ok && cache.pop()) {
+        std::cout << "[spillcheck] " << name << ": extra frame after the last one\n";
+        ok = false;
+    }
+
+    std::cout << "[spillcheck] " << name << ": " << (ok ? "ok " : "FAILED ") << matched << "/" << frames.size()
+              << " frames, " << cache.spilledFrames() << " spilled, " << cache.diskBytes() << " bytes on disk\n";
+    cache.close();
+    for (AVFrame* f : frames) av_frame_free(&f);
+    return ok;
+}
+
+int main() {
+    bool ok = true;
+    ok = roundTrip("ffv1, all spilled", FrameSpillCache::SPILL_FFV1, 0) && ok;
+    ok = roundTrip("raw, all spilled", FrameSpillCache::SPILL_RAW, 0) && ok;
+    // 前 5 帧留在内存中
+    ok = roundTrip("ffv1, memory then disk", FrameSpillCache::SPILL_FFV1, 352 * 288 * 3 / 2 * 5) && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,67 @@
+#include "syntheticsource.h"
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <cstring>
+#include <algorithm>
+
+SyntheticSource::SyntheticSource(int width, int height, int fps)
+    : width_(width & ~1), height_(height & ~1), fps_(fps > 0 ? fps : 25) {}
+
+void SyntheticSource::fill(AVFrame* frame, int64_t index) const {
+    // 亮度：斜向渐变，每帧平移 4 个灰阶；一个 64x64 的白块从左到右循环移动
+    for (int y = 0; y < height_; ++y) {
+        uint8_t* row = frame->data[0] + (ptrdiff_t)y * frame->linesize[0];
+        for (int x = 0; x < width_; ++x) row[x] = (uint8_t)(16 + ((x + y + index * 4) % 220));
+    }
+    int box = std::min(64, std::min(width_, height_));
+    int bx = (int)((index * 8) % (width_ - box + 1));
+    int by = (height_ - box) / 2;
+    for (int y = by; y < by + box; ++y)
+        memset(frame->data[0] + (ptrdiff_t)y * frame->linesize[0] + bx, 235, box);
+
+    // 色度：上下两半不同的颜色
+    for (int p = 1; p <= 2; ++p) {
+        for (int y = 0; y < height_ / 2; ++y) {
+            uint8_t v = y < height_ / 4 ? (p == 1 ? 96 : 160) : (p == 1 ? 160 : 96);
+            memset(frame->data[p] + (ptrdiff_t)y * frame->linesize[p], v, width_ / 2);
+        }
+    }
+}
+
+void SyntheticSource::run(int64_t frameCount, std::function<void(AVFrame*)> frameCallback) {
+    using clock = std::chrono::steady_clock;
+    const auto interval = std::chrono::microseconds(1000000 / fps_);
+    const auto start = clock::now();
+    stop_ = false;
+
+    for (int64_t i = 0; !stop_ && (frameCount <= 0 || i < frameCount); ++i) {
+        auto due = start + i * interval;
+        // 回调阻塞到已经晚了一帧以上：这一帧的采集时刻已过，和真实设备一样直接丢掉
+        if (clock::now() > due + interval) {
+            ++dropped_;
+            continue;
+        }
+        std::this_thread::sleep_until(due);
+
+        AVFrame* frame = av_frame_alloc();
+        if (!frame) break;
+        frame->format = AV_PIX_FMT_YUV420P;
+        frame->width = width_;
+        frame->height = height_;
+        if (av_frame_get_buffer(frame, 32) < 0) {
+            std::cerr << "SyntheticSource: failed to allocate frame\n";
+            av_frame_free(&frame);
+            break;
+        }
+        fill(frame, i);
+        frame->pts = i;
+        frame->pkt_duration = 1;
+        frame->sample_aspect_ratio = {1, 1};
+
+        if (probe_) probe_->capture(i);
+        ++produced_;
+        frameCallback(frame);
+        av_frame_free(&frame);
+    }
+}
@@ -6,6 +6,7 @@
 #include "queue.h"
 #include "videodecoder.h"
 #include "audiodecoder.h"
+#include "rawframewriter.h"
 
 extern "C" {
 #include <libavformat/avformat.h>
@@ -57,29 +58,25 @@ int main(int argc, char* argv[]) {
 
     // 5. 启动解码线程
     std::thread audioThread([&]{
-        std::ofstream ofs("audio.pcm", std::ios::binary);
+        RawFrameWriter pcm;
+        if (!pcm.open("audio.pcm")) return;
 
         audioDecoder.decode(audioQueue, [&](const uint8_t* buf, int size){
-            ofs.write((char*)buf, size);
+            pcm.write(buf, size);
         });
+        pcm.close();
 
         std::cout << "Audio decoding finished\n";
     });
 
 
     std::thread videoThread([&]{
-        std::ofstream ofs("video.yuv", std::ios::binary); // 所有视频写入一个文件
+        RawFrameWriter yuv; // 所有视频写入一个文件
+        if (!yuv.open("video.yuv", false, true)) return;
         videoDecoder.decode(videoQueue, [&](AVFrame* frame){
-            // 写 Y plane
-            for (int y = 0; y < frame->height; y++)
-                ofs.write((char*)frame->data[0] + y * frame->linesize[0], frame->width);
-            // 写 U plane
-            for (int y = 0; y < frame->height / 2; y++)
-                ofs.write((char*)frame->data[1] + y * frame->linesize[1], frame->width / 2);
-            // 写 V plane
-            for (int y = 0; y < frame->height / 2; y++)
-                ofs.write((char*)frame->data[2] + y * frame->linesize[2], frame->width / 2);
+            yuv.writeVideo(frame);
             });
+        yuv.close();
         std::cout << "Video decoding finished\n";
     });
 
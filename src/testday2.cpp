@@ -8,6 +8,7 @@
 #include "audiodecoder.h"
 #include "ringbuffer.h"
 #include "videofilter.h"
+#include "rawframewriter.h"
 extern "C" {
 #include <libavformat/avformat.h>
 #include <libavcodec/avcodec.h>
@@ -78,7 +79,8 @@ int main(int argc, char* argv[]) {
 
     VideoFilter vfilter;
     std::thread filterThread([&]{
-        std::ofstream ofs("rotate.yuv", std::ios::binary);
+        RawFrameWriter yuv;
+        if (!yuv.open("rotate.yuv", false, true)) return;
         
           AVFrame* firstFrame = nullptr;
 
@@ -106,15 +108,7 @@ int main(int argc, char* argv[]) {
 
         // 处理第一帧
         vfilter.filterFrame(firstFrame, [&](AVFrame* filtFrame){
-            // 写 Y plane
-            for (int y = 0; y < filtFrame->height; y++)
-                ofs.write((char*)filtFrame->data[0] + y * filtFrame->linesize[0], filtFrame->width);
-            // 写 U plane
-            for (int y = 0; y < filtFrame->height / 2; y++)
-                ofs.write((char*)filtFrame->data[1] + y * filtFrame->linesize[1], filtFrame->width / 2);
-            // 写 V plane
-            for (int y = 0; y < filtFrame->height / 2; y++)
-                ofs.write((char*)filtFrame->data[2] + y * filtFrame->linesize[2], filtFrame->width / 2);
+            yuv.writeVideo(filtFrame);
         });
         av_frame_free(&firstFrame);
         
@@ -122,30 +116,17 @@ int main(int argc, char* argv[]) {
         AVFrame* frame = nullptr;
         while (videoRingBuf.pop(frame)) {
             vfilter.filterFrame(frame, [&](AVFrame* filtFrame){
-                // std::cout << "Filtered frame: width=" << filtFrame->width
-                //     << ", height=" << filtFrame->height
-                //     << ", linesize=" << filtFrame->linesize[0] << "\n";
-                // 写 YUV
-                for (int y = 0; y < filtFrame->height; y++)
-                    ofs.write((char*)filtFrame->data[0] + y * filtFrame->linesize[0], filtFrame->width);
-                for (int y = 0; y < filtFrame->height / 2; y++)
-                    ofs.write((char*)filtFrame->data[1] + y * filtFrame->linesize[1], filtFrame->width / 2);
-                for (int y = 0; y < filtFrame->height / 2; y++)
-                    ofs.write((char*)filtFrame->data[2] + y * filtFrame->linesize[2], filtFrame->width / 2);
+                yuv.writeVideo(filtFrame);
             });
 
             av_frame_free(&frame);
         }
         // flush filter (ensure all internal buffered frames are output)
         vfilter.filterFrame(nullptr, [&](AVFrame* filtFrame){
-            for (int y = 0; y < filtFrame->height; y++)
-                ofs.write((char*)filtFrame->data[0] + y * filtFrame->linesize[0], filtFrame->width);
-            for (int y = 0; y < filtFrame->height / 2; y++)
-                ofs.write((char*)filtFrame->data[1] + y * filtFrame->linesize[1], filtFrame->width / 2);
-            for (int y = 0; y < filtFrame->height / 2; y++)
-                ofs.write((char*)filtFrame->data[2] + y * filtFrame->linesize[2], filtFrame->width / 2);
+            yuv.writeVideo(filtFrame);
         });
 
+        yuv.close();
         std::cout << "Video filtering finished\n";
     });
 
@@ -10,6 +10,7 @@
 #include "videofilter.h"
 #include "videoencoder.h"
 #include "audiofilter.h"
+#include "rawframewriter.h"
 extern "C" {
 #include <libavformat/avformat.h>
 #include <libavcodec/avcodec.h>
@@ -95,17 +96,15 @@ int main(int argc, char* argv[]) {
     }
 
     std::thread audioFilterThread([&]{
-        std::ofstream out("filtered_audio.pcm", std::ios::binary);
-        if (!out) { std::cerr << "Failed to open file\n"; return; }
+        RawFrameWriter out;
+        if (!out.open("filtered_audio.pcm")) { std::cerr << "Failed to open file\n"; return; }
 
         AVFrame* frame = nullptr;
         while (audioRingBuf.pop(frame)) {
             if (!frame) continue;
 
             afilter.filterFrame(frame, [&](AVFrame* f){
-                int sampleSize = av_get_bytes_per_sample((AVSampleFormat)f->format);
-                int dataSize = f->nb_samples * sampleSize * f->channels;
-                out.write((char*)f->data[0], dataSize);
+                out.writeAudio(f);
             });
 
             av_frame_free(&frame);
@@ -113,10 +112,9 @@ int main(int argc, char* argv[]) {
 
         // flush
         afilter.filterFrame(nullptr, [&](AVFrame* f){
-            int sampleSize = av_get_bytes_per_sample((AVSampleFormat)f->format);
-            int dataSize = f->nb_samples * sampleSize * f->channels;
-            out.write((char*)f->data[0], dataSize);
+            out.writeAudio(f);
         });
+        out.close();
 
         std::cout << "[AudioFilterThread] finished\n";
     });
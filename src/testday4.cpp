@@ -10,6 +10,7 @@
 #include "audiofilter.h"
 #include "audioencoder.h"
 #include <cstring>
+#include <cstdlib>
 extern "C" {
 #include <libavformat/avformat.h>
 #include <libavcodec/avcodec.h>
@@ -40,7 +41,8 @@ void saveAC3FromQueue(PacketQueue<AVPacket*>& audioEncoderQueue, const std::stri
 
 int main(int argc, char* argv[]) {
     if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " input.mp4\n";
+        std::cerr << "Usage: " << argv[0] << " input.mp4 [audio_contexts]\n"
+                  << "  audio_contexts: AC3 parallel encoder instances (default 1, serial)\n";
         return -1;
     }
 
@@ -130,6 +132,8 @@ int main(int argc, char* argv[]) {
 
     AudioEncoder audioEncoder;
     int bitrate = 192000; // 可以根据需要调整
+    // 可选：AC3 按批分给多个编码器实例并行（44.1 kHz 输入时编码器自动退回串行）
+    if (argc >= 3) audioEncoder.setParallel(atoi(argv[2]));
     if (!audioEncoder.open(
             audioDecCtx->sample_rate,
             audioDecCtx->channels,
@@ -148,16 +152,7 @@ int main(int argc, char* argv[]) {
             return;
         }
 
-        // 缓冲区，用于保证送入编码器的帧长度正确
-        int frameSize = encCtx->frame_size; // AC3 通常是 1536
-        int channels = encCtx->channels;
-        AVSampleFormat fmt = encCtx->sample_fmt;
-        uint64_t chLayout = encCtx->channel_layout;
-        int sampleRate = encCtx->sample_rate;
-
-        std::vector<float> buffer; // 使用 float，因为我们用 FLTP
-        buffer.reserve(frameSize * channels * 2); // 留够两帧的空间
-
+        // AudioEncoder 内部按 frame_size（AC3 通常是 1536）重新切帧，这里直接送滤镜输出
         AVFrame* frame = nullptr;
         while (audioRingBuf.pop(frame)) {
             if (!frame) continue;
@@ -165,50 +160,8 @@ int main(int argc, char* argv[]) {
             // 先过滤变速
             afilter.filterFrame(frame, [&](AVFrame* f){
                 if (!f) return;
-
-                // 检查格式
-                if (f->format != fmt || f->channels != channels) {
-                    std::cerr << "[AudioEncodeThread] frame format/channel mismatch\n";
-                    return;
-                }
-
-                // 将 planar float 转成 interleaved float buffer
-                for (int i = 0; i < f->nb_samples; i++) {
-                    for (int ch = 0; ch < channels; ch++) {
-                        float* data = (float*)f->data[ch];
-                        buffer.push_back(data[i]);
-                    }
-                }
-
-                // 当缓冲够一帧时送给编码器
-                while ((int)(buffer.size() / channels) >= frameSize) {
-                    AVFrame* encFrame = av_frame_alloc();
-                    encFrame->nb_samples = frameSize;
-                    encFrame->format = fmt;
-                    encFrame->channels = channels;
-                    encFrame->channel_layout = chLayout;
-                    encFrame->sample_rate = sampleRate;
-
-                    if (av_frame_get_buffer(encFrame, 0) < 0) {
-                        std::cerr << "[AudioEncodeThread] failed to alloc encFrame buffer\n";
-                        av_frame_free(&encFrame);
-                        break;
-                    }
-
-                    // 填充 encFrame
-                    for (int i = 0; i < frameSize; i++) {
-                        for (int ch = 0; ch < channels; ch++) {
-                            ((float*)encFrame->data[ch])[i] = buffer[i*channels + ch];
-                        }
-                    }
-
-                    // 移除已送样本
-                    buffer.erase(buffer.begin(), buffer.begin() + frameSize * channels);
-
-                    if (!audioEncoder.encode(encFrame, audioEncoderQueue)) {
-                        std::cerr << "[AudioEncodeThread] AC3 encode failed\n";
-                    }
-                    av_frame_free(&encFrame);
+                if (!audioEncoder.encode(f, audioEncoderQueue)) {
+                    std::cerr << "[AudioEncodeThread] AC3 encode failed\n";
                 }
             });
 
@@ -218,56 +171,10 @@ int main(int argc, char* argv[]) {
         // flush filter
         afilter.filterFrame(nullptr, [&](AVFrame* f){
             if (!f) return;
-
-            // 剩余样本也加入 buffer
-            for (int i = 0; i < f->nb_samples; i++) {
-                for (int ch = 0; ch < channels; ch++) {
-                    float* data = (float*)f->data[ch];
-                    buffer.push_back(data[i]);
-                }
-            }
-            av_frame_free(&f);
-        });
-
-        // 将 buffer 剩余样本填充静音凑一帧送编码器
-        while (!buffer.empty()) {
-            int sendSamples = std::min((int)(buffer.size()/channels), frameSize);
-            AVFrame* encFrame = av_frame_alloc();
-            encFrame->nb_samples = frameSize;
-            encFrame->format = fmt;
-            encFrame->channels = channels;
-            encFrame->channel_layout = chLayout;
-            encFrame->sample_rate = sampleRate;
-
-            if (av_frame_get_buffer(encFrame, 0) < 0) {
-                std::cerr << "[AudioEncodeThread] failed to alloc flush frame\n";
-                av_frame_free(&encFrame);
-                break;
-            }
-
-            // 填充数据
-            for (int i = 0; i < frameSize; i++) {
-                for (int ch = 0; ch < channels; ch++) {
-                    float sample = 0.0f;
-                    if (i < sendSamples) {
-                        sample = buffer[i*channels + ch];
-                    }
-                    ((float*)encFrame->data[ch])[i] = sample;
-                }
-            }
-
-            // 移除已使用样本
-            if ((int)(buffer.size()/channels) > sendSamples) {
-                buffer.erase(buffer.begin(), buffer.begin() + sendSamples*channels);
-            } else {
-                buffer.clear();
-            }
-
-            if (!audioEncoder.encode(encFrame, audioEncoderQueue)) {
+            if (!audioEncoder.encode(f, audioEncoderQueue)) {
                 std::cerr << "[AudioEncodeThread] AC3 flush encode failed\n";
             }
-            av_frame_free(&encFrame);
-        }
+        });
 
         // flush encoder
         audioEncoder.flush(audioEncoderQueue);
@@ -1,6 +1,10 @@
 #include <iostream>
 #include <thread>
 #include <fstream>
+#include <cstdlib>
+#include <chrono>
+#include <algorithm>
+#include <sstream>
 
 #include "demuxer.h"
 #include "queue.h"
@@ -9,60 +13,95 @@
 #include "ringbuffer.h"
 #include "videofilter.h"
 #include "videoencoder.h"
+#include "realtime.h"
+#include "rawframewriter.h"
+#include "pixelconverter.h"
+#include "scenedetector.h"
+#include "framededup.h"
+#include "chunkedencoder.h"
+#include "encodergovernor.h"
+#include "twopassencoder.h"
+#include "roidetector.h"
+#include "motionanalyzer.h"
+#include "audiofilter.h"
+#include "audioencoder.h"
+#include "muxer.h"
 extern "C" {
 #include <libavformat/avformat.h>
 #include <libavcodec/avcodec.h>
 }
 
-void dumpVideoRingBuf(RingBuffer<AVFrame*>& buf, const std::string& filename)
+// 所有帧统一转换成 dumpFmt 写出，源格式中途变化时文件仍然可以按单一格式播放
+void dumpVideoRingBuf(RingBuffer<AVFrame*>& buf, const std::string& filename,
+                      AVPixelFormat dumpFmt = AV_PIX_FMT_YUV420P)
 {
-    std::ofstream ofs(filename, std::ios::binary);
-    if (!ofs) {
+    // 后台线程写盘，编码线程只做拷贝
+    RawFrameWriter writer;
+    if (!writer.open(filename, false, true)) {
         std::cerr << "Failed to open output file: " << filename << "\n";
         return;
     }
 
+    PixelConverter converter;
+    converter.init(0, 0, dumpFmt);
+
     AVFrame* frame = nullptr;
 
     // 直接循环 pop，pop 返回 false 表示缓冲区已停止且空
     while (buf.pop(frame)) {
         if (!frame) continue;
 
-        if (frame->format != AV_PIX_FMT_YUV420P) {
-            std::cerr << "Warning: frame format = " << frame->format 
-                      << ", not YUV420P, skipping\n";
-            av_frame_free(&frame);
-            continue;
+        AVFrame* converted = converter.convert(frame);
+        if (converted) {
+            writer.writeVideo(converted);
+            av_frame_free(&converted);
         }
 
-        int w = frame->width;
-        int h = frame->height;
-
-        // 写 Y
-        for (int i = 0; i < h; ++i)
-            ofs.write(reinterpret_cast<const char*>(frame->data[0] + i * frame->linesize[0]), w);
-        // 写 U
-        for (int i = 0; i < h / 2; ++i)
-            ofs.write(reinterpret_cast<const char*>(frame->data[1] + i * frame->linesize[1]), w / 2);
-        // 写 V
-        for (int i = 0; i < h / 2; ++i)
-            ofs.write(reinterpret_cast<const char*>(frame->data[2] + i * frame->linesize[2]), w / 2);
-
         av_frame_unref(frame);
         av_frame_free(&frame);
     }
 
-    ofs.close();
+    writer.close();
     std::cout << "Dump finished: " << filename << "\n";
 }
 
 int main(int argc, char* argv[]) {
     if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " input.mp4\n";
+        std::cerr << "Usage: " << argv[0] << " input.mp4 [realtime_latency_ms] [logo.png] [chunk_workers] [profile] [fragment_seconds] [features]\n"
+                  << "  profile: default | throughput | latency | archive, e.g. archive:crf=20:preset=slower\n"
+                  << "  fragment_seconds: write fragmented MP4 (CMAF), fragments cut at keyframes, at least this long (0: off)\n"
+                  << "  features: comma-separated, all off by default\n"
+                  << "    dedup     drop near-duplicate decoded frames (lossy, output becomes variable frame rate)\n"
+                  << "    roi       lower QP in moving regions, raise it on static background\n"
+                  << "    scenecut  keyframes at detected scene cuts, GOP up to 250 frames\n"
+                  << "    motion    export decoder motion vectors, report thumbnail candidate and static segments\n";
         return -1;
     }
 
+    // 可选：有损或改变码流结构的处理，默认全部关闭
+    bool useDedup = false, useRoi = false, useSceneCut = false, useMotion = false;
+    if (argc >= 8) {
+        std::stringstream features(argv[7]);
+        std::string f;
+        while (std::getline(features, f, ',')) {
+            if (f == "dedup") useDedup = true;
+            else if (f == "roi") useRoi = true;
+            else if (f == "scenecut") useSceneCut = true;
+            else if (f == "motion") useMotion = true;
+            else if (!f.empty()) {
+                std::cerr << "Unknown feature: " << f << "\n";
+                return -1;
+            }
+        }
+    }
+
     const std::string inputFile = argv[1];
+
+    // 可选：实时模式，超过延迟目标的帧在各阶段被丢弃（0 表示不启用）
+    RealtimeController* realtime = nullptr;
+    if (argc >= 3 && std::atoi(argv[2]) > 0) {
+        realtime = new RealtimeController(std::atoi(argv[2]));
+    }
     //av_log_set_level(AV_LOG_DEBUG);
     avformat_network_init();
 
@@ -77,6 +116,7 @@ int main(int argc, char* argv[]) {
     PacketQueue<AVPacket*> audioQueue;
     PacketQueue<AVPacket*> videoQueue;
     PacketQueue<AVPacket*> videoEncoderQueue;
+    PacketQueue<AVPacket*> audioEncoderQueue;
 
     // 3. 获取 codecpar
     AVCodecParameters* audioCodecPar = nullptr;
@@ -95,16 +135,24 @@ int main(int argc, char* argv[]) {
     }
 
     VideoDecoder videoDecoder(videoCodecPar);
+    // 可选：解码时顺带导出运动矢量，汇总出缩略图候选和静止片段
+    videoDecoder.setExportMotionVectors(useMotion);
     if (!videoDecoder.open()) {
         std::cerr << "Failed to open video decoder\n";
         return -1;
     }
+    videoDecoder.setRealtime(realtime);
 
     RingBuffer<AVFrame*> videoRingBuf(30); 
+    // 可选：录屏、幻灯片里大段相同的帧在解码后直接丢掉，保留帧的 pts 不变（输出为可变帧率）
+    FrameDedup dedup;
+    MotionAnalyzer motionAnalyzer;
     std::thread videoThread([&]{
         videoDecoder.decode(videoQueue, [&](AVFrame* frame){
 
             if (!frame || !frame->data[0]) return;
+            if (useMotion) motionAnalyzer.analyze(frame);
+            if (useDedup && dedup.isDuplicate(frame)) return;
 
             // clone/ref 都可以，这里使用 ref 与音频保持一致
             AVFrame* copy = av_frame_alloc();
@@ -119,6 +167,7 @@ int main(int argc, char* argv[]) {
         });
 
         videoRingBuf.stop();
+        if (useMotion) motionAnalyzer.finish();
         std::cout << "Video decoding finished\n";
     });
 
@@ -128,89 +177,148 @@ int main(int argc, char* argv[]) {
     if (!vfilter.init(videoDecCtx, rotateAngle)) {
         std::cerr << "Failed to init VideoFilter\n";
     }
+    vfilter.setRealtime(realtime);
+    // 可选：右下角水印，离边缘 16 像素
+    if (argc >= 4) vfilter.setWatermark(argv[3], -16, -16);
+
+    // 可选：编码参数 profile
+    EncoderProfile profile = EncoderProfile::defaults();
+    if (argc >= 6 && !EncoderProfile::parse(argv[5], profile)) return -1;
+
+    // 封装在自己的线程里按 dts 交错音视频，编码线程只往队列里放包，不碰文件 I/O
+    Muxer muxer("output.mp4");
+    // 可选：分片输出，每个分片写完即可交给下游（上传等），不必等整个转码结束
+    bool fragmented = argc >= 7 && std::atof(argv[6]) > 0;
+    if (fragmented) {
+        muxer.setFragmented([](const MuxerFragment& f) {
+            std::cout << "[Fragment] #" << f.index << " bytes " << f.offset << "+" << f.size
+                      << " time " << f.startTime << "-" << f.endTime << "s\n";
+        }, std::atof(argv[6]));
+    }
+    // 分片输出先写空 moov，SPS/PPS 必须在 extradata 里
+    bool globalHeader = fragmented && muxer.globalHeader();
 
     VideoEncoder videoEncoder;
-    if (!videoEncoder.open(
-            videoDecCtx->width,
-            videoDecCtx->height,
-            videoDecCtx->time_base, 
-            videoDecCtx->pix_fmt, 
-            videoDecCtx->framerate.num // 假设视频的帧率是 24fps
-        )) {
-        std::cerr << "Failed to open VideoEncoder\n";
-        return -1;
+    videoEncoder.setProfile(profile);
+    videoEncoder.setGlobalHeader(globalHeader);
+    // 可选：关键帧放在场景切换点，场景内 GOP 最长 250 帧
+    videoEncoder.setSceneCutKeyframes(useSceneCut, 250);
+    SceneDetector sceneDetector;
+    // 可选：运动区域降低 QP、静止背景提高 QP（固定机位的画面省码率最明显）
+    videoEncoder.setRoiEncoding(useRoi);
+    MotionRoiDetector roiDetector;
+    // 10bit / 4:2:2 等编码器不支持的格式在送编码器前转换（按横带并行）
+    AVPixelFormat encPixFmt = videoEncoder.pickPixelFormat(videoDecCtx->pix_fmt);
+
+    // 实时模式下按编码速度和解码输出缓冲的堆积情况在 GOP 边界切换 preset（全局头模式下不切换）
+    EncoderGovernor governor(av_q2d(videoDecCtx->framerate), profile.preset);
+    governor.setQueueProbe([&] { return (double)videoRingBuf.size() / videoRingBuf.capacity(); });
+    if (realtime && !globalHeader) videoEncoder.setGovernor(&governor);
+    PixelConverter encConverter;
+    encConverter.init(0, 0, encPixFmt, SWS_BICUBIC, (int)std::thread::hardware_concurrency());
+
+    // 帧的 pts 沿用输入包的时间戳，编码器按包实际的时间基打开（Demuxer 改写过视频流的 time_base）
+    AVRational videoTb = demuxer.getVideoTimeBase();
+
+    // 可选：分段并行编码，N 个编码器同时编码不同的段（每段约 5 秒）
+    int chunkWorkers = argc >= 5 ? std::atoi(argv[4]) : 0;
+    int chunkFrames = 5 * std::max(1, (int)(av_q2d(videoDecCtx->framerate) + 0.5));
+    ChunkedEncoder chunkedEncoder(chunkWorkers, chunkFrames);
+    chunkedEncoder.setProfile(profile);
+    chunkedEncoder.setSceneCutKeyframes(useSceneCut);
+    chunkedEncoder.setRoiEncoding(useRoi);
+    chunkedEncoder.setGlobalHeader(globalHeader);
+    if (chunkWorkers > 1 &&
+        !chunkedEncoder.open(vfilter.outputWidth(), vfilter.outputHeight(), videoTb,
+                             encPixFmt, videoDecCtx->framerate.num)) {
+        std::cerr << "Failed to open ChunkedEncoder, using a single encoder\n";
+        chunkWorkers = 0;
     }
 
-   std::thread videoEncodeThread([&]{
-    AVFrame* frame = nullptr;
-
-    // 创建输出文件上下文
-    AVFormatContext* outputFmtCtx = nullptr;
-    AVOutputFormat* outputFmt = av_guess_format("mp4", nullptr, nullptr);
-    if (!outputFmt) {
-        std::cerr << "Failed to guess output format\n";
-        return;
+    // profile 要求两遍编码时：第一遍的帧缓存在内存（1 GiB）和磁盘（16 GiB）中，第二遍只做编码
+    bool twoPass = profile.passes == 2 && chunkWorkers <= 1;
+    TwoPassEncoder twoPassEncoder("x264_2pass.log", "twopass_spill.yuv", (size_t)1 << 30, (uint64_t)16 << 30);
+    twoPassEncoder.setProfile(profile);
+    twoPassEncoder.setSceneCutKeyframes(useSceneCut, 250);
+    twoPassEncoder.setRoiEncoding(useRoi);
+    twoPassEncoder.setGlobalHeader(globalHeader);
+    if (twoPass &&
+        !twoPassEncoder.open(vfilter.outputWidth(), vfilter.outputHeight(), videoTb,
+                             encPixFmt, videoDecCtx->framerate.num)) {
+        std::cerr << "Failed to open TwoPassEncoder\n";
+        return -1;
     }
 
-    // 为输出文件分配 AVFormatContext
-    if (avformat_alloc_output_context2(&outputFmtCtx, outputFmt, nullptr, "output.mp4") < 0) {
-        std::cerr << "Failed to allocate output context\n";
-        return;
+    // 旋转 90/270 度后宽高互换，按滤镜的输出尺寸打开编码器；
+    // 分段 / 两遍编码时不用这个编码器，不打开（省掉一个 x264 实例的 lookahead 缓冲和线程）
+    if (chunkWorkers <= 1 && !twoPass) {
+        if (!videoEncoder.open(
+                vfilter.outputWidth(),
+                vfilter.outputHeight(),
+                videoTb,
+                encPixFmt,
+                videoDecCtx->framerate.num // 假设视频的帧率是 24fps
+            )) {
+            std::cerr << "Failed to open VideoEncoder\n";
+            return -1;
+        }
+        videoEncoder.setRealtime(realtime);
     }
 
-    // 创建视频流
-    AVStream* outVideoStream = avformat_new_stream(outputFmtCtx, nullptr);
-    if (!outVideoStream) {
-        std::cerr << "Failed to create video stream\n";
-        return;
+    // 音频转成 AAC：滤镜只做格式转换（1 倍速），输出 FLTP
+    AVCodecContext* audioDecCtx = audioDecoder.getCodecContext();
+    AudioFilter afilter;
+    if (!afilter.init(audioDecCtx, 1.0, AV_SAMPLE_FMT_FLTP)) {
+        std::cerr << "Failed to init AudioFilter\n";
+        return -1;
     }
-
-    // 获取 AVCodecParameters 并创建 AVCodecContext
-    AVCodecParameters* codecpar = outVideoStream->codecpar;
-    AVCodecContext* outVideoCodecCtx = avcodec_alloc_context3(nullptr);
-    if (!outVideoCodecCtx) {
-        std::cerr << "Failed to allocate codec context\n";
-        return;
+    AudioEncoder audioEncoder(AV_CODEC_ID_AAC);
+    if (!audioEncoder.open(audioDecCtx->sample_rate, audioDecCtx->channels, AV_SAMPLE_FMT_FLTP, 128000)) {
+        std::cerr << "Failed to open AAC audio encoder\n";
+        return -1;
     }
 
-    // 将 codecpar 参数复制到 codec context
-    if (avcodec_parameters_to_context(outVideoCodecCtx, codecpar) < 0) {
-        std::cerr << "Failed to copy codec parameters to codec context\n";
-        return;
+    int videoStream = chunkWorkers > 1 ? muxer.addStream(chunkedEncoder.codecParameters(), videoTb, videoEncoderQueue)
+                    : twoPass ? muxer.addStream(twoPassEncoder.codecContext(), videoEncoderQueue)
+                              : muxer.addStream(videoEncoder.getCodecContext(), videoEncoderQueue);
+    int audioStream = muxer.addStream(audioEncoder.getCodecContext(), audioEncoderQueue);
+    if (videoStream < 0 || audioStream < 0 || !muxer.start()) {
+        std::cerr << "Failed to start Muxer\n";
+        return -1;
     }
 
-    // 设置编码器参数
-    outVideoCodecCtx->codec_id = outputFmt->video_codec;
-    outVideoCodecCtx->codec_type = AVMEDIA_TYPE_VIDEO;
-    outVideoCodecCtx->width = videoDecCtx->width;
-    outVideoCodecCtx->height = videoDecCtx->height;
-    outVideoCodecCtx->pix_fmt = videoDecCtx->pix_fmt;
-    outVideoCodecCtx->time_base = videoDecCtx->time_base;
-    outVideoCodecCtx->framerate = videoDecCtx->framerate;
-
-    // 查找编码器并打开
-    AVCodec* videoEncoderCodec = avcodec_find_encoder(outVideoCodecCtx->codec_id);
-    if (!videoEncoderCodec || avcodec_open2(outVideoCodecCtx, videoEncoderCodec, nullptr) < 0) {
-        std::cerr << "Failed to open video encoder\n";
-        return;
-    }
+    AVRational audioTb = demuxer.getAudioTimeBase();
+    std::thread audioThread([&]{
+        audioDecoder.decode(audioQueue, [&](AVFrame* frame){
+            if (!frame || !frame->data[0]) return;
+            // 滤镜和编码器的时间基是 1/sample_rate
+            if (frame->pts != AV_NOPTS_VALUE)
+                frame->pts = av_rescale_q(frame->pts, audioTb, AVRational{1, frame->sample_rate});
+            afilter.filterFrame(frame, [&](AVFrame* f){
+                if (f && !audioEncoder.encode(f, audioEncoderQueue))
+                    std::cerr << "[AudioThread] AAC encode failed\n";
+            });
+        });
 
-    // 打开输出文件
-    if (!(outputFmtCtx->flags & AVFMT_NOFILE)) {
-        if (avio_open(&outputFmtCtx->pb, "output.mp4", AVIO_FLAG_WRITE) < 0) {
-            std::cerr << "Failed to open output file\n";
-            return;
-        }
-    }
+        afilter.filterFrame(nullptr, [&](AVFrame* f){
+            if (f && !audioEncoder.encode(f, audioEncoderQueue))
+                std::cerr << "[AudioThread] AAC flush encode failed\n";
+        });
+        audioEncoder.flush(audioEncoderQueue);
+        audioEncoderQueue.stop();
+        std::cout << "[AudioThread] finished\n";
+    });
+
+    // 每个保留帧在滤镜 + 编码上的耗时，用来估算去重节省的时间
+    double downstreamMs = 0.0;
+    int64_t downstreamFrames = 0;
+   std::thread videoEncodeThread([&]{
+    AVFrame* frame = nullptr;
 
-    // 写文件头
-    if (avformat_write_header(outputFmtCtx, nullptr) < 0) {
-        std::cerr << "Failed to write output file header\n";
-        return;
-    }
     // 从视频环形缓冲区中取出帧并编码
     while (videoRingBuf.pop(frame)) {
         if (!frame) continue;
+        auto t0 = std::chrono::steady_clock::now();
 
         // 通过 VideoFilter 对解码后的帧进行处理（如旋转）
         vfilter.filterFrame(frame, [&](AVFrame* filteredFrame) {
@@ -219,32 +327,48 @@ int main(int argc, char* argv[]) {
                 return;
             }
 
-            // 将处理后的帧传给视频编码器进行编码
-            if (!videoEncoder.encode(filteredFrame, videoEncoderQueue)) {
+            // 转成编码器的像素格式后编码（格式相同时只是增加引用）
+            AVFrame* encFrame = encConverter.convert(filteredFrame);
+            if (!encFrame) {
+                std::cerr << "[VideoEncodeThread] pixel format conversion failed\n";
+                return;
+            }
+
+            // 开启 scenecut 时切换帧标记为 I，其余帧交给编码器决定类型
+            if (useSceneCut) sceneDetector.analyze(encFrame);
+            if (useRoi) roiDetector.analyze(encFrame);
+            bool encoded = twoPass ? twoPassEncoder.encode(encFrame)
+                         : chunkWorkers > 1 ? chunkedEncoder.encode(encFrame, videoEncoderQueue)
+                                            : videoEncoder.encode(encFrame, videoEncoderQueue);
+            if (!encoded) {
                 std::cerr << "[VideoEncodeThread] Video encoding failed\n";
             }
+            av_frame_free(&encFrame);
 
             av_frame_unref(filteredFrame); // 释放过滤后的帧
         });
 
         av_frame_free(&frame); // 释放解码帧
+        downstreamMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        ++downstreamFrames;
     }
 
-    // 完成视频编码时，写入所有剩余的数据
-    AVPacket* pkt = nullptr;
-    while ((pkt = videoEncoderQueue.pop())) {
-        if (av_write_frame(outputFmtCtx, pkt) < 0) {
-            std::cerr << "Failed to write frame to output file\n";
-        }
-        av_packet_unref(pkt); // 释放已写入的包
+    if (chunkWorkers > 1) {
+        chunkedEncoder.flush(videoEncoderQueue);
+        chunkedEncoder.printStats();
     }
+    if (twoPass) {
+        if (!twoPassEncoder.finish(videoEncoderQueue))
+            std::cerr << "[VideoEncodeThread] second pass failed\n";
+        twoPassEncoder.printStats();
+    }
+    if (chunkWorkers <= 1 && !twoPass) videoEncoder.flush(videoEncoderQueue);
 
-    // 写文件尾并关闭输出文件
-    av_write_trailer(outputFmtCtx);
-    avio_close(outputFmtCtx->pb);
-    avformat_free_context(outputFmtCtx);
-
-    videoEncoderQueue.stop(); // 停止队列
+    videoEncoderQueue.stop(); // 输出结束，Muxer 写完剩余的包后收尾
+    if (useSceneCut)
+        std::cout << "[VideoEncodeThread] scenes: " << sceneDetector.cuts().size()
+                  << " in " << sceneDetector.frameCount() << " frames\n";
+    if (useRoi) roiDetector.printStats();
     std::cout << "[VideoEncodeThread] finished\n";
 });
 
@@ -286,6 +410,17 @@ int main(int argc, char* argv[]) {
     // 7. 等待线程结束
     videoThread.join();
     videoEncodeThread.join();
+    audioThread.join();
+    if (!muxer.finish()) std::cerr << "Failed to write output.mp4\n";
+    muxer.printStats();
+    if (useDedup) dedup.printStats(downstreamFrames ? downstreamMs / downstreamFrames : 0.0);
+    if (useMotion) motionAnalyzer.printStats(demuxer.getVideoTimeBase());
+
+    if (realtime) {
+        governor.printStats();
+        realtime->printStats();
+        delete realtime;
+    }
     std::cout << "Transcode finished\n";
     return 0;
 }
@@ -0,0 +1,102 @@
+#include "threadpool.h"
+#include <atomic>
+#include <memory>
+#include <algorithm>
+
+ThreadPool::ThreadPool(int threads) {
+    if (threads < 1) threads = 1;
+    for (int i = 0; i < threads; ++i) {
+        workers_.emplace_back([this]{ workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cond_.notify_all();
+    for (auto& t : workers_) {
+        if (t.joinable()) t.join();
+    }
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool((int)std::max(1u, std::thread::hardware_concurrency()));
+    return pool;
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        tasks_.push(std::move(task));
+    }
+    cond_.notify_one();
+}
+
+void ThreadPool::workerLoop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cond_.wait(lock, [this]{ return stop_ || !tasks_.empty(); });
+            if (stop_ && tasks_.empty()) return;
+            task = std::move(tasks_.front());
+            tasks_.pop();
+        }
+        task();
+    }
+}
+
+void ThreadPool::parallelFor(int count, const std::function<void(int)>& fn) {
+    if (count <= 0) return;
+    if (count == 1) { fn(0); return; }
+
+    // 状态用 shared_ptr 持有：任务领完之后才被调度到的辅助任务只会看到 next >= count，直接退出
+    struct State {
+        std::atomic<int> next{0};
+        std::atomic<int> done{0};
+        int count = 0;
+        const std::function<void(int)>* fn = nullptr;
+        std::mutex mutex;
+        std::condition_variable cond;
+    };
+    auto state = std::make_shared<State>();
+    state->count = count;
+    state->fn = &fn;
+
+    auto run = [](State& s) {
+        int i;
+        while ((i = s.next++) < s.count) {
+            (*s.fn)(i);
+            if (++s.done == s.count) {
+                std::lock_guard<std::mutex> lock(s.mutex);
+                s.cond.notify_all();
+            }
+        }
+    };
+
+    int helpers = std::min(count - 1, size());
+    for (int h = 0; h < helpers; ++h) {
+        submit([state, run]{ run(*state); });
+    }
+    run(*state);
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->cond.wait(lock, [&]{ return state->done.load() == count; });
+}
+
+void ThreadPool::runStripes(int height, int stripes, int align, const std::function<void(int, int)>& fn) {
+    if (height <= 0) return;
+    if (align < 1) align = 1;
+
+    int units = (height + align - 1) / align;
+    stripes = std::max(1, std::min(stripes, units));
+    if (stripes == 1) { fn(0, height); return; }
+
+    parallelFor(stripes, [&](int i) {
+        int y0 = (int)((int64_t)units * i / stripes) * align;
+        int y1 = std::min(height, (int)((int64_t)units * (i + 1) / stripes) * align);
+        if (y0 < y1) fn(y0, y1);
+    });
+}
@@ -0,0 +1,236 @@
+#include "timestretch.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+extern "C" {
+#include <libavutil/cpu.h>
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define STRETCH_X86 1
+#endif
+
+// ---------------- 点积内核 ----------------
+
+static float dotC(const float* a, const float* b, int n) {
+    float s = 0.f;
+    for (int i = 0; i < n; ++i) s += a[i] * b[i];
+    return s;
+}
+
+#ifdef STRETCH_X86
+
+__attribute__((target("sse")))
+static float dotSse(const float* a, const float* b, int n) {
+    __m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    float tmp[4];
+    _mm_storeu_ps(tmp, _mm_add_ps(acc0, acc1));
+    float s = tmp[0] + tmp[1] + tmp[2] + tmp[3];
+    for (; i < n; ++i) s += a[i] * b[i];
+    return s;
+}
+
+__attribute__((target("avx2,fma")))
+static float dotAvx2(const float* a, const float* b, int n) {
+    __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), acc1);
+    }
+    __m256 acc = _mm256_add_ps(acc0, acc1);
+    __m128 s4 = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    float tmp[4];
+    _mm_storeu_ps(tmp, s4);
+    float s = tmp[0] + tmp[1] + tmp[2] + tmp[3];
+    for (; i < n; ++i) s += a[i] * b[i];
+    return s;
+}
+
+#endif // STRETCH_X86
+
+typedef float (*DotFn)(const float*, const float*, int);
+
+static DotFn dotKernel() {
+    static const DotFn fn = [] {
+        DotFn f = dotC;
+#ifdef STRETCH_X86
+        int flags = av_get_cpu_flags();
+        if (flags & AV_CPU_FLAG_SSE) f = dotSse;
+        if ((flags & AV_CPU_FLAG_AVX2) && (flags & AV_CPU_FLAG_FMA3)) f = dotAvx2;
+#endif
+        return f;
+    }();
+    return fn;
+}
+
+// ---------------- TimeStretch ----------------
+
+bool TimeStretch::init(int channels, int sampleRate, double speed, int windowMs, int searchMs) {
+    if (channels <= 0 || sampleRate <= 0 || speed <= 0.0) return false;
+
+    channels_ = channels;
+    speed_ = speed;
+    window_ = std::max(64, sampleRate * windowMs / 1000) & ~1;
+    hop_ = window_ / 2;
+    searchRadius_ = std::max(0, sampleRate * searchMs / 1000);
+
+    // 周期 Hann 窗，步长 N/2 时叠加和恒为 1
+    hann_.resize(window_);
+    for (int i = 0; i < window_; ++i)
+        hann_[i] = (float)(0.5 - 0.5 * cos(2.0 * M_PI * i / window_));
+
+    // 开头补 Hs 个静音：片段 k 的中心对齐输入 k*Ha，输出丢掉前 Hs 个只有半个窗的样本
+    in_.assign(channels_, std::vector<float>(hop_, 0.f));
+    mono_.assign(hop_, 0.f);
+    ola_.assign(channels_, std::vector<float>(window_, 0.f));
+    outReady_.assign(channels_, std::vector<float>());
+    outRead_ = 0;
+
+    inBase_ = 0;
+    inTotal_ = 0;
+    segment_ = 0;
+    prevStart_ = -1;
+    produced_ = 0;
+    skip_ = hop_;
+    limit_ = -1;
+    return true;
+}
+
+void TimeStretch::push(const float* const* planes, int nbSamples) {
+    if (channels_ <= 0 || nbSamples <= 0 || limit_ >= 0) return;
+
+    size_t old = mono_.size();
+    mono_.resize(old + nbSamples, 0.f);
+    float scale = 1.f / channels_;
+    for (int ch = 0; ch < channels_; ++ch) {
+        in_[ch].insert(in_[ch].end(), planes[ch], planes[ch] + nbSamples);
+        float* m = mono_.data() + old;
+        for (int i = 0; i < nbSamples; ++i) m[i] += planes[ch][i] * scale;
+    }
+    inTotal_ += nbSamples;
+
+    processSegments();
+}
+
+void TimeStretch::flush() {
+    if (channels_ <= 0 || limit_ >= 0) return;
+
+    limit_ = llround(inTotal_ / speed_);
+
+    // 片段 k 处理完后共输出 k*Hs 个样本，补足最后一个所需片段的搜索范围
+    int64_t lastSegment = (limit_ + hop_ - 1) / hop_;
+    int64_t needEnd = llround(lastSegment * hop_ * speed_) + searchRadius_ + window_;
+    int64_t haveEnd = inBase_ + (int64_t)mono_.size();
+    if (needEnd > haveEnd) {
+        size_t pad = (size_t)(needEnd - haveEnd);
+        for (int ch = 0; ch < channels_; ++ch) in_[ch].resize(in_[ch].size() + pad, 0.f);
+        mono_.resize(mono_.size() + pad, 0.f);
+    }
+
+    processSegments();
+}
+
+int TimeStretch::searchBest(int64_t nominal, int64_t prevStart) {
+    int64_t lo = std::max<int64_t>(nominal - searchRadius_, std::max<int64_t>(inBase_, 0));
+    int64_t hi = nominal + searchRadius_;
+    if (searchRadius_ == 0 || lo >= hi) return (int)(nominal - inBase_);
+
+    // 目标：上一个片段的自然延续（与新片段重叠的那 Hs 个样本）
+    const int len = hop_;
+    const float* target = mono_.data() + (prevStart + hop_ - inBase_);
+    float targetEnergy = dotKernel()(target, target, len);
+    if (targetEnergy < 1e-9f) return (int)(nominal - inBase_);
+
+    DotFn dot = dotKernel();
+    const float* base = mono_.data() - inBase_;
+
+    // 候选窗能量滑动更新，只有互相关需要逐个点积
+    double energy = dot(base + lo, base + lo, len);
+    int64_t best = nominal;
+    double bestScore = -1e30;
+    for (int64_t c = lo; c <= hi; ++c) {
+        double score = dot(base + c, target, len) / sqrt(energy + 1e-9);
+        if (score > bestScore) {
+            bestScore = score;
+            best = c;
+        }
+        double out = base[c];
+        double in = base[c + len];
+        energy += in * in - out * out;
+        if (energy < 0) energy = 0;
+    }
+    return (int)(best - inBase_);
+}
+
+void TimeStretch::processSegments() {
+    while (limit_ < 0 || produced_ < limit_) {
+        int64_t nominal = llround(segment_ * hop_ * speed_);
+        int64_t bufEnd = inBase_ + (int64_t)mono_.size();
+        // 输入不够覆盖搜索范围时等下一批（flush 时已补足静音）
+        if (nominal + searchRadius_ + window_ > bufEnd) break;
+
+        int start = prevStart_ < 0 ? (int)(nominal - inBase_) : searchBest(nominal, prevStart_);
+
+        for (int ch = 0; ch < channels_; ++ch) {
+            const float* s = in_[ch].data() + start;
+            float* acc = ola_[ch].data();
+            for (int i = 0; i < window_; ++i) acc[i] += s[i] * hann_[i];
+        }
+
+        // 前 Hs 个样本不会再有片段叠加，输出
+        int64_t emitFrom = std::min<int64_t>(skip_, hop_);
+        skip_ -= emitFrom;
+        int64_t emit = hop_ - emitFrom;
+        if (limit_ >= 0) emit = std::min<int64_t>(emit, limit_ - produced_);
+        for (int ch = 0; ch < channels_; ++ch) {
+            float* acc = ola_[ch].data();
+            if (emit > 0)
+                outReady_[ch].insert(outReady_[ch].end(), acc + emitFrom, acc + emitFrom + emit);
+            memmove(acc, acc + hop_, (window_ - hop_) * sizeof(float));
+            std::fill(acc + window_ - hop_, acc + window_, 0.f);
+        }
+        if (emit > 0) produced_ += emit;
+
+        prevStart_ = inBase_ + start;
+        ++segment_;
+    }
+    compact();
+}
+
+void TimeStretch::compact() {
+    // 下一个片段最早会用到的位置：上一片段的自然延续，或下一个名义位置减搜索半径
+    int64_t nextNominal = llround(segment_ * hop_ * speed_);
+    int64_t keepFrom = nextNominal - searchRadius_;
+    if (prevStart_ >= 0) keepFrom = std::min(keepFrom, prevStart_ + hop_);
+    int64_t drop = keepFrom - inBase_;
+
+    // 攒够几个窗长再整体前移，摊薄 erase 的开销
+    if (drop > 4 * window_) {
+        drop = std::min<int64_t>(drop, (int64_t)mono_.size());
+        for (int ch = 0; ch < channels_; ++ch) in_[ch].erase(in_[ch].begin(), in_[ch].begin() + drop);
+        mono_.erase(mono_.begin(), mono_.begin() + drop);
+        inBase_ += drop;
+    }
+}
+
+int TimeStretch::read(float* const* planes, int maxSamples) {
+    int n = std::min(maxSamples, available());
+    if (n <= 0) return 0;
+
+    for (int ch = 0; ch < channels_; ++ch)
+        memcpy(planes[ch], outReady_[ch].data() + outRead_, n * sizeof(float));
+    outRead_ += n;
+
+    if (outRead_ == (int)outReady_[0].size()) {
+        for (auto& v : outReady_) v.clear();
+        outRead_ = 0;
+    }
+    return n;
+}
@@ -0,0 +1,116 @@
+#include "twopassencoder.h"
+#include <iostream>
+#include <chrono>
+
+TwoPassEncoder::TwoPassEncoder(const std::string& statsFile, const std::string& spillPath,
+                               size_t memoryBudget, uint64_t diskBudget, FrameSpillCache::Mode spillMode)
+    : statsFile_(statsFile), spillPath_(spillPath), memoryBudget_(memoryBudget),
+      diskBudget_(diskBudget), spillMode_(spillMode) {}
+
+std::unique_ptr<VideoEncoder> TwoPassEncoder::makeEncoder(int pass) {
+    std::unique_ptr<VideoEncoder> enc(new VideoEncoder());
+    enc->setProfile(profile_);
+    enc->setSceneCutKeyframes(sceneCut_, maxGop_);
+    enc->setRoiEncoding(roi_);
+    enc->setGlobalHeader(globalHeader_);
+    enc->setPass(pass, statsFile_);
+    if (!enc->open(width_, height_, timeBase_, pixFmt_, fps_)) {
+        std::cerr << "TwoPassEncoder: failed to open pass " << pass << " encoder\n";
+        return nullptr;
+    }
+    return enc;
+}
+
+static void drain(PacketQueue<AVPacket*>& q) {
+    while (!q.empty()) {
+        AVPacket* pkt = q.pop();
+        av_packet_free(&pkt);
+    }
+}
+
+bool TwoPassEncoder::open(int width, int height, AVRational time_base, AVPixelFormat pix_fmt, int fps) {
+    width_ = width;
+    height_ = height;
+    timeBase_ = time_base;
+    pixFmt_ = pix_fmt;
+    fps_ = fps;
+    failed_ = false;
+    pass1Ms_ = pass2Ms_ = 0.0;
+    pass2Frames_ = 0;
+    spilledFrames_ = 0;
+    spillBytes_ = 0;
+
+    if (profile_.rateControl != EncoderProfile::RC_ABR || profile_.bitrate <= 0)
+        std::cerr << "TwoPassEncoder: profile has no target bitrate, pass 2 will not be bitrate-accurate\n";
+
+    if (!cache_.open(spillPath_, memoryBudget_, diskBudget_, spillMode_)) return false;
+    pass1_ = makeEncoder(1);
+    return pass1_ != nullptr;
+}
+
+bool TwoPassEncoder::encode(AVFrame* frame) {
+    if (!frame || !pass1_ || failed_) return false;
+
+    // 缓存放不下时整个两遍流程失败（第二遍需要完整的帧序列）
+    if (!cache_.push(frame)) {
+        failed_ = true;
+        return false;
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    bool ok = pass1_->encode(frame, discard_);
+    drain(discard_);
+    pass1Ms_ += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    return ok;
+}
+
+bool TwoPassEncoder::finish(PacketQueue<AVPacket*>& pktQueue) {
+    if (!pass1_) return false;
+
+    auto t0 = std::chrono::steady_clock::now();
+    pass1_->flush(discard_);
+    drain(discard_);
+    // 关闭后统计文件才完整
+    pass1_.reset();
+    pass1Ms_ += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+    if (failed_) {
+        std::cerr << "TwoPassEncoder: frame cache incomplete, skipping pass 2\n";
+        cache_.close();
+        return false;
+    }
+    if (!cache_.rewind()) {
+        cache_.close();
+        return false;
+    }
+
+    t0 = std::chrono::steady_clock::now();
+    std::unique_ptr<VideoEncoder> pass2 = makeEncoder(2);
+    bool ok = pass2 != nullptr;
+
+    AVFrame* frame = nullptr;
+    while (ok && (frame = cache_.pop()) != nullptr) {
+        ok = pass2->encode(frame, pktQueue);
+        av_frame_free(&frame);
+        ++pass2Frames_;
+    }
+    if (ok && pass2Frames_ != cache_.frameCount()) {
+        std::cerr << "TwoPassEncoder: only " << pass2Frames_ << " of " << cache_.frameCount()
+                  << " cached frames could be read back\n";
+        ok = false;
+    }
+    if (pass2) pass2->flush(pktQueue);
+    pass2.reset();
+    pass2Ms_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+    spilledFrames_ = cache_.spilledFrames();
+    spillBytes_ = cache_.diskBytes();
+    cache_.close();
+    return ok;
+}
+
+void TwoPassEncoder::printStats() const {
+    std::cout << "[TwoPassEncoder] pass 1 " << pass1Ms_ << " ms, pass 2 " << pass2Ms_ << " ms for "
+              << pass2Frames_ << " frames (cache: " << spilledFrames_ << " spilled, "
+              << spillBytes_ << " bytes on disk)\n";
+}
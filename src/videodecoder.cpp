@@ -1,4 +1,5 @@
 #include "videodecoder.h"
+#include "codecpool.h"
 #include <iostream>
 
 VideoDecoder::VideoDecoder(AVCodecParameters* codecpar)
@@ -6,7 +7,9 @@ VideoDecoder::VideoDecoder(AVCodecParameters* codecpar)
 
 VideoDecoder::~VideoDecoder() {
     if (codecCtx_) {
-        avcodec_free_context(&codecCtx_);
+        // 归还到上下文池，下一个同参数的任务直接复用
+        CodecPool::instance().release(poolKey_, codecCtx_);
+        codecCtx_ = nullptr;
     }
 }
 
@@ -19,12 +22,37 @@ bool VideoDecoder::open() {
         return false;
     }
 
-    codecCtx_ = avcodec_alloc_context3(codec);
-    avcodec_parameters_to_context(codecCtx_, codecpar_);
-    
-    codecCtx_->time_base = (AVRational){1, 24};
+    // 优先从池中取同参数、已打开的解码器
+    poolKey_ = CodecPool::decoderKey(codecpar_);
+    if (exportMvs_) poolKey_ += ":mvs";
+    if (lowDelay_) poolKey_ += ":lowdelay";
+    codecCtx_ = CodecPool::instance().acquire(poolKey_, [&]() -> AVCodecContext* {
+        AVCodecContext* ctx = avcodec_alloc_context3(codec);
+        if (!ctx) return nullptr;
+        avcodec_parameters_to_context(ctx, codecpar_);
 
-    if (avcodec_open2(codecCtx_, codec, nullptr) < 0) {
+        ctx->time_base = (AVRational){1, 24};
+
+        if (lowDelay_) {
+            // 帧级线程会让输出晚 thread_count - 1 帧
+            ctx->flags |= AV_CODEC_FLAG_LOW_DELAY;
+            ctx->thread_type = FF_THREAD_SLICE;
+        }
+
+        // 运动矢量在正常解码过程中顺带导出，几乎没有额外开销
+        AVDictionary* opts = nullptr;
+        if (exportMvs_) av_dict_set(&opts, "flags2", "+export_mvs", 0);
+
+        int ret = avcodec_open2(ctx, codec, &opts);
+        av_dict_free(&opts);
+        if (ret < 0) {
+            avcodec_free_context(&ctx);
+            return nullptr;
+        }
+        return ctx;
+    });
+
+    if (!codecCtx_) {
         std::cerr << "Failed to open video codec\n";
         return false;
     }
@@ -56,11 +84,24 @@ void VideoDecoder::decode(PacketQueue<AVPacket*>& videoQueue,
                 std::cout << "  pix_fmt= " << frame->format << "\n";
                 printed = true;
             }*/
+
+            if (realtime_) {
+                realtime_->stamp(frame, codecCtx_->time_base);
+                if (realtime_->shouldDrop(frame, RealtimeController::STAGE_DECODE)) {
+                    av_frame_unref(frame);
+                    continue;
+                }
+            }
             
             frameCallback(frame);
             av_frame_unref(frame);
         }
 
+        // 落后时让解码器直接跳过非参考帧，追上后恢复
+        if (realtime_) {
+            codecCtx_->skip_frame = realtime_->behind() ? AVDISCARD_NONREF : AVDISCARD_DEFAULT;
+        }
+
         av_packet_free(&pkt);
     }
 
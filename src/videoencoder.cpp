@@ -1,54 +1,231 @@
 #include "videoencoder.h"
+#include "codecpool.h"
+#include "threadpool.h"
 #include <iostream>
+#include <sstream>
+#include <chrono>
+#include <cstring>
+#include <algorithm>
 
-VideoEncoder::VideoEncoder(AVCodecID codec_id): codec_(avcodec_find_encoder_by_name("libx264")) {
-    //codec_ = avcodec_find_encoder(codec_id);
+VideoEncoder::VideoEncoder(AVCodecID codec_id) {
+    if (codec_id == AV_CODEC_ID_H264) codec_ = avcodec_find_encoder_by_name("libx264");
+    if (!codec_) codec_ = avcodec_find_encoder(codec_id);
     if (!codec_) {
         std::cerr << "VideoEncoder: codec not found\n";
     }
+    preset_ = profile_.preset;
+}
+
+void VideoEncoder::setProfile(const EncoderProfile& profile) {
+    profile_ = profile;
+    preset_ = profile.preset;
+    if (!profile.codec.empty()) {
+        AVCodec* c = avcodec_find_encoder_by_name(profile.codec.c_str());
+        if (c && c->type == AVMEDIA_TYPE_VIDEO) codec_ = c;
+        else std::cerr << "VideoEncoder: encoder " << profile.codec << " not found, keeping "
+                       << (codec_ ? codec_->name : "none") << "\n";
+    }
 }
 VideoEncoder::~VideoEncoder() {
+    waitPrewarm();
     close();
 }
 
-bool VideoEncoder::open(int width, int height, AVRational time_base, AVPixelFormat pix_fmt, int fps) {
-    if (!codec_) return false;
+std::string VideoEncoder::makePoolKey(int width, int height, AVRational time_base,
+                                      AVPixelFormat pix_fmt, int fps, const std::string& preset) const {
+    std::ostringstream ss;
+    ss << "venc:" << codec_->name << ":" << width << "x" << height
+       << ":" << pix_fmt << ":" << time_base.num << "/" << time_base.den
+       << ":" << fps;
+    if (sceneCut_) ss << ":sc" << maxGop_;
+    if (roi_) ss << ":roi";
+    if (globalHeader_) ss << ":gh";
+    ss << ":" << preset << ":" << profile_.key();
+    if (pass_) ss << ":pass" << pass_ << ":" << statsFile_;
+    return ss.str();
+}
 
-    codecCtx_ = avcodec_alloc_context3(codec_);
-    if (!codecCtx_) return false;
+AVCodecContext* VideoEncoder::createContext(int width, int height, AVRational time_base,
+                                            AVPixelFormat pix_fmt, int fps, const std::string& preset) {
+    AVCodecContext* ctx = avcodec_alloc_context3(codec_);
+    if (!ctx) return nullptr;
 
-    codecCtx_->width = width;
-    codecCtx_->height = height;
-    codecCtx_->time_base = time_base;
-    codecCtx_->framerate = {fps, 1};
+    ctx->width = width;
+    ctx->height = height;
+    ctx->time_base = time_base;
+    ctx->framerate = {fps, 1};
 
-    codecCtx_->pix_fmt = pix_fmt;
+    ctx->pix_fmt = pix_fmt;
+    if (globalHeader_) ctx->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
 
-    codecCtx_->gop_size = 12;
-    codecCtx_->max_b_frames = 2;
+    // profile 之外单独指定的 preset（setPreset / 速度调节）优先
+    EncoderProfile p = profile_;
+    p.preset = preset;
+    p.applyTo(ctx);
 
-    if (codec_->id == AV_CODEC_ID_H264) {
-        av_opt_set(codecCtx_->priv_data, "preset", "fast", 0);
+    if (pass_ == 1 || pass_ == 2) {
+        ctx->flags |= pass_ == 1 ? AV_CODEC_FLAG_PASS1 : AV_CODEC_FLAG_PASS2;
+        if (av_opt_set(ctx, "stats", statsFile_.c_str(), AV_OPT_SEARCH_CHILDREN) < 0)
+            std::cerr << "VideoEncoder: " << codec_->name << " has no stats file option\n";
+    }
+
+    if (sceneCut_) {
+        // profile 显式给出的 GOP 更短时以 profile 为准（场景切换之外仍按它插入关键帧）
+        ctx->gop_size = std::min(ctx->gop_size > 0 ? ctx->gop_size : maxGop_, maxGop_);
+        // 切换点由调用方通过 pict_type 指定，编码器自己不再插入 I 帧
+        av_opt_set(ctx, "sc_threshold", "0", AV_OPT_SEARCH_CHILDREN);
+        av_opt_set(ctx->priv_data, "forced-idr", "1", 0);
+    }
+
+    int64_t aqMode = -1;
+    if (roi_ && av_opt_get_int(ctx->priv_data, "aq-mode", 0, &aqMode) >= 0 && aqMode == 0) {
+        // aq-mode=0 时 libx264 忽略 ROI，改回默认的方差 AQ
+        std::cerr << "VideoEncoder: ROI encoding needs adaptive quantization, enabling aq-mode=1\n";
+        av_opt_set_int(ctx->priv_data, "aq-mode", 1, 0);
     }
     
-    int ret = avcodec_open2(codecCtx_, codec_, nullptr);
+    int ret = avcodec_open2(ctx, codec_, nullptr);
     if (ret < 0) {
+        avcodec_free_context(&ctx);
+        return nullptr;
+    }
+    return ctx;
+}
+
+AVPixelFormat VideoEncoder::pickPixelFormat(AVPixelFormat src) const {
+    if (!codec_ || !codec_->pix_fmts) return src;
+    for (const AVPixelFormat* p = codec_->pix_fmts; *p != AV_PIX_FMT_NONE; ++p) {
+        if (*p == src) return src;
+    }
+    return avcodec_find_best_pix_fmt_of_list(codec_->pix_fmts, src, 0, nullptr);
+}
+
+bool VideoEncoder::open(int width, int height, AVRational time_base, AVPixelFormat pix_fmt, int fps) {
+    if (!codec_) return false;
+
+    waitPrewarm();
+    close();
+
+    if (roi_ && strcmp(codec_->name, "libx264") && strcmp(codec_->name, "libx265") &&
+        strcmp(codec_->name, "libvpx-vp9") && strcmp(codec_->name, "h264_qsv") && strcmp(codec_->name, "hevc_qsv"))
+        std::cerr << "VideoEncoder: " << codec_->name << " ignores regions of interest\n";
+
+    width_ = width;
+    height_ = height;
+    timeBase_ = time_base;
+    pixFmt_ = pix_fmt;
+    fps_ = fps;
+    frameIndex_ = 0;
+    framesInGop_ = 0;
+
+    if (governor_ && globalHeader_) {
+        std::cerr << "VideoEncoder: preset switching disabled, the global header cannot change mid-stream\n";
+        governor_ = nullptr;
+    }
+    if (governor_) {
+        preset_ = governor_->preset();
+        // 相邻两档先打开放进池里，切换时不用等 x264 初始化；还没开始编码，直接在这里打开
+        prewarmNeighbours(false);
+    }
+
+    return acquireContext(preset_);
+}
+
+bool VideoEncoder::acquireContext(const std::string& preset) {
+    poolKey_ = makePoolKey(width_, height_, timeBase_, pixFmt_, fps_, preset);
+    codecCtx_ = CodecPool::instance().acquire(poolKey_, [&]() {
+        return createContext(width_, height_, timeBase_, pixFmt_, fps_, preset);
+    });
+    if (!codecCtx_) {
         std::cerr << "Failed to open encoder: \n";
         return false;
     }
+    return true;
+}
+
+void VideoEncoder::switchPreset(const std::string& preset, PacketQueue<AVPacket*>& pktQueue) {
+    // 当前 GOP 的包全部输出后再换实例，新实例的第一帧就是 IDR
+    flush(pktQueue);
+    close();
+    preset_ = preset;
+    acquireContext(preset_);
+    // 下一次切换的目标在后台准备好
+    prewarmNeighbours(true);
+}
+
+void VideoEncoder::prewarmNeighbours(bool async) {
+    for (const std::string& p : {governor_->fasterPreset(), governor_->slowerPreset()}) {
+        if (p.empty()) continue;
+        std::string key = makePoolKey(width_, height_, timeBase_, pixFmt_, fps_, p);
+        if (!async) {
+            CodecPool::instance().ensureIdle(key, [&]() {
+                return createContext(width_, height_, timeBase_, pixFmt_, fps_, p);
+            }, 1);
+            continue;
+        }
+        {
+            std::lock_guard<std::mutex> lock(prewarmMutex_);
+            ++prewarmPending_;
+        }
+        ThreadPool::shared().submit([this, key, p]() {
+            CodecPool::instance().ensureIdle(key, [&]() {
+                return createContext(width_, height_, timeBase_, pixFmt_, fps_, p);
+            }, 1);
+            std::lock_guard<std::mutex> lock(prewarmMutex_);
+            if (--prewarmPending_ == 0) prewarmCond_.notify_all();
+        });
+    }
+}
+
+void VideoEncoder::waitPrewarm() {
+    std::unique_lock<std::mutex> lock(prewarmMutex_);
+    prewarmCond_.wait(lock, [this] { return prewarmPending_ == 0; });
+}
+
+bool VideoEncoder::prewarm(int width, int height, AVRational time_base, AVPixelFormat pix_fmt,
+                           int fps, int count) {
+    if (!codec_) return false;
 
+    CodecPool::instance().prewarm(makePoolKey(width, height, time_base, pix_fmt, fps, preset_), [&]() {
+        return createContext(width, height, time_base, pix_fmt, fps, preset_);
+    }, count);
     return true;
 }
 
 void VideoEncoder::close() {
     if (codecCtx_) {
-        avcodec_free_context(&codecCtx_);
+        // 两遍编码的实例直接释放（x264 在关闭时写完统计文件）；
+        // 其余支持 ENCODER_FLUSH 的编码器放回池中，不支持的由池释放
+        if (pass_) avcodec_free_context(&codecCtx_);
+        else CodecPool::instance().release(poolKey_, codecCtx_);
+        codecCtx_ = nullptr;
     }
 }
 
 bool VideoEncoder::encode(AVFrame* frame, PacketQueue<AVPacket*>& pktQueue) {
     if (!codecCtx_ || !frame) return false;
 
+    if (realtime_ && realtime_->shouldDrop(frame, RealtimeController::STAGE_ENCODE))
+        return true;
+
+    if (!roi_) av_frame_remove_side_data(frame, AV_FRAME_DATA_REGIONS_OF_INTEREST);
+
+    if (governor_) {
+        // GOP 边界：固定 GOP 长度到了，或调用方标记的切换点
+        bool boundary = framesInGop_ >= codecCtx_->gop_size ||
+                        (framesInGop_ > 0 && frame->pict_type == AV_PICTURE_TYPE_I);
+        if (boundary) {
+            framesInGop_ = 0;
+            const std::string& next = governor_->decide(frameIndex_);
+            if (next != preset_) {
+                switchPreset(next, pktQueue);
+                if (!codecCtx_) return false;
+                frame->pict_type = AV_PICTURE_TYPE_I;
+            }
+        }
+    }
+    auto t0 = std::chrono::steady_clock::now();
+
     int ret = avcodec_send_frame(codecCtx_, frame);
     if (ret < 0) {
         std::cerr << "VideoEncoder: send_frame failed\n";
@@ -61,6 +238,11 @@ bool VideoEncoder::encode(AVFrame* frame, PacketQueue<AVPacket*>& pktQueue) {
         pkt = av_packet_alloc();
     }
     av_packet_free(&pkt);
+
+    ++frameIndex_;
+    ++framesInGop_;
+    if (governor_)
+        governor_->addSample(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count());
     return true;
 }
 
@@ -1,44 +1,117 @@
 #include "videofilter.h"
+#include "rotate.h"
+#include "threadpool.h"
 #include <iostream>
+#include <string>
+#include <atomic>
+extern "C" {
+#include <libavutil/pixdesc.h>
+}
 
 VideoFilter::VideoFilter() {}
 VideoFilter::~VideoFilter() {
-    if (filterGraph_) {
-        avfilter_graph_free(&filterGraph_);
+    for (auto& kv : graphCache_) {
+        avfilter_graph_free(&kv.second.graph);
     }
+    graphCache_.clear();
+    filterGraph_ = nullptr;
 }
 
 bool VideoFilter::init(AVCodecContext* decCtx, int angle) {
-    rotateAngle_ = angle;
-    return initFilterGraph(decCtx, angle);
-}
-
-bool VideoFilter::initFilterGraph(AVCodecContext* decCtx, int angle) {
     if (!decCtx || decCtx->width <=0 || decCtx->height <=0) {
         std::cerr << "Invalid codec context: width/height not set\n";
         return false;
     }
 
-    AVRational tb = decCtx->time_base;
-    if (tb.num <=0 || tb.den <=0) tb = {1,25}; // 默认25fps
+    rotateAngle_ = ((angle % 360) + 360) % 360;
+
+    timeBase_ = decCtx->time_base;
+    if (timeBase_.num <=0 || timeBase_.den <=0) timeBase_ = {1,25}; // 默认25fps
+
+    return reconfigure(decCtx->width, decCtx->height, decCtx->pix_fmt, decCtx->sample_aspect_ratio);
+}
+
+bool VideoFilter::setWatermark(const std::string& logoPath, int x, int y) {
+    std::unique_ptr<OverlayCompositor> wm(new OverlayCompositor());
+    if (!wm->init(logoPath, x, y)) return false;
+    watermark_ = std::move(wm);
+    return true;
+}
 
-    AVRational sar = decCtx->sample_aspect_ratio;
+bool VideoFilter::reconfigure(int width, int height, int format, AVRational sar) {
     if (sar.num <=0 || sar.den <=0) sar = {1,1};
 
+    inWidth_ = width;
+    inHeight_ = height;
+    inFormat_ = format;
+    inSar_ = sar;
+
+    // 输出配置已确定时，直接旋转只有在结果与之一致时才能用，否则走带缩放的滤镜图
+    bool locked = outFormat_ != AV_PIX_FMT_NONE;
+    if (rotateSupported((AVPixelFormat)format, rotateAngle_)) {
+        int w = 0, h = 0;
+        rotatedSize(width, height, rotateAngle_, &w, &h);
+        if (!locked || (w == outWidth_ && h == outHeight_ && format == outFormat_)) {
+            directRotate_ = true;
+            outWidth_ = w;
+            outHeight_ = h;
+            outFormat_ = format;
+            return true;
+        }
+    }
+
+    // 每种输入配置一张滤镜图，切回已见过的配置时直接复用
+    char key[128];
+    snprintf(key, sizeof(key), "%dx%d:%d:%d/%d", width, height, format, sar.num, sar.den);
+
+    auto it = graphCache_.find(key);
+    if (it == graphCache_.end()) {
+        GraphInstance g;
+        if (!initFilterGraph(width, height, (AVPixelFormat)format, sar, g)) {
+            avfilter_graph_free(&g.graph);
+            return false;
+        }
+        it = graphCache_.emplace(key, g).first;
+    }
+
+    directRotate_ = false;
+    filterGraph_ = it->second.graph;
+    buffersrcCtx_ = it->second.src;
+    buffersinkCtx_ = it->second.sink;
+
+    if (!locked) {
+        outWidth_ = av_buffersink_get_w(buffersinkCtx_);
+        outHeight_ = av_buffersink_get_h(buffersinkCtx_);
+        outFormat_ = av_buffersink_get_format(buffersinkCtx_);
+    }
+    return true;
+}
+
+bool VideoFilter::initFilterGraph(int width, int height, AVPixelFormat pix_fmt, AVRational sar,
+                                  GraphInstance& g) {
+    int angle = rotateAngle_;
+    AVRational tb = timeBase_;
+
     char args[512];
     snprintf(args, sizeof(args),
              "video_size=%dx%d:pix_fmt=%d:time_base=%d/%d:pixel_aspect=%d/%d",
-             decCtx->width, decCtx->height, decCtx->pix_fmt,
+             width, height, pix_fmt,
              tb.num, tb.den,
              sar.num, sar.den);
 
     const AVFilter* buffersrc  = avfilter_get_by_name("buffer");
     const AVFilter* buffersink = avfilter_get_by_name("buffersink");
-    filterGraph_ = avfilter_graph_alloc();
-    if (!filterGraph_) return false;
+    g.graph = avfilter_graph_alloc();
+    if (!g.graph) return false;
 
-    int ret = avfilter_graph_create_filter(&buffersrcCtx_, buffersrc, "src",
-                                           args, nullptr, filterGraph_);
+    // 必须在创建滤镜之前设置，之后创建的滤镜才会使用 slice 线程
+    if (threads_ > 1) {
+        g.graph->nb_threads = threads_;
+        g.graph->thread_type = AVFILTER_THREAD_SLICE;
+    }
+
+    int ret = avfilter_graph_create_filter(&g.src, buffersrc, "src",
+                                           args, nullptr, g.graph);
     if (ret < 0) {
         char errbuf[128];
         av_strerror(ret, errbuf, sizeof(errbuf));
@@ -46,8 +119,8 @@ bool VideoFilter::initFilterGraph(AVCodecContext* decCtx, int angle) {
         return false;
     }
 
-    ret = avfilter_graph_create_filter(&buffersinkCtx_, buffersink, "sink",
-                                       nullptr, nullptr, filterGraph_);
+    ret = avfilter_graph_create_filter(&g.sink, buffersink, "sink",
+                                       nullptr, nullptr, g.graph);
     if (ret < 0) {
         char errbuf[128];
         av_strerror(ret, errbuf, sizeof(errbuf));
@@ -55,36 +128,57 @@ bool VideoFilter::initFilterGraph(AVCodecContext* decCtx, int angle) {
         return false;
     }
 
-    // rotate filter
-    const AVFilter* rotateFilter = avfilter_get_by_name("rotate");
-    AVFilterContext* rotateCtx = nullptr;
-
-    double rad = 0.0;
-    switch(angle) {
-        case 90:  rad = M_PI/2; break;
-        case 180: rad = M_PI; break;
-        case 270: rad = M_PI*3/2; break;
-        default:  rad = 0.0; break;
+    // 直角旋转用精确的转置/翻转滤镜（输出宽高正确互换），任意角度才用插值的 rotate
+    std::string filterDesc;
+    switch (angle) {
+        case 0:   filterDesc = "null"; break;
+        case 90:  filterDesc = "transpose=clock"; break;
+        case 180: filterDesc = "hflip,vflip"; break;
+        case 270: filterDesc = "transpose=cclock"; break;
+        default: {
+            char rotateArg[64];
+            snprintf(rotateArg, sizeof(rotateArg), "rotate=angle=%f", angle * M_PI / 180.0);
+            filterDesc = rotateArg;
+            break;
+        }
     }
 
-    char rotateArg[64];
-    snprintf(rotateArg, sizeof(rotateArg), "angle=%f", rad);
+    // 输入中途变化时缩放 / 转换回 init 时的输出配置，编码器按原尺寸继续编码
+    if (outFormat_ != AV_PIX_FMT_NONE) {
+        const char* fmtName = av_get_pix_fmt_name((AVPixelFormat)outFormat_);
+        char tail[128];
+        snprintf(tail, sizeof(tail), ",scale=%d:%d,format=%s", outWidth_, outHeight_, fmtName ? fmtName : "yuv420p");
+        filterDesc += tail;
+    }
 
-    ret = avfilter_graph_create_filter(&rotateCtx, rotateFilter, "rotate",
-                                       rotateArg, nullptr, filterGraph_);
-    if (ret < 0) {
-        char errbuf[128]; av_strerror(ret, errbuf, sizeof(errbuf));
-        std::cerr << "Failed to create rotate filter: " << errbuf << "\n";
+    AVFilterInOut* outputs = avfilter_inout_alloc();
+    AVFilterInOut* inputs  = avfilter_inout_alloc();
+    if (!outputs || !inputs) {
+        avfilter_inout_free(&outputs);
+        avfilter_inout_free(&inputs);
         return false;
     }
 
-    if ((ret = avfilter_link(buffersrcCtx_,0,rotateCtx,0)) < 0 ||
-        (ret = avfilter_link(rotateCtx,0,buffersinkCtx_,0)) < 0) {
-        std::cerr << "Failed to link filters\n";
+    outputs->name       = av_strdup("in");
+    outputs->filter_ctx = g.src;
+    outputs->pad_idx    = 0;
+    outputs->next       = nullptr;
+
+    inputs->name        = av_strdup("out");
+    inputs->filter_ctx  = g.sink;
+    inputs->pad_idx     = 0;
+    inputs->next        = nullptr;
+
+    ret = avfilter_graph_parse_ptr(g.graph, filterDesc.c_str(), &inputs, &outputs, nullptr);
+    avfilter_inout_free(&inputs);
+    avfilter_inout_free(&outputs);
+    if (ret < 0) {
+        char errbuf[128]; av_strerror(ret, errbuf, sizeof(errbuf));
+        std::cerr << "Failed to parse filter graph: " << errbuf << "\n";
         return false;
     }
 
-    if ((ret = avfilter_graph_config(filterGraph_, nullptr)) <0) {
+    if ((ret = avfilter_graph_config(g.graph, nullptr)) <0) {
         char errbuf[128]; av_strerror(ret, errbuf, sizeof(errbuf));
         std::cerr << "Failed to configure filter graph: " << errbuf << "\n";
         return false;
@@ -96,6 +190,34 @@ bool VideoFilter::initFilterGraph(AVCodecContext* decCtx, int angle) {
 
 void VideoFilter::filterFrame(AVFrame* frame,
                               std::function<void(AVFrame*)> callback) {
+    if (realtime_ && frame && realtime_->shouldDrop(frame, RealtimeController::STAGE_FILTER))
+        return;
+
+    if (watermark_) {
+        // 两条处理路径的输出都先叠加水印再交给调用方
+        std::function<void(AVFrame*)> deliver = std::move(callback);
+        callback = [this, deliver](AVFrame* out) {
+            watermark_->apply(out);
+            deliver(out);
+        };
+    }
+
+    // 输入分辨率/像素格式/SAR 中途变化（插播广告、自适应码流等）时切换到对应配置的处理路径
+    if (frame && inputChanged(frame)) {
+        std::cout << "[VideoFilter] input changed to " << frame->width << "x" << frame->height
+                  << " fmt " << frame->format << ", reconfiguring\n";
+        if (!reconfigure(frame->width, frame->height, frame->format, frame->sample_aspect_ratio)) {
+            std::cerr << "VideoFilter: failed to reconfigure for new input\n";
+            return;
+        }
+    }
+
+    if (directRotate_) {
+        if (!frame) return;  // 直接旋转没有缓存帧，flush 无事可做
+        filterDirect(frame, callback);
+        return;
+    }
+
     if (!filterGraph_) return;
 
     int ret = av_buffersrc_add_frame(buffersrcCtx_, frame);
@@ -110,3 +232,58 @@ void VideoFilter::filterFrame(AVFrame* frame,
 
     av_frame_free(&filtFrame);
 }
+
+bool VideoFilter::inputChanged(const AVFrame* frame) const {
+    AVRational sar = frame->sample_aspect_ratio;
+    if (sar.num <=0 || sar.den <=0) sar = {1,1};
+    return frame->width != inWidth_ || frame->height != inHeight_ ||
+           frame->format != inFormat_ || av_cmp_q(sar, inSar_) != 0;
+}
+
+void VideoFilter::filterDirect(AVFrame* frame, const std::function<void(AVFrame*)>& callback) {
+    AVFrame* out = av_frame_alloc();
+    if (!out) return;
+
+    if (rotateAngle_ == 0) {
+        // 0 度只增加一个引用，不拷贝像素
+        if (av_frame_ref(out, frame) == 0) callback(out);
+        av_frame_free(&out);
+        return;
+    }
+
+    out->format = frame->format;
+    rotatedSize(frame->width, frame->height, rotateAngle_, &out->width, &out->height);
+    if (av_frame_get_buffer(out, 0) < 0 || av_frame_copy_props(out, frame) < 0) {
+        std::cerr << "VideoFilter: failed to allocate rotated frame\n";
+        av_frame_free(&out);
+        return;
+    }
+
+    bool ok = true;
+    if (threads_ > 1) {
+        // 按输出行切成横带，横带边界按色度垂直采样对齐
+        const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get((AVPixelFormat)frame->format);
+        int align = desc ? 1 << desc->log2_chroma_h : 1;
+        std::atomic<bool> stripeOk(true);
+        ThreadPool::shared().runStripes(out->height, threads_, align, [&](int y0, int y1) {
+            if (!rotateFrame(frame, out, rotateAngle_, y0, y1)) stripeOk = false;
+        });
+        ok = stripeOk;
+    } else {
+        ok = rotateFrame(frame, out, rotateAngle_);
+    }
+
+    if (!ok) {
+        std::cerr << "VideoFilter: unsupported frame for rotation, format = " << frame->format << "\n";
+        av_frame_free(&out);
+        return;
+    }
+
+    if (rotateAngle_ != 180 && frame->sample_aspect_ratio.num > 0 && frame->sample_aspect_ratio.den > 0) {
+        out->sample_aspect_ratio = av_make_q(frame->sample_aspect_ratio.den,
+                                             frame->sample_aspect_ratio.num);
+    }
+
+    callback(out);
+    av_frame_free(&out);
+}